@@ -0,0 +1,120 @@
+#pragma once
+
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace livision {
+/**
+ * @brief Axis-aligned bounding box.
+ *
+ * Default-constructed bounds are empty. Infinite bounds are used for objects
+ * whose extent is unknown and must never be culled.
+ */
+struct Bounds {
+  Eigen::Vector3d min =
+      Eigen::Vector3d::Constant(std::numeric_limits<double>::infinity());
+  Eigen::Vector3d max =
+      Eigen::Vector3d::Constant(-std::numeric_limits<double>::infinity());
+
+  /**
+   * @brief Empty bounds (contains nothing).
+   */
+  static Bounds Empty() { return {}; }
+
+  /**
+   * @brief Infinite bounds (contains everything).
+   */
+  static Bounds Infinite() {
+    Bounds b;
+    b.min = Eigen::Vector3d::Constant(-std::numeric_limits<double>::infinity());
+    b.max = Eigen::Vector3d::Constant(std::numeric_limits<double>::infinity());
+    return b;
+  }
+
+  /**
+   * @brief Bounds from min/max corners.
+   */
+  static Bounds FromMinMax(const Eigen::Vector3d& min,
+                           const Eigen::Vector3d& max) {
+    Bounds b;
+    b.min = min;
+    b.max = max;
+    return b;
+  }
+
+  /**
+   * @brief Whether the bounds contain nothing.
+   */
+  bool IsEmpty() const { return (min.array() > max.array()).any(); }
+
+  /**
+   * @brief Whether the bounds are unbounded on any axis.
+   */
+  bool IsInfinite() const { return !IsEmpty() && !min.allFinite(); }
+
+  /**
+   * @brief Grow to include a point.
+   */
+  Bounds& Extend(const Eigen::Vector3d& p) {
+    min = min.cwiseMin(p);
+    max = max.cwiseMax(p);
+    return *this;
+  }
+
+  /**
+   * @brief Grow to include other bounds.
+   */
+  Bounds& Extend(const Bounds& other) {
+    if (!other.IsEmpty()) {
+      min = min.cwiseMin(other.min);
+      max = max.cwiseMax(other.max);
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Bounds of this box after an affine transform.
+   */
+  Bounds Transformed(const Eigen::Affine3d& mtx) const {
+    if (IsEmpty() || IsInfinite()) {
+      return *this;
+    }
+    const Eigen::Vector3d center = mtx * (0.5 * (min + max));
+    const Eigen::Vector3d extent =
+        mtx.linear().cwiseAbs() * (0.5 * (max - min));
+    return FromMinMax(center - extent, center + extent);
+  }
+
+  /**
+   * @brief Intersect with a ray. On input distance is the farthest distance
+   * to accept, on a hit it becomes the distance where the ray enters the box
+   * (0 when the origin is inside).
+   */
+  bool IntersectRay(const Eigen::Vector3d& origin,
+                    const Eigen::Vector3d& direction, double& distance) const {
+    if (IsEmpty()) {
+      return false;
+    }
+    double enter = 0.0;
+    double exit = distance;
+    for (int axis = 0; axis < 3; ++axis) {
+      const double inv = 1.0 / direction[axis];
+      double t0 = (min[axis] - origin[axis]) * inv;
+      double t1 = (max[axis] - origin[axis]) * inv;
+      if (t0 > t1) {
+        std::swap(t0, t1);
+      }
+      // NaN (origin on the slab of a parallel axis) leaves the range as is.
+      enter = t0 > enter ? t0 : enter;
+      exit = t1 < exit ? t1 : exit;
+    }
+    if (enter > exit) {
+      return false;
+    }
+    distance = enter;
+    return true;
+  }
+};
+}  // namespace livision
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <cstddef>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "livision/Log.hpp"
@@ -37,7 +42,8 @@ class Container : public ObjectBase {
    */
   Container* AddObject(std::shared_ptr<ObjectBase> object);
   /**
-   * @brief Get the list of child objects.
+   * @brief Get the list of child objects. The list may be modified through
+   * this reference, so the name index is rebuilt by the next lookup.
    */
   std::vector<std::shared_ptr<ObjectBase>>& GetObjects();
   /**
@@ -50,30 +56,34 @@ class Container : public ObjectBase {
   void ClearObjects();
   /**
    * @brief Get the first direct child that matches the name.
+   * Name lookups are safe to call concurrently with each other.
    * @return Matching child, or nullptr when not found.
    */
-  std::shared_ptr<ObjectBase> GetChild(const std::string& name) const;
+  std::shared_ptr<ObjectBase> GetChild(std::string_view name) const;
   /**
    * @brief Get all direct children that match the name.
    */
   std::vector<std::shared_ptr<ObjectBase>> GetChildren(
-      const std::string& name) const;
+      std::string_view name) const;
   /**
    * @brief Get the first direct child as Container when possible.
    * @return Matching child as Container, or nullptr when not found / not a
    * Container.
    */
-  std::shared_ptr<Container> GetChildContainer(const std::string& name) const;
+  std::shared_ptr<Container> GetChildContainer(std::string_view name) const;
   /**
    * @brief Resolve a '/' separated relative path from this container.
+   * Each level is a hashed name lookup, so the cost grows with path depth
+   * only.
    * @return Resolved object, or nullptr when not found.
    */
-  std::shared_ptr<ObjectBase> GetByPath(const std::string& path) const;
+  std::shared_ptr<ObjectBase> GetByPath(std::string_view path) const;
   /**
    * @brief Resolve a '/' separated relative path as Container.
    * @return Resolved Container, or nullptr when not found / not a Container.
    */
-  std::shared_ptr<Container> GetContainerByPath(const std::string& path) const;
+  std::shared_ptr<Container> GetContainerByPath(
+      std::string_view path) const;
   /**
    * @brief Dump this container hierarchy as a text tree.
    */
@@ -83,8 +93,39 @@ class Container : public ObjectBase {
    */
   void PrintTree(LogLevel level = LogLevel::Info) const;
 
+ protected:
+  void OnChildRenamed(const ObjectBase& child,
+                      std::string_view old_name) final;
+
  private:
+  struct NameHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view name) const {
+      return std::hash<std::string_view>{}(name);
+    }
+  };
+  // Copies as a fresh unlocked mutex, so Container stays copyable.
+  struct NameMutex : std::mutex {
+    NameMutex() = default;
+    NameMutex(const NameMutex& /*other*/) : std::mutex() {}
+    NameMutex& operator=(const NameMutex& /*other*/) { return *this; }
+  };
+  // Child name -> indices into objects_, in insertion order.
+  using NameIndex = std::unordered_map<std::string, std::vector<std::size_t>,
+                                       NameHash, std::equal_to<>>;
+
+  // Returns the indices of name, rebuilding a stale index first. Caller
+  // holds name_mutex_.
+  const std::vector<std::size_t>* FindIndices(std::string_view name) const;
+  void RebuildNameIndex() const;
+
   std::vector<std::shared_ptr<ObjectBase>> objects_;
+  // Kept current by AddObject, ClearObjects and child renames. Only the
+  // mutable GetObjects() leaves it stale, and then the next lookup rebuilds
+  // it; name_mutex_ serializes that rebuild against concurrent lookups.
+  mutable NameMutex name_mutex_;
+  mutable NameIndex name_index_;
+  mutable bool name_index_stale_ = false;
 };
 
 }  // namespace livision
@@ -1,24 +1,76 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <utility>
 
+// Most verbose log level compiled in (1: Error ... 4: Debug). LogMessage
+// calls above it compile to nothing. CMake defines it for the library and
+// every target linking it, so all of them agree on the value.
+#ifndef LIVISION_LOG_MAX_LEVEL
+#define LIVISION_LOG_MAX_LEVEL 4
+#endif
+
 namespace livision {
 
 enum class LogLevel { Off = 0, Error = 1, Warn = 2, Info = 3, Debug = 4 };
 
+/**
+ * @brief Destination of log messages. Called only from the background log
+ * thread, in the order messages were logged.
+ */
+class LogSink {
+ public:
+  virtual ~LogSink() = default;
+  /**
+   * @brief Write one message.
+   */
+  virtual void Write(LogLevel level, std::string_view message) = 0;
+  /**
+   * @brief Called after each batch of messages.
+   */
+  virtual void Flush() {}
+};
+
 void SetLogLevel(LogLevel level);
 LogLevel GetLogLevel();
 bool ShouldLog(LogLevel level);
+/**
+ * @brief Queue a message for the log thread. Never blocks; messages are
+ * dropped (and counted) while the queue is full. Errors wake the log thread
+ * at once.
+ */
 void Log(LogLevel level, const std::string& message);
+/**
+ * @brief Route messages to a custom sink; nullptr restores the console.
+ */
+void SetLogSink(std::shared_ptr<LogSink> sink);
+/**
+ * @brief Let each distinct message through at most max_repeats times per
+ * window; the number suppressed is reported when the window ends.
+ * 0 disables rate limiting.
+ */
+void SetLogRateLimit(uint32_t max_repeats, double window_seconds);
+/**
+ * @brief Block until every queued message has been written. Returns at once
+ * when called from a LogSink.
+ */
+void FlushLog();
+
+namespace internal {
+// Thread-local stream, emptied and reset to default formatting.
+std::ostringstream& LogStream();
+}  // namespace internal
 
 template <class... Args>
 void LogMessage(LogLevel level, Args&&... args) {
-  if (!ShouldLog(level)) {
+  if (static_cast<int>(level) > LIVISION_LOG_MAX_LEVEL || !ShouldLog(level)) {
     return;
   }
-  std::ostringstream oss;
+  std::ostringstream& oss = internal::LogStream();
   (oss << ... << std::forward<Args>(args));
   Log(level, oss.str());
 }
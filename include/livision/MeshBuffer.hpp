@@ -1,7 +1,11 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <span>
 #include <vector>
 
+#include "livision/Bounds.hpp"
 #include "livision/Vertex.hpp"
 
 namespace livision {
@@ -10,6 +14,56 @@ namespace internal {
 struct MeshBufferAccess;
 }  // namespace internal
 
+/**
+ * @brief Policy for host-side vertex/index copies after GPU upload.
+ */
+enum class CpuRetention {
+  Keep,     // Keep CPU data (needed for picking / re-upload)
+  Release,  // Hand CPU data to the GPU upload and free it afterwards
+};
+
+/**
+ * @brief Normals used to shade the mesh when lighting is enabled.
+ */
+enum class MeshNormals {
+  Flat,    // Faceted, derived per pixel from each triangle; no extra memory
+  Smooth,  // Area-weighted vertex normals generated at load (4 B per vertex)
+};
+
+/**
+ * @brief Creation options for MeshBuffer.
+ */
+struct MeshBufferOptions {
+  CpuRetention cpu_retention = CpuRetention::Keep;  // Host copy policy
+  bool quantize_positions = false;  // Upload positions as snorm16 in bounds
+  bool generate_lods = false;       // Build simplified index LOD chain
+  MeshNormals normals = MeshNormals::Flat;  // Lit shading normals
+  // With CpuRetention::Release, extract and upload wireframe edges before
+  // the host indices are freed. Otherwise released meshes draw no wireframe.
+  bool keep_wireframe = false;
+  // Back with dynamic GPU buffers that are updated in place. Implies Keep,
+  // full-precision positions, no LODs and flat normals.
+  bool dynamic = false;
+};
+
+/**
+ * @brief Count and memory of a group of live mesh buffers.
+ */
+struct MeshMemoryStats {
+  std::size_t count = 0;
+  uint64_t cpu_bytes = 0;  // Host copies of vertices and indices
+  uint64_t gpu_bytes = 0;  // Vertex and index buffers on the GPU
+};
+
+/**
+ * @brief Live mesh buffers by category.
+ */
+struct MeshBufferStats {
+  MeshMemoryStats shared;   // Cached by content (primitives, model parts)
+  MeshMemoryStats unique;   // Created for a single object
+  MeshMemoryStats dynamic;  // Created with MeshBufferOptions::dynamic
+};
+
 /**
  * @brief GPU mesh buffers for vertices and indices.
  */
@@ -19,7 +73,7 @@ class MeshBuffer {
    * @brief Construct from vertices and indices.
    */
   MeshBuffer(std::vector<Vertex> vertices, std::vector<uint32_t> indices,
-             bool has_uv = false);
+             bool has_uv = false, MeshBufferOptions options = {});
   /**
    * @brief Destroy the mesh buffer.
    */
@@ -43,6 +97,48 @@ class MeshBuffer {
    */
   void Destroy();
 
+  /**
+   * @brief Whether host-side vertices/indices are still available.
+   */
+  bool HasCpuData() const;
+
+  /**
+   * @brief Local-space bounding box of the vertices.
+   */
+  Bounds GetLocalBounds() const;
+
+  /**
+   * @brief Whether the buffer was created with MeshBufferOptions::dynamic.
+   */
+  bool IsDynamic() const;
+  /**
+   * @brief Overwrite vertices from offset, growing the mesh when the range
+   * ends past the current vertex count; a gap before offset is zero-filled.
+   * Dynamic buffers upload only the changed range; static buffers are
+   * rebuilt and uploaded again, with LOD levels simplified again on their
+   * next draw. Ignored if the range exceeds 2^32 vertices.
+   */
+  void UpdateVertices(uint32_t offset, std::span<const Vertex> vertices);
+  /**
+   * @brief Overwrite indices from offset, growing like UpdateVertices.
+   */
+  void UpdateIndices(uint32_t offset, std::span<const uint32_t> indices);
+  /**
+   * @brief Set vertex and index counts, truncating or zero-filling.
+   */
+  void Resize(uint32_t vertex_count, uint32_t index_count);
+  /**
+   * @brief Use precomputed wireframe edges (vertex index pairs) instead of
+   * extracting them from the triangles on the first wireframe draw.
+   * Ignored for static meshes while the wireframe overlay is in use.
+   */
+  void SetWireIndices(std::vector<uint32_t> wire_indices);
+  /**
+   * @brief Reserve capacity so a dynamic buffer can grow without being
+   * reallocated on the GPU.
+   */
+  void Reserve(uint32_t vertex_capacity, uint32_t index_capacity);
+
  private:
   struct Impl;
   std::unique_ptr<Impl> pimpl_;
@@ -50,4 +146,10 @@ class MeshBuffer {
   friend struct internal::MeshBufferAccess;
 };
 
+/**
+ * @brief Snapshot of all live mesh buffers, e.g. to spot meshes that are
+ * never released in long-running sessions.
+ */
+MeshBufferStats GetMeshBufferStats();
+
 }  // namespace livision
@@ -4,8 +4,10 @@
 #include <Eigen/Geometry>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 
+#include "livision/Bounds.hpp"
 #include "livision/Color.hpp"
 #include "livision/MeshBuffer.hpp"
 #include "livision/Renderer.hpp"
@@ -68,6 +70,21 @@ class ObjectBase {
    * @brief Update cached transform matrices.
    */
   virtual void UpdateMatrix(const Eigen::Affine3d& parent_mtx);
+  /**
+   * @brief Local-space bounds used for culling. Defaults to the mesh bounds,
+   * or infinite bounds when the object has no mesh.
+   */
+  virtual Bounds GetLocalBounds() const;
+  /**
+   * @brief Intersect a world-space ray with this object, as used by
+   * Viewer::Pick. On input distance is the farthest distance to accept, on
+   * a hit it becomes the distance to the hit. Defaults to the mesh
+   * triangles, or the world bounds once the mesh host data was released;
+   * objects without a mesh are never hit.
+   */
+  virtual bool IntersectRay(const Eigen::Vector3d& origin,
+                            const Eigen::Vector3d& direction,
+                            double& distance) const;
 
   /**
    * @brief Set all parameters.
@@ -144,6 +161,10 @@ class ObjectBase {
    * @brief Get global transform matrix.
    */
   Eigen::Affine3d GetGlobalMatrix() const;
+  /**
+   * @brief Get world-space bounds as of the last UpdateMatrix.
+   */
+  const Bounds& GetWorldBounds() const;
   /**
    * @brief Get object name.
    */
@@ -159,8 +180,17 @@ class ObjectBase {
   std::shared_ptr<MeshBuffer>& GetMeshBuffer() { return mesh_buf_; }
 
  protected:
+  /**
+   * @brief Called on the parent when a child's name changes.
+   * @param child Renamed child, already holding its new name.
+   * @param old_name Name the child had before.
+   */
+  virtual void OnChildRenamed(const ObjectBase& /*child*/,
+                              std::string_view /*old_name*/) {}
+
   Eigen::Affine3d global_mtx_ = Eigen::Affine3d::Identity();
   Eigen::Affine3d local_mtx_ = Eigen::Affine3d::Identity();
+  Bounds world_bounds_ = Bounds::Infinite();
 
   Params params_;
 
@@ -1,19 +1,38 @@
 #pragma once
 
 #include <Eigen/Geometry>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "livision/Bounds.hpp"
 #include "livision/Color.hpp"
 #include "livision/MeshBuffer.hpp"
 
 namespace livision {
 
+class ObjectBase;
+
 enum class TextFacingMode { Billboard, Fixed };
 enum class TextDepthMode { DepthTest, AlwaysVisible };
 enum class TextAlign { Left, Center, Right };
 
+/**
+ * @brief Directional light for solid fills. Meshes are shaded with their
+ * MeshNormals mode; textured fills and instanced draws stay unlit.
+ */
+struct Lighting {
+  bool enabled = false;  // Off: fills use their flat color
+  Eigen::Vector3d direction{-0.3, -0.5, -1.0};  // Direction the light travels
+  bool follow_camera = false;  // direction is in view space (a headlight)
+  Color color = color::white;  // Light color
+  float ambient = 0.35F;       // Brightness of unlit faces, 0 to 1
+  // Light smooth meshes per vertex instead of per pixel; cheaper on
+  // integrated GPUs, coarser highlights on low-poly meshes.
+  bool per_vertex = false;
+};
+
 /**
  * @brief Low-level rendering backend wrapper.
  */
@@ -35,6 +54,14 @@ class Renderer {
    * @brief Deinitialize graphics backend.
    */
   void DeInit();
+  /**
+   * @brief Start a frame: upload textures whose decode has finished.
+   */
+  void BeginFrame();
+  /**
+   * @brief Finish a frame: draw text batched by SubmitText.
+   */
+  void EndFrame();
   /**
    * @brief Set directories used to search for shaders.
    */
@@ -43,13 +70,97 @@ class Renderer {
    * @brief Set current camera view matrix for billboard text rendering.
    */
   void SetCameraViewMatrix(const float view[16]);
+  /**
+   * @brief Set current projection matrix and viewport size for LOD selection.
+   */
+  void SetProjection(const float proj[16], int viewport_width,
+                     int viewport_height);
+  /**
+   * @brief Set projected diameter (pixels) below which coarser LODs are used.
+   * Each halving of the projected size selects the next level. 0 disables.
+   */
+  void SetLodPixelThreshold(float pixels);
+  /**
+   * @brief Pick the LOD level for a mesh drawn with the given transform.
+   */
+  uint32_t SelectLod(MeshBuffer& mesh_buffer, const Eigen::Affine3d& mtx) const;
+  /**
+   * @brief Set GPU texture budget and idle frames before a texture may be
+   * evicted. A budget of 0 disables eviction.
+   */
+  void SetTextureBudget(uint64_t budget_bytes, uint32_t evict_after_frames);
+  /**
+   * @brief Set how many released GPU buffers are destroyed per frame. Larger
+   * backlogs are still worked off within a few dozen frames. 0 destroys all.
+   */
+  void SetGpuReleaseBudget(uint32_t handles_per_frame);
+  /**
+   * @brief Hide text labels that overlap higher-priority labels on screen.
+   */
+  void SetLabelDeclutter(bool enabled);
+  /**
+   * @brief Enable or disable view frustum culling.
+   */
+  void SetFrustumCulling(bool enabled);
+  /**
+   * @brief Draw wireframes in the fill pass with the barycentric overlay
+   * shader instead of a separate line pass. Falls back to lines when the
+   * shader is unavailable.
+   * @param line_width Edge width in pixels.
+   */
+  void SetWireframeOverlay(bool enabled, float line_width = 1.0F);
+  /**
+   * @brief Set the directional light. Falls back to unlit fills when the
+   * lit shaders are unavailable.
+   */
+  void SetLighting(const Lighting& lighting);
+  /**
+   * @brief Attribute the following submissions to an object, for GPU picking
+   * and selection outlines. Calls nest; the viewer and containers wrap each
+   * OnDraw in BeginObject / EndObject.
+   */
+  void BeginObject(const ObjectBase* object);
+  /**
+   * @brief End the innermost BeginObject.
+   */
+  void EndObject();
+  /**
+   * @brief Draw an outline around these objects and everything drawn inside
+   * them (e.g. the children of a container).
+   */
+  void SetHighlightedObjects(std::vector<const ObjectBase*> objects);
+  /**
+   * @brief Set outline color and width in pixels.
+   */
+  void SetOutlineStyle(const Color& color, float width);
+  /**
+   * @brief Render object IDs around a window position (pixels, top-left
+   * origin) in this frame's ID pass, unless a readback is still in flight.
+   * Call before BeginFrame.
+   */
+  void RequestPick(int x, int y);
+  /**
+   * @brief Complete GPU readbacks; pass the number returned by bgfx::frame().
+   */
+  void OnFrameSubmitted(uint32_t frame_number);
+  /**
+   * @brief Take the newest finished pick: the object under the requested
+   * position, or the nearest one within a few pixels, and its instance
+   * index for instanced draws. object is null over the background.
+   * @return False when no pick has finished since the last call.
+   */
+  bool FetchPick(const ObjectBase*& object, uint32_t& instance);
+  /**
+   * @brief Whether world-space bounds intersect the current view frustum.
+   */
+  bool InFrustum(const Bounds& bounds) const;
 
   /**
    * @brief Submit a mesh with transform and colors.
    */
   void Submit(MeshBuffer& mesh_buffer, const Eigen::Affine3d& mtx,
               const Color& color, const std::string& texture,
-              const Color& wire_color);
+              const Color& wire_color, uint32_t lod = 0);
   /**
    * @brief Submit instanced draws with per-instance positions.
    */
@@ -57,12 +168,15 @@ class Renderer {
                        const std::vector<Eigen::Vector4d>& points,
                        const Eigen::Affine3d& mtx, const Color& color);
   /**
-   * @brief Submit world-space text.
+   * @brief Queue world-space text; drawn in batches at EndFrame.
+   *
+   * With label declutter on, higher-priority labels win overlaps.
    */
   void SubmitText(const std::string& text, const Eigen::Affine3d& mtx,
                   const Color& color, const std::string& font_path,
                   float height, TextFacingMode facing_mode,
-                  TextDepthMode depth_mode, TextAlign align);
+                  TextDepthMode depth_mode, TextAlign align,
+                  int priority = 0);
 
  private:
   static void PrintBackend();
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <Eigen/Geometry>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+#include "livision/Color.hpp"
+#include "livision/MeshBuffer.hpp"
+#include "livision/ObjectBase.hpp"
+
+namespace livision {
+
+/**
+ * @brief Stable reference to an entity in a ScenePool.
+ */
+struct ScenePoolHandle {
+  uint32_t index = std::numeric_limits<uint32_t>::max();
+  uint32_t generation = 0;
+};
+
+/**
+ * @brief Scene node that stores many lightweight entities in contiguous
+ * arrays instead of one ObjectBase per entity.
+ *
+ * Entities are addressed by handle and may be parented to each other. World
+ * transforms are updated in one pass over a parent-first order, which keeps
+ * scenes with 100k+ moving objects (e.g. swarms) cheap to update and draw.
+ */
+class ScenePool : public ObjectBase, public SharedInstanceFactory<ScenePool> {
+ public:
+  using Handle = ScenePoolHandle;
+
+  /**
+   * @brief Thin facade with ObjectBase-style setters for one entity.
+   * Calls on a destroyed entity are ignored.
+   */
+  class Entity {
+   public:
+    /**
+     * @brief Set position relative to the parent entity.
+     */
+    Entity& SetPos(const Eigen::Vector3d& pos);
+    /**
+     * @brief Set position from components.
+     */
+    Entity& SetPos(double x, double y, double z);
+    /**
+     * @brief Set scale.
+     */
+    Entity& SetScale(const Eigen::Vector3d& scale);
+    /**
+     * @brief Set rotation from quaternion.
+     */
+    Entity& SetQuatRotation(const Eigen::Quaterniond& q);
+    /**
+     * @brief Set rotation from Euler degrees.
+     */
+    Entity& SetDegRotation(const Eigen::Vector3d& euler_deg);
+    /**
+     * @brief Set rotation from Euler radians.
+     */
+    Entity& SetRadRotation(const Eigen::Vector3d& euler_rad);
+    /**
+     * @brief Set visibility flag. Hidden entities also hide their children.
+     */
+    Entity& SetVisible(bool visible);
+    /**
+     * @brief Set base color.
+     */
+    Entity& SetColor(const Color& color);
+    /**
+     * @brief Set wireframe color.
+     */
+    Entity& SetWireColor(const Color& color);
+    /**
+     * @brief Get global transform as of the last UpdateMatrix.
+     */
+    Eigen::Affine3d GetGlobalMatrix() const;
+    /**
+     * @brief Whether the entity still exists.
+     */
+    bool IsValid() const;
+    /**
+     * @brief Get the handle of this entity.
+     */
+    Handle GetHandle() const { return handle_; }
+
+   private:
+    friend class ScenePool;
+    Entity(ScenePool* pool, Handle handle) : pool_(pool), handle_(handle) {}
+
+    ScenePool* pool_;
+    Handle handle_;
+  };
+
+  /**
+   * @brief Construct an empty pool.
+   */
+  explicit ScenePool(Params params = Params());
+  /**
+   * @brief Destroy the pool and all entities.
+   */
+  ~ScenePool();
+
+  /**
+   * @brief Called during draw submission.
+   */
+  void OnDraw(Renderer& renderer) final;
+  /**
+   * @brief Update world transforms of all entities.
+   */
+  void UpdateMatrix(const Eigen::Affine3d& parent_mtx) final;
+
+  /**
+   * @brief Add an entity drawing the given mesh, optionally under a parent.
+   * Entities without a mesh only act as transform groups.
+   */
+  Entity Add(std::shared_ptr<MeshBuffer> mesh, Handle parent = Handle());
+  /**
+   * @brief Add an entity sharing the mesh of object type T (e.g. Box).
+   */
+  template <class T>
+  Entity Add(Handle parent = Handle()) {
+    T prototype;
+    return Add(prototype.GetMeshBuffer(), parent);
+  }
+  /**
+   * @brief Destroy an entity together with all of its descendants.
+   */
+  void Destroy(Handle handle);
+  /**
+   * @brief Remove all entities.
+   */
+  void Clear();
+  /**
+   * @brief Change the parent of an entity. Rejected if it would form a cycle.
+   * @return Whether the parent was changed.
+   */
+  bool SetParent(Handle handle, Handle parent);
+  /**
+   * @brief Get the facade for an entity.
+   */
+  Entity Get(Handle handle) { return {this, handle}; }
+  /**
+   * @brief Whether the handle refers to a live entity.
+   */
+  bool IsValid(Handle handle) const;
+  /**
+   * @brief Number of live entities.
+   */
+  std::size_t Size() const;
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> pimpl_;
+};
+
+}  // namespace livision
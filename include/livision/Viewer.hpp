@@ -1,12 +1,16 @@
 #pragma once
 
+#include <Eigen/Core>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
 
 #include "livision/Camera.hpp"
 #include "livision/Color.hpp"
 #include "livision/Log.hpp"
 #include "livision/ObjectBase.hpp"
+#include "livision/Renderer.hpp"
 #include "livision/imgui/imgui.h"
 #include "livision/implot/implot.h"
 
@@ -22,6 +26,30 @@ struct ViewerConfig {
   int height = 720;                      // Window height
   Color background = color::light_gray;  // Background color (RGB is used)
   LogLevel log_level = LogLevel::Info;   // Log level
+  float lod_pixel_threshold = 256.0F;    // Mesh LOD switch size (0: off)
+  bool frustum_culling = true;           // Skip objects outside the view
+  uint64_t texture_budget_mb = 512;      // GPU texture budget (0: no limit)
+  uint32_t texture_evict_frames = 300;   // Idle frames before eviction
+  uint32_t gpu_release_budget = 256;     // GPU buffers freed per frame (0: all)
+  bool label_declutter = false;          // Hide overlapping text labels
+  uint32_t transform_threads = 0;        // Transform update threads (0: auto)
+  bool wireframe_overlay = false;        // Shade wireframes in the fill pass
+  float wireframe_width = 1.0F;          // Overlay edge width in pixels
+  bool gpu_picking = false;              // Track the hovered object on GPU
+  Color outline_color = color::orange;   // Selection outline color
+  float outline_width = 3.0F;            // Selection outline width in pixels
+  Lighting lighting;                     // Directional light (off by default)
+};
+
+/**
+ * @brief Nearest object hit by a pick ray.
+ */
+struct PickResult {
+  std::shared_ptr<ObjectBase> object;  // Hit object, or null on a miss
+  std::string path;                    // '/' joined names from the viewer
+  Eigen::Vector3d point = Eigen::Vector3d::Zero();  // World-space hit point
+  double distance = 0.0;  // Distance from the ray origin
+  uint32_t instance = 0;  // Hit point index of an instanced draw (GPU picks)
 };
 
 /**
@@ -60,10 +88,41 @@ class Viewer {
    * @brief Register a UI callback (ImGui).
    */
   void RegisterUICallback(std::function<void()> ui_callback);
+  /**
+   * @brief Replace the directional light.
+   */
+  void SetLighting(const Lighting& lighting);
   /**
    * @brief Set camera controller implementation.
    */
   void SetCameraController(std::unique_ptr<CameraBase> camera);
+  /**
+   * @brief Pick the object under a window position (pixels, top-left
+   * origin, e.g. ImGui::GetMousePos()) with the camera of the last frame.
+   * Always misses in headless mode.
+   */
+  PickResult Pick(int x, int y);
+  /**
+   * @brief Pick the nearest object along a world-space ray.
+   */
+  PickResult Pick(const Eigen::Vector3d& origin,
+                  const Eigen::Vector3d& direction);
+  /**
+   * @brief Object under the mouse cursor, found by the GPU ID pass when
+   * ViewerConfig::gpu_picking is set. Lags the cursor by about a frame;
+   * point and distance are not filled in.
+   */
+  const PickResult& GetHovered() const;
+  /**
+   * @brief Add or remove an object from the selection. Selected objects are
+   * drawn with an outline.
+   */
+  void SetSelected(const std::shared_ptr<ObjectBase>& object,
+                   bool selected = true);
+  /**
+   * @brief Remove all objects from the selection.
+   */
+  void ClearSelection();
 
  private:
   void PrintFPS();
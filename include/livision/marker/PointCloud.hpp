@@ -35,6 +35,7 @@ class PointCloud : public ObjectBase,
     for (const auto& p : points_with_size) {
       points_.emplace_back(p.x(), p.y(), p.z(), size_);
     }
+    UpdateBounds();
     return this;
   }
 
@@ -43,6 +44,7 @@ class PointCloud : public ObjectBase,
    */
   PointCloud* SetPoints(const std::vector<Eigen::Vector4d>& points) {
     points_ = points;
+    UpdateBounds();
     return this;
   }
 
@@ -59,10 +61,24 @@ class PointCloud : public ObjectBase,
    */
   const std::vector<Eigen::Vector4d>& GetPoints() { return points_; }
 
+  /**
+   * @brief Bounds of all points including their size.
+   */
+  Bounds GetLocalBounds() const final { return bounds_; }
+
  private:
+  void UpdateBounds() {
+    bounds_ = Bounds::Empty();
+    for (const auto& p : points_) {
+      const Eigen::Vector3d extent = Eigen::Vector3d::Constant(p.w());
+      bounds_.Extend(p.head<3>() - extent).Extend(p.head<3>() + extent);
+    }
+  }
+
   std::vector<Eigen::Vector4d> points_;
   T obj_;
   double size_ = 0.1;
+  Bounds bounds_;
 };
 
 }  // namespace livision
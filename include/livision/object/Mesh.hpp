@@ -33,10 +33,12 @@ class Mesh : public ObjectBase {
   }
 
   /**
-   * @brief Set mesh data from vertices and indices.
+   * @brief Set mesh data from vertices and indices. With options.dynamic the
+   * current dynamic buffer is reused instead of replaced.
    */
   void SetMeshData(const std::vector<Vertex>& vertices,
-                   const std::vector<uint32_t>& indices, bool has_uv = false);
+                   const std::vector<uint32_t>& indices, bool has_uv = false,
+                   MeshBufferOptions options = {});
   /**
    * @brief Set the mesh buffer directly.
    */
@@ -20,6 +20,24 @@ class Model : public Container, public SharedInstanceFactory<Model> {
 
   struct LoadOptions {
     bool force_reload = false;
+    // Keep (default) or drop host-side mesh data once uploaded to the GPU.
+    // Release saves RAM on large worlds but disables CPU-side mesh access.
+    CpuRetention cpu_retention = CpuRetention::Keep;
+    // With Release, keep line wireframe edges on the GPU so the wireframe
+    // overlay still works. Off by default to save the extraction and memory.
+    bool keep_wireframe = false;
+    // Upload vertex positions as 16-bit values normalized to each mesh's
+    // bounds (and UVs as half floats) to cut vertex memory and bandwidth.
+    bool quantize_positions = false;
+    // Reorder mesh triangles/vertices for GPU vertex cache reuse and less
+    // overdraw. Results are cached on disk, so only the first load pays.
+    bool optimize_meshes = false;
+    // Generate simplified LOD levels for each mesh; the renderer switches to
+    // them as the mesh shrinks on screen.
+    bool generate_lods = false;
+    // Generate smooth vertex normals for lighting instead of shading each
+    // triangle flat. Costs 4 bytes of GPU memory per vertex.
+    bool smooth_normals = false;
   };
 
   static Model::Ptr InstanceWithPath(const std::string& path,
@@ -58,7 +76,7 @@ class Model : public Container, public SharedInstanceFactory<Model> {
  private:
   void AddOwned(std::shared_ptr<ObjectBase> child);
   void BuildFromNode(const internal::sdf_loader::SdfNode& node,
-                     bool apply_self_transform = true);
+                     bool apply_self_transform, const LoadOptions& options);
 };
 
 }  // namespace livision
@@ -22,6 +22,7 @@ class Text : public ObjectBase, public SharedInstanceFactory<Text> {
     TextFacingMode facing_mode = TextFacingMode::Billboard;
     TextDepthMode depth_mode = TextDepthMode::DepthTest;
     TextAlign align = TextAlign::Left;
+    int priority = 0;  // Kept over lower priorities when decluttering
   };
 
   explicit Text(Params params);
@@ -34,6 +35,7 @@ class Text : public ObjectBase, public SharedInstanceFactory<Text> {
   Text* SetFacingMode(TextFacingMode mode);
   Text* SetDepthMode(TextDepthMode mode);
   Text* SetAlign(TextAlign align);
+  Text* SetPriority(int priority);
 
  private:
   std::string text_;
@@ -42,6 +44,7 @@ class Text : public ObjectBase, public SharedInstanceFactory<Text> {
   TextFacingMode facing_mode_ = TextFacingMode::Billboard;
   TextDepthMode depth_mode_ = TextDepthMode::DepthTest;
   TextAlign align_ = TextAlign::Left;
+  int priority_ = 0;
 };
 
 }  // namespace livision
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "livision/Vertex.hpp"
+
+namespace livision::internal {
+
+struct BvhBox {
+  Eigen::Vector3f min;
+  Eigen::Vector3f max;
+};
+
+// Bounding volume hierarchy over boxes, built with a binned surface area
+// heuristic. Nodes are 32 bytes and children are stored next to each other.
+class Bvh {
+ public:
+  struct Node {
+    Eigen::Vector3f min;
+    uint32_t first = 0;  // First leaf position, or left child index
+    Eigen::Vector3f max;
+    uint32_t count = 0;  // Primitives in a leaf; 0 for inner nodes
+  };
+
+  // Returns the primitive index of each leaf position.
+  std::vector<uint32_t> Build(std::span<const BvhBox> boxes);
+
+  // Calls visit(position) for each leaf primitive whose box the ray enters
+  // before max_t, nearer nodes first. Positions index the order returned by
+  // Build(); visit may lower max_t to prune the rest of the traversal.
+  template <class Visit>
+  void Traverse(const Eigen::Vector3f& origin, const Eigen::Vector3f& dir,
+                float& max_t, Visit&& visit) const;
+
+  uint64_t Bytes() const;
+
+ private:
+  static float EnterDistance(const Node& node, const Eigen::Vector3f& origin,
+                             const Eigen::Vector3f& inv_dir, float max_t);
+
+  std::vector<Node> nodes_;
+};
+
+// Triangle BVH of a mesh in its local space. Triangles are copied in leaf
+// order so a traversal reads contiguous memory, independent of later edits
+// to the mesh.
+class MeshBvh {
+ public:
+  struct Hit {
+    float t = 0.0F;         // Ray parameter; a distance for unit directions
+    uint32_t triangle = 0;  // Index of the triangle in the mesh
+  };
+
+  MeshBvh(std::span<const Vertex> vertices, std::span<const uint32_t> indices);
+
+  // Nearest two-sided hit with t in [0, max_t].
+  bool Intersect(const Eigen::Vector3f& origin, const Eigen::Vector3f& dir,
+                 float max_t, Hit& hit) const;
+  uint64_t Bytes() const;
+
+ private:
+  struct Triangle {
+    Eigen::Vector3f v0;
+    Eigen::Vector3f e1;  // v1 - v0
+    Eigen::Vector3f e2;  // v2 - v0
+    uint32_t id;
+  };
+
+  Bvh bvh_;
+  std::vector<Triangle> triangles_;
+};
+
+inline float Bvh::EnterDistance(const Node& node,
+                                const Eigen::Vector3f& origin,
+                                const Eigen::Vector3f& inv_dir, float max_t) {
+  float enter = 0.0F;
+  float exit = max_t;
+  for (int axis = 0; axis < 3; ++axis) {
+    float t0 = (node.min[axis] - origin[axis]) * inv_dir[axis];
+    float t1 = (node.max[axis] - origin[axis]) * inv_dir[axis];
+    if (t0 > t1) {
+      std::swap(t0, t1);
+    }
+    // Written so that NaN (0 * inf when the origin lies on the slab of an
+    // axis the ray is parallel to) leaves the interval unchanged.
+    enter = t0 > enter ? t0 : enter;
+    exit = t1 < exit ? t1 : exit;
+  }
+  return enter <= exit ? enter : std::numeric_limits<float>::infinity();
+}
+
+template <class Visit>
+void Bvh::Traverse(const Eigen::Vector3f& origin, const Eigen::Vector3f& dir,
+                   float& max_t, Visit&& visit) const {
+  if (nodes_.empty()) {
+    return;
+  }
+  const Eigen::Vector3f inv_dir = dir.cwiseInverse();
+  constexpr float kMiss = std::numeric_limits<float>::infinity();
+  if (EnterDistance(nodes_[0], origin, inv_dir, max_t) == kMiss) {
+    return;
+  }
+
+  // Build() limits the depth so pending far children always fit.
+  constexpr int kStackSize = 64;
+  std::pair<uint32_t, float> stack[kStackSize];
+  int top = 0;
+  stack[top++] = {0U, 0.0F};
+  while (top > 0) {
+    const auto [index, enter] = stack[--top];
+    if (enter > max_t) {
+      continue;
+    }
+    const Node& node = nodes_[index];
+    if (node.count > 0) {
+      for (uint32_t i = 0; i < node.count; ++i) {
+        visit(node.first + i);
+      }
+      continue;
+    }
+    uint32_t closer = node.first;
+    uint32_t farther = node.first + 1;
+    float closer_t = EnterDistance(nodes_[closer], origin, inv_dir, max_t);
+    float farther_t = EnterDistance(nodes_[farther], origin, inv_dir, max_t);
+    if (farther_t < closer_t) {
+      std::swap(closer, farther);
+      std::swap(closer_t, farther_t);
+    }
+    if (farther_t != kMiss && top < kStackSize) {
+      stack[top++] = {farther, farther_t};
+    }
+    if (closer_t != kMiss && top < kStackSize) {
+      stack[top++] = {closer, closer_t};
+    }
+  }
+}
+
+}  // namespace livision::internal
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <bgfx/bgfx.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace livision::internal {
+
+// Decode the code point starting at text[pos] and advance pos past it.
+// Malformed sequences yield U+FFFD and consume one byte.
+uint32_t DecodeUtf8(std::string_view text, std::size_t& pos);
+
+// Font atlas that rasterizes glyphs on first use into fixed-size pages, so
+// memory grows with the glyphs actually drawn. In SDF mode glyphs are signed
+// distance fields in single-channel pages and scale to any text height;
+// otherwise they are white RGBA8 coverage bitmaps.
+class GlyphAtlas {
+ public:
+  struct Glyph {
+    // Quad relative to the pen position in base pixels, y down.
+    float x0 = 0.0F;
+    float y0 = 0.0F;
+    float x1 = 0.0F;
+    float y1 = 0.0F;
+    // Normalized texture coordinates within the page.
+    float s0 = 0.0F;
+    float t0 = 0.0F;
+    float s1 = 0.0F;
+    float t1 = 0.0F;
+    float advance = 0.0F;
+    int index = 0;       // Font glyph index, for kerning
+    uint16_t page = 0;
+    bool visible = false;  // False for blank glyphs such as spaces
+  };
+
+  GlyphAtlas();
+  ~GlyphAtlas();
+  GlyphAtlas(GlyphAtlas&&) noexcept;
+  GlyphAtlas& operator=(GlyphAtlas&&) noexcept;
+
+  // Read the font file. Fails if it cannot be read or parsed.
+  bool Load(const std::string& font_path, bool sdf);
+  // Destroy page textures. Glyphs are rasterized again on next use.
+  void Reset();
+
+  // Glyph for a code point, rasterized on first use. Glyphs that no longer
+  // fit in the atlas stay blank.
+  const Glyph* GetGlyph(uint32_t codepoint);
+  float Kerning(const Glyph& left, const Glyph& right) const;
+
+  // Size the glyph metrics are expressed in (em height in pixels).
+  float PixelHeight() const;
+  std::size_t PageCount() const;
+  bgfx::TextureHandle PageTexture(std::size_t page) const;
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> pimpl_;
+};
+
+}  // namespace livision::internal
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <bgfx/bgfx.h>
+
+#include <cstddef>
+
+namespace livision::internal {
+
+// GPU buffers released from any thread are queued here instead of being
+// destroyed on the spot, and the renderer destroys them at frame start a
+// bounded number at a time. Unloading a large scene from a worker thread
+// then neither races bgfx nor stalls a single frame.
+void DeferDestroy(bgfx::VertexBufferHandle handle);
+void DeferDestroy(bgfx::IndexBufferHandle handle);
+void DeferDestroy(bgfx::DynamicVertexBufferHandle handle);
+void DeferDestroy(bgfx::DynamicIndexBufferHandle handle);
+
+// Destroy queued handles, oldest first: at least max_count (all when 0),
+// more while the backlog is large so it cannot grow without bound. Render
+// thread only. Returns the number destroyed.
+std::size_t DrainDeferredDestroys(std::size_t max_count);
+std::size_t PendingDestroyCount();
+
+}  // namespace livision::internal
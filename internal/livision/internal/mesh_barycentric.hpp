@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace livision::internal::mesh_barycentric {
+
+struct Channels {
+  // Barycentric channel (0-2) of every vertex, split copies included.
+  std::vector<uint8_t> channels;
+  // Source vertex of each copy, appended after the original vertices.
+  std::vector<uint32_t> split_sources;
+};
+
+// Give every vertex one of three channels so that the corners of each
+// triangle carry distinct ones, which lets a fragment shader rebuild
+// barycentric coordinates from an indexed mesh. Vertices whose triangles
+// disagree are split; indices are rewritten to the copies in place.
+Channels AssignChannels(std::size_t vertex_count,
+                        std::vector<uint32_t>& indices);
+
+}  // namespace livision::internal::mesh_barycentric
@@ -2,16 +2,43 @@
 
 #include <bgfx/bgfx.h>
 
+#include <Eigen/Geometry>
+
 #include "livision/MeshBuffer.hpp"
+#include "livision/internal/bvh.hpp"
+#include "livision/internal/mesh_buffer_manager.hpp"
 
 namespace livision::internal {
 
 struct MeshBufferAccess {
-  static bgfx::VertexBufferHandle VertexBuffer(MeshBuffer& mesh);
-  static bgfx::IndexBufferHandle IndexBuffer(MeshBuffer& mesh);
-  static bgfx::IndexBufferHandle WireIndexBuffer(MeshBuffer& mesh);
-  static uint32_t GetIndexCount(MeshBuffer& mesh);
+  // Bind the vertices and the index buffer of a LOD level for the next
+  // submit, creating buffers or uploading pending changes first. Returns
+  // false (binding nothing) when there is nothing to draw.
+  static bool SetBuffers(MeshBuffer& mesh, uint32_t lod = 0);
+  // Same as SetBuffers, with the wireframe edge list as indices.
+  static bool SetWireBuffers(MeshBuffer& mesh);
+  // Bind full-resolution vertices, indices and the barycentric channel
+  // stream for the wireframe overlay shader, splitting vertices on first
+  // use. Fails for dynamic meshes and meshes released before splitting.
+  static bool SetBarycentricBuffers(MeshBuffer& mesh);
+  // Bind vertices, indices of a LOD level and the smooth normal stream for
+  // the lit shader. Fails for meshes without smooth normals, and for meshes
+  // released before their normals were uploaded.
+  static bool SetNormalBuffers(MeshBuffer& mesh, uint32_t lod = 0);
   static bool HasUV(MeshBuffer& mesh);
+  static bool IsQuantized(MeshBuffer& mesh);
+  static const Eigen::Affine3d& DequantizeMatrix(MeshBuffer& mesh);
+  static const Eigen::Vector4f& BoundingSphere(MeshBuffer& mesh);
+  // Number of LOD levels including the full-resolution level 0.
+  static uint32_t LodCount(MeshBuffer& mesh);
+  // Triangle BVH in mesh space, built on first use. Null once host data has
+  // been released, unless it was built before.
+  static const MeshBvh* Bvh(MeshBuffer& mesh);
+  static MeshRegistryHandle RegistryHandle(const MeshBuffer& mesh);
+  // Host memory held by the mesh, and GPU memory of its buffers, as of its
+  // last edit. Safe to call from any thread.
+  static uint64_t CpuBytes(const MeshBuffer& mesh);
+  static uint64_t GpuBytes(const MeshBuffer& mesh);
 };
 
 }  // namespace livision::internal
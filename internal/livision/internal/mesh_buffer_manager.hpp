@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
@@ -10,6 +12,13 @@
 
 namespace livision::internal {
 
+// Registry slot of a live MeshBuffer. The generation tells a reused slot
+// apart from the one the handle was issued for.
+struct MeshRegistryHandle {
+  uint32_t slot = std::numeric_limits<uint32_t>::max();
+  uint32_t generation = 0;
+};
+
 class MeshBufferManager {
  public:
   using MeshFactory = std::function<std::shared_ptr<MeshBuffer>()>;
@@ -18,11 +27,20 @@ class MeshBufferManager {
                                                    const MeshFactory& factory);
   static std::shared_ptr<MeshBuffer> CreateTracked(std::vector<Vertex> vertices,
                                                    std::vector<uint32_t> indices,
-                                                   bool has_uv = false);
-  static void Register(const std::shared_ptr<MeshBuffer>& mesh);
+                                                   bool has_uv = false,
+                                                   MeshBufferOptions options = {});
+  // Every MeshBuffer registers itself on construction and unregisters on
+  // destruction, which also drops its shared cache entry. Both are O(1).
+  static MeshRegistryHandle Register(MeshBuffer* mesh);
+  static void Unregister(MeshRegistryHandle handle);
   static void DestroyAllBuffers();
+  static MeshBufferStats GetStats();
   static void SetBgfxAlive(bool alive);
   static bool IsBgfxAlive();
+  // Whether wireframes are drawn by the barycentric overlay shader. Static
+  // meshes then skip edge index buffers.
+  static void SetBarycentricWireframe(bool enabled);
+  static bool UsesBarycentricWireframe();
 };
 
 }  // namespace livision::internal
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "livision/internal/thread_pool.hpp"
+
+namespace livision::internal::mesh_edges {
+
+// Unique undirected edges of a triangle list as index pairs (lo, hi), sorted.
+// Edge keys are radix sorted and deduplicated instead of hashed, so the cost
+// is a few linear passes without per-edge allocations. Large meshes are
+// split across pool when given.
+std::vector<uint32_t> ExtractEdges(std::span<const uint32_t> indices,
+                                   ThreadPool* pool = nullptr);
+
+}  // namespace livision::internal::mesh_edges
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "livision/Vertex.hpp"
+
+namespace livision::internal::mesh_normals {
+
+// Area-weighted vertex normals, packed as unsigned normalized RGBA8 with
+// xyz mapped from [-1, 1] (x in the low byte). Vertices at the same position
+// share a normal so UV seams do not show; vertices without triangles, or
+// whose faces cancel out, point along +Z.
+std::vector<uint32_t> SmoothNormals(std::span<const Vertex> vertices,
+                                    std::span<const uint32_t> indices);
+
+}  // namespace livision::internal::mesh_normals
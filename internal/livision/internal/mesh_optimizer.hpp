@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "livision/Vertex.hpp"
+
+namespace livision::internal::mesh_optimizer {
+
+// Size of the simulated post-transform vertex cache used by the passes below.
+constexpr uint32_t kCacheSize = 16;
+
+// Reorder triangles for post-transform cache reuse (Tipsify, Sander et al.).
+void OptimizeVertexCache(std::vector<uint32_t>& indices,
+                         std::size_t vertex_count);
+
+// Split a cache-optimized triangle list into locality clusters and sort them
+// so that outward-facing clusters are drawn first. Triangle order inside each
+// cluster is kept, so cache efficiency is mostly preserved.
+void OptimizeOverdraw(std::vector<uint32_t>& indices,
+                      const std::vector<Vertex>& vertices);
+
+// Reorder vertices by first use in the index buffer and drop unused ones.
+void OptimizeVertexFetch(std::vector<Vertex>& vertices,
+                         std::vector<uint32_t>& indices);
+
+// Run vertex cache, overdraw and vertex fetch optimization in order.
+void OptimizeMesh(std::vector<Vertex>& vertices,
+                  std::vector<uint32_t>& indices);
+
+// Average cache miss ratio (transformed vertices per triangle) for a FIFO
+// cache of kCacheSize entries.
+float AverageCacheMissRatio(const std::vector<uint32_t>& indices,
+                            std::size_t vertex_count);
+
+}  // namespace livision::internal::mesh_optimizer
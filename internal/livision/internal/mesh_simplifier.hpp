@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "livision/Vertex.hpp"
+
+namespace livision::internal::mesh_simplifier {
+
+// Reduce a triangle list toward target_index_count indices with quadric error
+// edge collapses. Vertices are only collapsed onto existing vertices, so the
+// result indexes the same vertex buffer. Vertices on open borders (including
+// UV seams, which split the index topology) are kept in place.
+std::vector<uint32_t> SimplifyMesh(const std::vector<Vertex>& vertices,
+                                   const std::vector<uint32_t>& indices,
+                                   std::size_t target_index_count);
+
+}  // namespace livision::internal::mesh_simplifier
@@ -14,12 +14,20 @@ namespace livision::internal::sdf_loader {
 struct MeshPart {
   std::vector<Vertex> vertices;
   std::vector<uint32_t> indices;
+  std::vector<uint32_t> wire_indices;  // Precomputed edges, may be empty
   bool has_uv = false;
   std::string texture_uri;
   bool has_color = false;
   Color color = color::white;
 };
 
+struct MeshLoadOptions {
+  // Reorder indices/vertices for GPU cache reuse and overdraw. Results,
+  // including wireframe edges, are stored in an on-disk cache keyed by
+  // source path, size and mtime.
+  bool optimize = false;
+};
+
 // Load all mesh visuals from an SDF file and append them into vertices/indices.
 // Returns true on success, false on failure. When false, error_message (if
 // provided) is filled with a human-readable description.
@@ -36,6 +44,7 @@ bool LoadMeshFile(const std::string& mesh_path, std::vector<Vertex>& vertices,
 // Load a mesh file with assimp and keep submesh/material boundaries.
 bool LoadMeshFileParts(const std::string& mesh_path,
                        std::vector<MeshPart>& parts,
+                       const MeshLoadOptions& options = {},
                        std::string* error_message = nullptr);
 
 struct SdfNode {
@@ -53,6 +62,7 @@ struct SdfNode {
   bool has_uv = false;
   std::vector<Vertex> vertices;
   std::vector<uint32_t> indices;
+  std::vector<uint32_t> wire_indices;  // Precomputed edges, may be empty
   std::vector<SdfNode> children;
 
   bool HasMesh() const { return !vertices.empty() && !indices.empty(); }
@@ -63,6 +73,7 @@ struct SdfNode {
 // optional mesh data (for visuals). Colors are taken from material diffuse or
 // ambient/script values, and mesh diffuse textures are propagated when found.
 bool LoadSdfScene(const std::string& sdf_path, SdfNode& root,
+                  const MeshLoadOptions& options = {},
                   std::string* error_message = nullptr);
 
 }  // namespace livision::internal::sdf_loader
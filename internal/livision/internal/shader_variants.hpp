@@ -0,0 +1,69 @@
+#pragma once
+
+#include <bgfx/bgfx.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace livision::internal {
+
+// Optional shader features. Each one is a preprocessor define in the shader
+// sources, and scripts/compile_shaders.sh builds every combination a shader
+// supports into its own binary, so a draw only runs the code it needs.
+enum ShaderFeature : uint32_t {
+  kShaderRainbow = 1U << 0U,    // RAINBOW: hue shifts along a direction
+  kShaderLitFlat = 1U << 1U,    // LIT_FLAT: faceted, normals from derivatives
+  kShaderPerVertex = 1U << 2U,  // PER_VERTEX: smooth, lit per vertex
+};
+inline constexpr uint32_t kShaderFeatureCount = 3;
+
+// Shader pairs sharing a vertex layout; features vary within a family.
+enum class ShaderFamily : uint8_t {
+  Mesh,      // v_simple / f_simple: positions only
+  Textured,  // v_textured / f_textured: positions and UVs
+  Points,    // v_points / f_points: instanced points
+  Lit,       // v_lit / f_lit: positions and a normal stream
+};
+
+// Binary name of a shader variant without the platform suffix: the base
+// name followed by the enabled features in bit order, e.g.
+// "f_simple_rainbow_lit_flat".
+std::string ShaderVariantName(std::string_view base, uint32_t features);
+
+// Programs by family and feature mask, created on first use.
+class ShaderVariantCache {
+ public:
+  // Loads a shader binary by variant name; invalid when it is missing.
+  using Loader = std::function<bgfx::ShaderHandle(const std::string& name)>;
+
+  ShaderVariantCache() = default;
+  ~ShaderVariantCache();
+  ShaderVariantCache(const ShaderVariantCache&) = delete;
+  ShaderVariantCache& operator=(const ShaderVariantCache&) = delete;
+
+  void SetLoader(Loader loader);
+
+  // Program for the features of the family out of features. Falls back to
+  // the family's base variant (with a warning) when the exact one is not
+  // installed, and returns an invalid handle when neither is.
+  bgfx::ProgramHandle Get(ShaderFamily family, uint32_t features);
+  // Features the family was compiled with.
+  static uint32_t Supported(ShaderFamily family);
+
+  // Destroy all programs and shaders. Call before bgfx::shutdown.
+  void Clear();
+
+ private:
+  bgfx::ShaderHandle Shader(const std::string& name);
+  bgfx::ProgramHandle Load(ShaderFamily family, uint32_t features);
+
+  Loader loader_;
+  // Key: family << 16 | features. Invalid handles mark failed loads.
+  std::unordered_map<uint32_t, bgfx::ProgramHandle> programs_;
+  std::unordered_map<std::string, bgfx::ShaderHandle> shaders_;
+};
+
+}  // namespace livision::internal
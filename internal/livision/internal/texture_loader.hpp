@@ -0,0 +1,41 @@
+#pragma once
+
+#include <bgfx/bgfx.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace livision::internal {
+
+// Decodes texture files on a worker pool and creates the bgfx textures for
+// finished images on the render thread. Single-level RGBA8 images get a
+// generated mip chain.
+class TextureLoader {
+ public:
+  // bytes: GPU memory of the created texture including mips.
+  using ReadyCallback = std::function<void(
+      const std::string& path, bgfx::TextureHandle handle, uint32_t bytes)>;
+
+  TextureLoader();
+  ~TextureLoader();
+
+  // Snapshot format support and start workers. Call after bgfx::init.
+  void Init();
+  // Stop workers and drop decoded images that were not uploaded yet.
+  void Shutdown();
+
+  // Queue a decode. Each request is reported once through UploadReady.
+  void Request(const std::string& path, bool srgb);
+
+  // Create up to max_uploads textures from finished decodes. Failed requests
+  // are reported with an invalid handle. Render thread only.
+  void UploadReady(uint32_t max_uploads, const ReadyCallback& on_ready);
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> pimpl_;
+};
+
+}  // namespace livision::internal
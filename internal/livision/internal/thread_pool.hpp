@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace livision::internal {
+
+// Fixed-size worker pool for background jobs (decoding, loading) and
+// fork-join loops. Tasks still queued when the pool is destroyed are dropped;
+// running tasks are joined.
+class ThreadPool {
+ public:
+  using Task = std::function<void()>;
+
+  explicit ThreadPool(std::size_t thread_count);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  void Submit(Task task);
+  std::size_t ThreadCount() const { return workers_.size(); }
+
+  // Call fn(i) for every i in [0, count) on the workers and the calling
+  // thread, returning once all calls have finished. Each participant starts
+  // on its own slice of the range and steals from the others when done, so
+  // uneven items still balance. May be nested inside another ParallelFor.
+  void ParallelFor(std::size_t count,
+                   const std::function<void(std::size_t)>& fn);
+
+  // Worker count for background pools: leave one core for the render thread.
+  static std::size_t DefaultThreadCount(std::size_t max_threads);
+
+ private:
+  void WorkerLoop();
+
+  std::vector<std::thread> workers_;
+  std::deque<Task> tasks_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stopping_ = false;
+};
+
+}  // namespace livision::internal
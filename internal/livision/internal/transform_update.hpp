@@ -0,0 +1,23 @@
+#pragma once
+
+#include <Eigen/Geometry>
+#include <memory>
+#include <vector>
+
+#include "livision/ObjectBase.hpp"
+#include "livision/internal/thread_pool.hpp"
+
+namespace livision::internal {
+
+// Pool used to update sibling subtrees in parallel; null updates serially.
+// Set by the Viewer while it owns the pool.
+void SetTransformPool(ThreadPool* pool);
+ThreadPool* GetTransformPool();
+
+// Call UpdateMatrix(parent_mtx) on every object. Lists large enough to pay
+// for the fork are split across the transform pool; each object writes only
+// its own subtree, so the result matches the serial update.
+void UpdateMatrices(const std::vector<std::shared_ptr<ObjectBase>>& objects,
+                    const Eigen::Affine3d& parent_mtx);
+
+}  // namespace livision::internal
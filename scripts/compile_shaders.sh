@@ -35,17 +35,67 @@ compile_shader() {
     local SRC=$1
     local OUT_BASE=$2
     local SHADER_TYPE=$3
+    local DEFINES=${4:-}
     OUT="${OUT_BASE}${SUFFIX}.bin"
-    echo "Compiling $SHADER_TYPE shader: $SRC -> $OUT"
-    "$SHADERC" \
-        -f "$SRC" -o "$OUT" \
-        --platform "$PLATFORM" --type "$SHADER_TYPE" --verbose -i ./ -p "$TYPE"
+    echo "Compiling $SHADER_TYPE shader: $SRC -> $OUT ${DEFINES}"
+    if [ -n "$DEFINES" ]; then
+        "$SHADERC" \
+            -f "$SRC" -o "$OUT" --define "$DEFINES" \
+            --platform "$PLATFORM" --type "$SHADER_TYPE" --verbose -i ./ -p "$TYPE"
+    else
+        "$SHADERC" \
+            -f "$SRC" -o "$OUT" \
+            --platform "$PLATFORM" --type "$SHADER_TYPE" --verbose -i ./ -p "$TYPE"
+    fi
+}
+
+# 機能フラグの全組み合わせをコンパイルする。
+# フラグは ShaderFeature のビット順 (RAINBOW, LIT_FLAT, PER_VERTEX) で渡し、
+# 有効なフラグの小文字名を出力名に付ける (例: f_simple_rainbow_lit_flat)。
+# 名前は src/shader_variants.cpp の ShaderVariantName と一致させること。
+compile_variants() {
+    local SRC=$1
+    local OUT_BASE=$2
+    local SHADER_TYPE=$3
+    shift 3
+    local FEATURES=("$@")
+    local COUNT=${#FEATURES[@]}
+    local MASK I NAME DEFINES
+    for ((MASK = 0; MASK < (1 << COUNT); MASK++)); do
+        NAME=$OUT_BASE
+        DEFINES=""
+        for ((I = 0; I < COUNT; I++)); do
+            if ((MASK & (1 << I))); then
+                NAME="${NAME}_$(echo "${FEATURES[$I]}" | tr '[:upper:]' '[:lower:]')"
+                DEFINES="${DEFINES}${FEATURES[$I]};"
+            fi
+        done
+        compile_shader "$SRC" "$NAME" "$SHADER_TYPE" "$DEFINES"
+    done
 }
 
 # shaders
 compile_shader shader/v_simple.sc shader/bin/v_simple vertex
-compile_shader shader/f_simple.sc shader/bin/f_simple fragment
+compile_variants shader/f_simple.sc shader/bin/f_simple fragment RAINBOW LIT_FLAT
 compile_shader shader/v_textured.sc shader/bin/v_textured vertex
-compile_shader shader/f_textured.sc shader/bin/f_textured fragment
+compile_variants shader/f_textured.sc shader/bin/f_textured fragment RAINBOW
 compile_shader shader/v_points.sc shader/bin/v_points vertex
-compile_shader shader/f_points.sc shader/bin/f_points fragment
+compile_variants shader/f_points.sc shader/bin/f_points fragment RAINBOW
+compile_shader shader/v_wireframe.sc shader/bin/v_wireframe vertex
+compile_shader shader/f_wireframe.sc shader/bin/f_wireframe fragment
+compile_shader shader/v_text.sc shader/bin/v_text vertex
+compile_shader shader/v_text_billboard.sc shader/bin/v_text_billboard vertex
+compile_shader shader/f_text.sc shader/bin/f_text fragment
+compile_shader shader/v_pick.sc shader/bin/v_pick vertex
+compile_shader shader/v_points_pick.sc shader/bin/v_points_pick vertex
+compile_shader shader/f_pick.sc shader/bin/f_pick fragment
+compile_variants shader/v_lit.sc shader/bin/v_lit vertex PER_VERTEX
+compile_variants shader/f_lit.sc shader/bin/f_lit fragment RAINBOW PER_VERTEX
+
+# ソースのハッシュを記録し、CMake が shader/bin の鮮度を確認できるようにする。
+if command -v sha256sum > /dev/null; then
+    SHA256=(sha256sum)
+else
+    SHA256=(shasum -a 256)
+fi
+LC_ALL=C "${SHA256[@]}" shader/*.sc shader/*.sh > shader/bin/sources.sha256
@@ -0,0 +1,26 @@
+#!/bin/bash
+set -euo pipefail
+
+# 使い方: compress_textures.sh <texturec> <ディレクトリ> [フォーマット]
+# ディレクトリ以下の PNG/JPEG/TGA を GPU 圧縮済み KTX (ミップ付き) に変換する。
+# 生成された tex.ktx は tex.png の隣に置かれ、GPU が対応していれば
+# LiVision は自動的にそちらを読み込む。
+TEXTUREC=${1:?texturec path required}
+ROOT=${2:?texture directory required}
+# BC7 (デスクトップ), ETC2 (モバイル/組み込み), BC1/BC3 (古い GPU) など
+FORMAT=${3:-BC7}
+
+count=0
+while IFS= read -r -d '' SRC; do
+    OUT="${SRC%.*}.ktx"
+    # 更新されていないものはスキップ
+    if [ -f "$OUT" ] && [ "$OUT" -nt "$SRC" ]; then
+        continue
+    fi
+    echo "Compressing texture: $SRC -> $OUT ($FORMAT)"
+    "$TEXTUREC" -f "$SRC" -o "$OUT" -t "$FORMAT" -m -q default
+    count=$((count + 1))
+done < <(find "$ROOT" -type f \( -iname '*.png' -o -iname '*.jpg' \
+    -o -iname '*.jpeg' -o -iname '*.tga' \) -print0)
+
+echo "Compressed $count texture(s) under $ROOT"
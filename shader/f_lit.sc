@@ -0,0 +1,17 @@
+$input v_worldPos, v_normal, v_shade
+
+#include <bgfx_shader.sh>
+#include "color.sh"
+#include "lighting.sh"
+
+void main() {
+    vec4 outColor = baseColor(v_worldPos);
+
+#ifdef PER_VERTEX
+    // Only interpolates the shade computed in v_lit.
+    vec3 light = v_shade;
+#else
+    vec3 light = shade(normalize(v_normal));
+#endif
+    gl_FragColor = vec4(outColor.rgb * light, outColor.a);
+}
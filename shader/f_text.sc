@@ -0,0 +1,65 @@
+$input v_worldPos, v_texcoord0, v_color0, v_rainbow
+
+#include <bgfx_shader.sh>
+
+SAMPLER2D(s_texture, 0);
+
+vec3 rgb2hsv(vec3 c) {
+    float maxc = max(c.r, max(c.g, c.b));
+    float minc = min(c.r, min(c.g, c.b));
+    float d = maxc - minc;
+    float h = 0.0;
+    if (d > 1e-6) {
+        if (maxc == c.r) {
+            h = (c.g - c.b) / d;
+        } else if (maxc == c.g) {
+            h = (c.b - c.r) / d + 2.0;
+        } else {
+            h = (c.r - c.g) / d + 4.0;
+        }
+        h = fract(h / 6.0);
+        if (h < 0.0) h += 1.0;
+    }
+    float s = (maxc == 0.0) ? 0.0 : d / maxc;
+    float v = maxc;
+    return vec3(h, s, v);
+}
+
+vec3 hsv2rgb(vec3 c) {
+    float h = c.x * 6.0;
+    float s = c.y;
+    float v = c.z;
+    float i = floor(h);
+    float f = h - i;
+    float p = v * (1.0 - s);
+    float q = v * (1.0 - s * f);
+    float t = v * (1.0 - s * (1.0 - f));
+    int ii = int(mod(i, 6.0));
+    if (ii == 0) return vec3(v, t, p);
+    if (ii == 1) return vec3(q, v, p);
+    if (ii == 2) return vec3(p, v, t);
+    if (ii == 3) return vec3(p, q, v);
+    if (ii == 4) return vec3(t, p, v);
+    return vec3(v, p, q);
+}
+
+void main() {
+    vec4 tint = v_color0;
+
+    if (v_rainbow.w > 0.5) {
+        vec3 hsv = rgb2hsv(v_color0.rgb);
+        float hue_offset = fract(dot(v_rainbow.xyz, v_worldPos));
+        hsv.x = fract(hsv.x + hue_offset);
+        tint = vec4(hsv2rgb(hsv), v_color0.a);
+    }
+
+    // Glyphs are signed distance fields (0.5 on the outline); the screen-space
+    // derivative keeps edges about one pixel wide at any text size.
+    float dist = texture2D(s_texture, v_texcoord0).r;
+    float width = max(fwidth(dist), 1e-4) * 0.7;
+    float coverage = smoothstep(0.5 - width, 0.5 + width, dist);
+    if (coverage <= 0.0) {
+        discard;
+    }
+    gl_FragColor = vec4(tint.rgb, tint.a * coverage);
+}
@@ -0,0 +1,81 @@
+$input v_worldPos, v_bary
+
+#include <bgfx_shader.sh>
+
+uniform vec4 u_color;
+uniform vec4 u_rainbow_params; // xyz = direction, w = delta
+uniform vec4 u_color_mode;     // x = 0 fixed, 1 rainbow
+uniform vec4 u_wire_color;
+uniform vec4 u_wire_rainbow;   // xyz = direction, w = delta
+uniform vec4 u_wire_params;    // x = width (px), y = wire mode, z = 1 with fill
+
+vec3 rgb2hsv(vec3 c) {
+    float maxc = max(c.r, max(c.g, c.b));
+    float minc = min(c.r, min(c.g, c.b));
+    float d = maxc - minc;
+    float h = 0.0;
+    if (d > 1e-6) {
+        if (maxc == c.r) {
+            h = (c.g - c.b) / d;
+        } else if (maxc == c.g) {
+            h = (c.b - c.r) / d + 2.0;
+        } else {
+            h = (c.r - c.g) / d + 4.0;
+        }
+        h = fract(h / 6.0);
+        if (h < 0.0) h += 1.0;
+    }
+    float s = (maxc == 0.0) ? 0.0 : d / maxc;
+    float v = maxc;
+    return vec3(h, s, v);
+}
+
+vec3 hsv2rgb(vec3 c) {
+    float h = c.x * 6.0;
+    float s = c.y;
+    float v = c.z;
+    float i = floor(h);
+    float f = h - i;
+    float p = v * (1.0 - s);
+    float q = v * (1.0 - s * f);
+    float t = v * (1.0 - s * (1.0 - f));
+    int ii = int(mod(i, 6.0));
+    if (ii == 0) return vec3(v, t, p);
+    if (ii == 1) return vec3(q, v, p);
+    if (ii == 2) return vec3(p, v, t);
+    if (ii == 3) return vec3(p, q, v);
+    if (ii == 4) return vec3(t, p, v);
+    return vec3(v, p, q);
+}
+
+vec4 shadeColor(vec4 color, float mode, vec4 rainbow) {
+    if (int(mode) == 0) {
+        return color;
+    }
+    vec3 hsv = rgb2hsv(color.rgb);
+    vec3 dir = normalize(rainbow.xyz);
+    float hue_offset = fract(dot(dir, v_worldPos) * rainbow.w);
+    hsv.x = fract(hsv.x + hue_offset);
+    return vec4(hsv2rgb(hsv), color.a);
+}
+
+void main() {
+    vec4 wire = shadeColor(u_wire_color, u_wire_params.y, u_wire_rainbow);
+    vec4 fill = vec4(wire.rgb, 0.0);
+    if (u_wire_params.z > 0.5) {
+        fill = shadeColor(u_color, u_color_mode.x, u_rainbow_params);
+    }
+
+    // Edge coverage; derivatives turn the barycentric distance to pixels.
+    vec3 edge3 = smoothstep(vec3_splat(0.0),
+                            fwidth(v_bary) * u_wire_params.x, v_bary);
+    float edge = 1.0 - min(min(edge3.x, edge3.y), edge3.z);
+
+    float k = edge * wire.a;
+    float alpha = k + fill.a * (1.0 - k);
+    if (alpha < 1.0 / 255.0) {
+        discard;
+    }
+    vec3 rgb = (wire.rgb * k + fill.rgb * fill.a * (1.0 - k)) / alpha;
+    gl_FragColor = vec4(rgb, alpha);
+}
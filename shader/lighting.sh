@@ -0,0 +1,10 @@
+// Directional light with an ambient term.
+
+uniform vec4 u_light_dir;   // xyz = towards the light
+uniform vec4 u_light_color; // rgb = light color, a = ambient
+
+vec3 shade(vec3 normal) {
+    float diffuse = max(dot(normal, u_light_dir.xyz), 0.0);
+    return u_light_color.a +
+           (1.0 - u_light_color.a) * diffuse * u_light_color.rgb;
+}
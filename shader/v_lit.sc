@@ -0,0 +1,31 @@
+$input a_position, a_normal
+$output v_worldPos, v_normal, v_shade
+
+#include <bgfx_shader.sh>
+
+#ifdef PER_VERTEX
+#include "lighting.sh"
+#endif
+
+uniform mat4 u_normal_mtx;  // Inverse transpose of the object matrix
+
+void main() {
+    vec4 worldPos = mul(u_model[0], vec4(a_position, 1.0));
+    v_worldPos = worldPos.xyz;
+
+    // Normals are stored as unsigned bytes; turn them towards the camera so
+    // either winding is lit.
+    vec3 normal = mul(u_normal_mtx, vec4(a_normal.xyz * 2.0 - 1.0, 0.0)).xyz;
+    normal = normalize(normal);
+    vec3 eye = mul(u_invView, vec4(0.0, 0.0, 0.0, 1.0)).xyz;
+    if (dot(normal, eye - v_worldPos) < 0.0) {
+        normal = -normal;
+    }
+    v_normal = normal;
+#ifdef PER_VERTEX
+    v_shade = shade(normal);
+#else
+    v_shade = vec3_splat(1.0);
+#endif
+    gl_Position = mul(u_modelViewProj, vec4(a_position, 1.0));
+}
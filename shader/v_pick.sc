@@ -0,0 +1,11 @@
+$input a_position
+$output v_color0
+
+#include <bgfx_shader.sh>
+
+uniform vec4 u_pick_id; // Draw ID as RGBA8 bytes, low byte in r
+
+void main() {
+    v_color0 = u_pick_id;
+    gl_Position = mul(u_modelViewProj, vec4(a_position, 1.0));
+}
@@ -0,0 +1,13 @@
+$input a_position, i_data0, i_data1
+$output v_color0
+
+#include <bgfx_shader.sh>
+
+void main() {
+    vec3 center = i_data0.xyz;
+    float size = i_data0.w;
+
+    vec3 localPos = a_position * size + center;
+    v_color0 = i_data1; // Instance ID as RGBA8 bytes, low byte in r
+    gl_Position = mul(u_modelViewProj, vec4(localPos, 1.0));
+}
@@ -0,0 +1,14 @@
+$input a_position, a_texcoord0, a_color0, a_texcoord1
+$output v_worldPos, v_texcoord0, v_color0, v_rainbow
+
+#include <bgfx_shader.sh>
+
+// Batched text: positions are already in world space, color and rainbow
+// parameters (xyz = direction * delta, w = mode) are per vertex.
+void main() {
+    v_worldPos = a_position;
+    v_texcoord0 = a_texcoord0;
+    v_color0 = a_color0;
+    v_rainbow = a_texcoord1;
+    gl_Position = mul(u_viewProj, vec4(a_position, 1.0));
+}
@@ -0,0 +1,21 @@
+$input a_position, i_data0, i_data1, i_data2, i_data3, i_data4
+$output v_worldPos, v_texcoord0, v_color0, v_rainbow
+
+#include <bgfx_shader.sh>
+
+uniform vec4 u_text_axes[2]; // camera right, camera up (world space)
+
+// One instance per glyph: a_position.xy is the unit quad corner.
+// i_data0.xyz = label anchor, i_data1 = scaled local rect (x0, y0, x1, y1),
+// i_data2 = atlas uv rect, i_data3 = color, i_data4 = rainbow params.
+void main() {
+    vec2 corner = a_position.xy;
+    vec2 local = mix(i_data1.xy, i_data1.zw, corner);
+    vec3 worldPos = i_data0.xyz + u_text_axes[0].xyz * local.x +
+                    u_text_axes[1].xyz * local.y;
+    v_worldPos = worldPos;
+    v_texcoord0 = mix(i_data2.xy, i_data2.zw, corner);
+    v_color0 = i_data3;
+    v_rainbow = i_data4;
+    gl_Position = mul(u_viewProj, vec4(worldPos, 1.0));
+}
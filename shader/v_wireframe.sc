@@ -0,0 +1,11 @@
+$input a_position, a_color1
+$output v_worldPos, v_bary
+
+#include <bgfx_shader.sh>
+
+void main() {
+    vec4 worldPos = mul(u_model[0], vec4(a_position, 1.0));
+    v_worldPos = worldPos.xyz;
+    v_bary = a_color1.xyz;
+    gl_Position = mul(u_modelViewProj, vec4(a_position, 1.0));
+}
@@ -4,3 +4,16 @@ vec2 a_texcoord0 : TEXCOORD0;
 vec3 v_worldPos : TEXCOORD0;
 vec4 i_data0 : TEXCOORD1;
 vec2 v_texcoord0 : TEXCOORD2;
+vec4 a_color0 : COLOR0;
+vec4 a_texcoord1 : TEXCOORD1;
+vec4 v_color0 : COLOR0;
+vec4 v_rainbow : TEXCOORD3;
+vec4 a_color1 : COLOR1;
+vec4 a_normal : NORMAL;
+vec3 v_bary : TEXCOORD1;
+vec4 i_data1 : TEXCOORD6;
+vec4 i_data2 : TEXCOORD5;
+vec4 i_data3 : TEXCOORD4;
+vec4 i_data4 : TEXCOORD3;
+vec3 v_normal : NORMAL;
+vec3 v_shade : TEXCOORD4;
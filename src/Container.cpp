@@ -1,11 +1,16 @@
 #include "livision/Container.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include "livision/Log.hpp"
+#include "livision/internal/transform_update.hpp"
 
 namespace livision {
 namespace {
@@ -38,23 +43,17 @@ void AppendTreeNode(std::ostringstream& oss, const ObjectBase& object,
   }
 }
 
-std::vector<std::string> SplitPath(const std::string& path) {
-  std::vector<std::string> tokens;
-  std::string current;
-  for (const char c : path) {
-    if (c == '/') {
-      if (!current.empty()) {
-        tokens.push_back(current);
-        current.clear();
-      }
-      continue;
-    }
-    current.push_back(c);
+// Next non-empty '/' separated segment starting at pos, advancing pos past
+// it. Returns an empty view when no segments remain.
+std::string_view NextSegment(std::string_view path, std::size_t& pos) {
+  while (pos < path.size() && path[pos] == '/') {
+    ++pos;
   }
-  if (!current.empty()) {
-    tokens.push_back(current);
+  const std::size_t begin = pos;
+  while (pos < path.size() && path[pos] != '/') {
+    ++pos;
   }
-  return tokens;
+  return path.substr(begin, pos - begin);
 }
 }  // namespace
 
@@ -72,7 +71,11 @@ void Container::OnDeInit() {
 
 void Container::OnDraw(Renderer& renderer) {
   for (const auto& object : objects_) {
-    if (object->IsVisible()) object->OnDraw(renderer);
+    if (object->IsVisible() && renderer.InFrustum(object->GetWorldBounds())) {
+      renderer.BeginObject(object.get());
+      object->OnDraw(renderer);
+      renderer.EndObject();
+    }
   }
 }
 
@@ -86,8 +89,13 @@ void Container::UpdateMatrix(const Eigen::Affine3d& parent_mtx) {
     local_mtx_changed_ = false;
   }
   global_mtx_ = parent_mtx * local_mtx_;
+  internal::UpdateMatrices(objects_, global_mtx_);
+  // Children are already in world space, so the union is built directly
+  // instead of transforming local bounds. Done after the children so the
+  // result does not depend on which thread finished first.
+  world_bounds_ = Bounds::Empty();
   for (const auto& object : objects_) {
-    object->UpdateMatrix(global_mtx_);
+    world_bounds_.Extend(object->GetWorldBounds());
   }
 }
 
@@ -99,11 +107,17 @@ Container* Container::AddObject(std::shared_ptr<ObjectBase> object) {
   if (is_initialized_) {
     object->Init();
   }
-  objects_.push_back(object);
+  std::lock_guard<std::mutex> lock(name_mutex_);
+  if (!name_index_stale_) {
+    name_index_[object->GetName()].push_back(objects_.size());
+  }
+  objects_.push_back(std::move(object));
   return this;
 }
 
 std::vector<std::shared_ptr<ObjectBase>>& Container::GetObjects() {
+  std::lock_guard<std::mutex> lock(name_mutex_);
+  name_index_stale_ = true;
   return objects_;
 }
 
@@ -111,60 +125,112 @@ const std::vector<std::shared_ptr<ObjectBase>>& Container::GetObjects() const {
   return objects_;
 }
 
-void Container::ClearObjects() { objects_.clear(); }
+void Container::ClearObjects() {
+  std::lock_guard<std::mutex> lock(name_mutex_);
+  objects_.clear();
+  name_index_.clear();
+  name_index_stale_ = false;
+}
 
-std::shared_ptr<ObjectBase> Container::GetChild(const std::string& name) const {
-  for (const auto& object : objects_) {
-    if (object && object->GetName() == name) {
-      return object;
+void Container::OnChildRenamed(const ObjectBase& child,
+                               std::string_view old_name) {
+  std::lock_guard<std::mutex> lock(name_mutex_);
+  if (name_index_stale_) {
+    return;
+  }
+  const auto old_it = name_index_.find(old_name);
+  if (old_it == name_index_.end()) {
+    return;
+  }
+  auto& old_indices = old_it->second;
+  const auto pos = std::find_if(
+      old_indices.begin(), old_indices.end(),
+      [&](std::size_t i) { return objects_[i].get() == &child; });
+  if (pos == old_indices.end()) {
+    return;
+  }
+  const std::size_t index = *pos;
+  old_indices.erase(pos);
+  if (old_indices.empty()) {
+    name_index_.erase(old_it);
+  }
+  // Keep insertion order so GetChild still returns the first match.
+  auto& new_indices = name_index_[child.GetName()];
+  new_indices.insert(
+      std::lower_bound(new_indices.begin(), new_indices.end(), index), index);
+}
+
+void Container::RebuildNameIndex() const {
+  name_index_.clear();
+  for (std::size_t i = 0; i < objects_.size(); ++i) {
+    if (objects_[i]) {
+      name_index_[objects_[i]->GetName()].push_back(i);
     }
   }
-  return {};
+  name_index_stale_ = false;
+}
+
+const std::vector<std::size_t>* Container::FindIndices(
+    std::string_view name) const {
+  if (name_index_stale_) {
+    RebuildNameIndex();
+  }
+  const auto it = name_index_.find(name);
+  return it != name_index_.end() ? &it->second : nullptr;
+}
+
+std::shared_ptr<ObjectBase> Container::GetChild(std::string_view name) const {
+  std::lock_guard<std::mutex> lock(name_mutex_);
+  const auto* indices = FindIndices(name);
+  return indices ? objects_[indices->front()] : nullptr;
 }
 
 std::vector<std::shared_ptr<ObjectBase>> Container::GetChildren(
-    const std::string& name) const {
+    std::string_view name) const {
+  std::lock_guard<std::mutex> lock(name_mutex_);
   std::vector<std::shared_ptr<ObjectBase>> found;
-  for (const auto& object : objects_) {
-    if (object && object->GetName() == name) {
-      found.push_back(object);
+  if (const auto* indices = FindIndices(name)) {
+    found.reserve(indices->size());
+    for (const std::size_t i : *indices) {
+      found.push_back(objects_[i]);
     }
   }
   return found;
 }
 
 std::shared_ptr<Container> Container::GetChildContainer(
-    const std::string& name) const {
+    std::string_view name) const {
   return std::dynamic_pointer_cast<Container>(GetChild(name));
 }
 
-std::shared_ptr<ObjectBase> Container::GetByPath(
-    const std::string& path) const {
-  const auto parts = SplitPath(path);
-  if (parts.empty()) {
+std::shared_ptr<ObjectBase> Container::GetByPath(std::string_view path) const {
+  std::size_t pos = 0;
+  std::string_view segment = NextSegment(path, pos);
+  if (segment.empty()) {
     return {};
   }
 
-  const Container* current_container = this;
+  // current_object keeps the container being searched alive.
   std::shared_ptr<ObjectBase> current_object;
-
-  for (std::size_t i = 0; i < parts.size(); ++i) {
-    if (!current_container) {
-      return {};
-    }
-    current_object = current_container->GetChild(parts[i]);
+  const Container* current_container = this;
+  while (true) {
+    current_object = current_container->GetChild(segment);
     if (!current_object) {
       return {};
     }
-    if (i + 1U < parts.size()) {
-      current_container = dynamic_cast<const Container*>(current_object.get());
+    segment = NextSegment(path, pos);
+    if (segment.empty()) {
+      return current_object;
+    }
+    current_container = dynamic_cast<const Container*>(current_object.get());
+    if (!current_container) {
+      return {};
     }
   }
-  return current_object;
 }
 
 std::shared_ptr<Container> Container::GetContainerByPath(
-    const std::string& path) const {
+    std::string_view path) const {
   return std::dynamic_pointer_cast<Container>(GetByPath(path));
 }
 
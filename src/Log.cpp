@@ -1,12 +1,278 @@
 #include "livision/Log.hpp"
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 namespace livision {
 namespace {
 std::atomic<int> g_log_level{static_cast<int>(LogLevel::Off)};
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kQueueCapacity = 4096;  // Power of two
+// How long the writer sleeps when idle; also bounds the delay of a message
+// whose wake-up raced with the writer going to sleep.
+constexpr auto kIdleWait = std::chrono::milliseconds(20);
+// Distinct messages tracked for rate limiting; others pass unlimited.
+constexpr std::size_t kMaxTrackedMessages = 1024;
+
+struct Entry {
+  LogLevel level = LogLevel::Info;
+  std::string message;
+};
+
+// Bounded multi-producer, single-consumer ring (Vyukov). A producer claims
+// a cell with one CAS on the tail and never waits for other producers.
+class LogQueue {
+ public:
+  LogQueue() : cells_(std::make_unique<Cell[]>(kQueueCapacity)) {
+    for (std::size_t i = 0; i < kQueueCapacity; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // Fails without blocking when the ring is full.
+  bool Push(LogLevel level, const std::string& message) {
+    std::size_t pos = tail_.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+    for (;;) {
+      cell = &cells_[pos & (kQueueCapacity - 1)];
+      const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+      const auto diff =
+          static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->entry.level = level;
+    cell->entry.message = message;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only. Swaps the message out so cell buffers are reused.
+  bool Pop(Entry& out) {
+    Cell& cell = cells_[head_ & (kQueueCapacity - 1)];
+    if (cell.sequence.load(std::memory_order_acquire) != head_ + 1) {
+      return false;
+    }
+    out.level = cell.entry.level;
+    out.message.swap(cell.entry.message);
+    cell.sequence.store(head_ + kQueueCapacity, std::memory_order_release);
+    ++head_;
+    return true;
+  }
+
+  // Consumer only.
+  bool HasPending() const {
+    return cells_[head_ & (kQueueCapacity - 1)].sequence.load(
+               std::memory_order_acquire) == head_ + 1;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<std::size_t> sequence{0};
+    Entry entry;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  alignas(64) std::atomic<std::size_t> tail_{0};
+  alignas(64) std::size_t head_ = 0;
+};
+
+class ConsoleSink : public LogSink {
+ public:
+  void Write(LogLevel level, std::string_view message) override {
+    std::ostream& out = level <= LogLevel::Warn ? std::cerr : std::cout;
+    out << "[LiVision] " << message << '\n';
+  }
+  void Flush() override {
+    std::cout.flush();
+    std::cerr.flush();
+  }
+};
+
+// Logging threads only copy the message into the ring. A background writer
+// drains it, applies rate limiting and calls the sink.
+class Logger {
+ public:
+  Logger() : writer_([this]() { Run(); }) {}
+
+  ~Logger() {
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_one();
+    writer_.join();
+  }
+
+  Logger(const Logger&) = delete;
+  Logger& operator=(const Logger&) = delete;
+
+  // Urgent messages always wake the writer instead of waiting for its
+  // next idle tick; the caller never waits either way.
+  void Push(LogLevel level, const std::string& message, bool urgent) {
+    if (!queue_.Push(level, message)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    pushed_.fetch_add(1, std::memory_order_release);
+    if (urgent || sleeping_.load()) {
+      wake_.notify_one();
+    }
+  }
+
+  void Flush() {
+    // The writer cannot wait for itself, e.g. when a sink calls FlushLog.
+    if (std::this_thread::get_id() == writer_.get_id()) {
+      return;
+    }
+    const uint64_t target = pushed_.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(mutex_);
+    wake_.notify_one();
+    written_cv_.wait(lock, [&]() { return written_ >= target; });
+  }
+
+  void SetSink(std::shared_ptr<LogSink> sink) {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    sink_ = sink ? std::move(sink) : std::make_shared<ConsoleSink>();
+  }
+
+  void SetRateLimit(uint32_t max_repeats, double window_seconds) {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    max_repeats_ = max_repeats;
+    window_ = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(window_seconds));
+  }
+
+ private:
+  struct Repeat {
+    Clock::time_point window_start;
+    uint32_t count = 0;
+    uint32_t suppressed = 0;
+    LogLevel level = LogLevel::Info;
+  };
+
+  void Run() {
+    Entry entry;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      const std::shared_ptr<LogSink> sink = sink_;
+      const uint32_t max_repeats = max_repeats_;
+      const Clock::duration window = window_;
+      const bool stop = stop_;
+      lock.unlock();
+
+      uint64_t popped = 0;
+      uint64_t written = 0;
+      const Clock::time_point now = Clock::now();
+      while (queue_.Pop(entry)) {
+        written += Emit(*sink, entry, max_repeats, now) ? 1 : 0;
+        ++popped;
+      }
+      if (const uint64_t dropped = dropped_.exchange(0); dropped > 0) {
+        sink->Write(LogLevel::Warn, std::to_string(dropped) +
+                                        " log messages dropped (queue full)");
+        ++written;
+      }
+      if (!repeats_.empty()) {
+        written += Sweep(*sink, window, now, stop);
+      }
+      if (written > 0) {
+        sink->Flush();
+      }
+
+      lock.lock();
+      written_ += popped;
+      written_cv_.notify_all();
+      if (stop && !queue_.HasPending()) {
+        return;
+      }
+      sleeping_.store(true);
+      wake_.wait_for(lock, kIdleWait,
+                     [&]() { return stop_ || queue_.HasPending(); });
+      sleeping_.store(false);
+    }
+  }
+
+  // Returns false when the message was suppressed.
+  bool Emit(LogSink& sink, const Entry& entry, uint32_t max_repeats,
+            Clock::time_point now) {
+    if (max_repeats > 0) {
+      const auto it = repeats_.find(entry.message);
+      if (it == repeats_.end()) {
+        if (repeats_.size() < kMaxTrackedMessages) {
+          repeats_.emplace(entry.message, Repeat{now, 1, 0, entry.level});
+        }
+      } else if (++it->second.count > max_repeats) {
+        ++it->second.suppressed;
+        return false;
+      }
+    }
+    sink.Write(entry.level, entry.message);
+    return true;
+  }
+
+  // Close windows that have ended, reporting what they suppressed.
+  uint64_t Sweep(LogSink& sink, Clock::duration window, Clock::time_point now,
+                 bool all) {
+    uint64_t written = 0;
+    for (auto it = repeats_.begin(); it != repeats_.end();) {
+      if (!all && now - it->second.window_start < window) {
+        ++it;
+        continue;
+      }
+      if (it->second.suppressed > 0) {
+        sink.Write(it->second.level,
+                   "Suppressed " + std::to_string(it->second.suppressed) +
+                       " repeats of: " + it->first);
+        ++written;
+      }
+      it = repeats_.erase(it);
+    }
+    return written;
+  }
+
+  LogQueue queue_;
+  std::atomic<uint64_t> pushed_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<bool> sleeping_{false};
+
+  std::mutex mutex_;  // Guards the fields below
+  std::condition_variable wake_;
+  std::condition_variable written_cv_;
+  std::shared_ptr<LogSink> sink_ = std::make_shared<ConsoleSink>();
+  uint32_t max_repeats_ = 5;
+  Clock::duration window_ = std::chrono::seconds(10);
+  uint64_t written_ = 0;  // Entries popped from the queue
+  bool stop_ = false;
+
+  // Writer thread only.
+  std::unordered_map<std::string, Repeat> repeats_;
+
+  std::thread writer_;  // Last, so it starts after everything it uses
+};
+
+Logger& GetLogger() {
+  static Logger logger;
+  return logger;
 }
+}  // namespace
 
 void SetLogLevel(LogLevel level) {
   g_log_level.store(static_cast<int>(level), std::memory_order_relaxed);
@@ -27,11 +293,31 @@ void Log(LogLevel level, const std::string& message) {
   if (!ShouldLog(level)) {
     return;
   }
-  if (level <= LogLevel::Warn) {
-    std::cerr << "[LiVision] " << message << std::endl;
-  } else {
-    std::cout << "[LiVision] " << message << std::endl;
-  }
+  // Errors often precede a crash or exit, so they are written right away.
+  GetLogger().Push(level, message, level == LogLevel::Error);
+}
+
+void SetLogSink(std::shared_ptr<LogSink> sink) {
+  GetLogger().SetSink(std::move(sink));
+}
+
+void SetLogRateLimit(uint32_t max_repeats, double window_seconds) {
+  GetLogger().SetRateLimit(max_repeats, window_seconds);
+}
+
+void FlushLog() { GetLogger().Flush(); }
+
+namespace internal {
+std::ostringstream& LogStream() {
+  thread_local std::ostringstream stream;
+  stream.str(std::string());
+  stream.clear();
+  stream.flags(std::ios_base::dec | std::ios_base::skipws);
+  stream.precision(6);
+  stream.width(0);
+  stream.fill(' ');
+  return stream;
 }
+}  // namespace internal
 
 }  // namespace livision
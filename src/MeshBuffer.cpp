@@ -1,13 +1,38 @@
 #include "livision/MeshBuffer.hpp"
 
-#include <unordered_set>
+#include <bx/uint32_t.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "livision/Log.hpp"
+#include "livision/internal/bvh.hpp"
+#include "livision/internal/gpu_release_queue.hpp"
+#include "livision/internal/mesh_barycentric.hpp"
 #include "livision/internal/mesh_buffer_access.hpp"
 #include "livision/internal/mesh_buffer_manager.hpp"
+#include "livision/internal/mesh_edges.hpp"
+#include "livision/internal/mesh_normals.hpp"
+#include "livision/internal/mesh_optimizer.hpp"
+#include "livision/internal/mesh_simplifier.hpp"
 
 namespace livision {
 
 struct MeshBuffer::Impl {
+  struct LodLevel {
+    std::vector<uint32_t> indices;
+    uint32_t index_count = 0;
+    bgfx::IndexBufferHandle ibh = BGFX_INVALID_HANDLE;
+  };
+  // Element range [begin, end) changed since the last upload.
+  struct Range {
+    uint32_t begin = 0;
+    uint32_t end = 0;
+  };
+
   bgfx::VertexBufferHandle vbh = BGFX_INVALID_HANDLE;
   bgfx::IndexBufferHandle ibh = BGFX_INVALID_HANDLE;
   bgfx::IndexBufferHandle wire_ibh = BGFX_INVALID_HANDLE;
@@ -15,127 +40,1005 @@ struct MeshBuffer::Impl {
   std::vector<Vertex> vertices;
   std::vector<uint32_t> indices;
   std::vector<uint32_t> wire_indices;
+  uint32_t vertex_count = 0;
+  uint32_t index_count = 0;
   bool has_uv = false;
+  bool vertices_released = false;
+  bool indices_released = false;
+  MeshBufferOptions options;
+
+  // Local-space AABB. Also serves as the quantization range.
+  Eigen::Vector3f bounds_min = Eigen::Vector3f::Zero();
+  Eigen::Vector3f bounds_max = Eigen::Vector3f::Zero();
+  bool quantized = false;
+  Eigen::Affine3d dequantize = Eigen::Affine3d::Identity();
+  Eigen::Vector4f bounding_sphere = Eigen::Vector4f::Zero();  // center, radius
+
+  // Simplified index buffers; lods[i] is LOD level i + 1.
+  std::vector<LodLevel> lods;
+  // Edits drop the LODs; they are simplified again on the next LodCount,
+  // i.e. when the renderer next selects a level, not once per edit.
+  bool lods_stale = false;
+  // A static edit was reported, see ReuploadStatic.
+  bool static_edit_logged = false;
+
+  // Dynamic buffers hold full Vertex structs and 32-bit indices so ranges
+  // can be written in place. Capacities are in elements.
+  bgfx::DynamicVertexBufferHandle dyn_vbh = BGFX_INVALID_HANDLE;
+  bgfx::DynamicIndexBufferHandle dyn_ibh = BGFX_INVALID_HANDLE;
+  bgfx::DynamicIndexBufferHandle dyn_wire_ibh = BGFX_INVALID_HANDLE;
+  uint32_t vertex_capacity = 0;
+  uint32_t index_capacity = 0;
+  uint32_t gpu_vertex_capacity = 0;
+  uint32_t gpu_index_capacity = 0;
+  uint32_t gpu_wire_capacity = 0;
+  uint32_t wire_index_count = 0;
+  std::vector<Range> dirty_vertices;
+  std::vector<Range> dirty_indices;
+  bool wire_dirty = true;
+  // wire_indices were supplied by SetWireIndices and match indices.
+  bool wire_prebuilt = false;
+
+  // Barycentric wireframe: a channel per vertex in a second stream. Split
+  // copies are appended after the first bary_base_count vertices.
+  bgfx::VertexBufferHandle bary_vbh = BGFX_INVALID_HANDLE;
+  std::vector<uint8_t> bary_channels;
+  std::vector<uint32_t> bary_sources;
+  uint32_t bary_base_count = 0;
+  bool barycentric = false;
+
+  // Packed smooth normals in a stream of their own, so the Vertex layout
+  // and meshes shaded flat stay unchanged. Split copies get their source's.
+  bgfx::VertexBufferHandle normal_vbh = BGFX_INVALID_HANDLE;
+  std::vector<uint32_t> normals;
+
+  internal::MeshRegistryHandle registry;
+  // Bytes of the static GPU buffers created so far.
+  uint64_t static_gpu_bytes = 0;
+  // Totals published for MeshBufferManager::GetStats, which runs on other
+  // threads and must not look at the vectors above.
+  std::atomic<uint64_t> cpu_bytes = 0;
+  std::atomic<uint64_t> gpu_bytes = 0;
+  // Triangle BVH for ray picking, built on the first pick after an edit.
+  std::unique_ptr<internal::MeshBvh> bvh;
+
+  void ComputeBounds();
+  void ExtendBounds(uint32_t begin, uint32_t end);
+  // Derive normals and quantization from the current host data and mark
+  // the LODs for a lazy rebuild.
+  void PrepareStatic();
+  void BuildLods();
+  // Static bgfx buffers are immutable, so an edit releases them and the
+  // next draw uploads the whole mesh. Logged once per mesh.
+  void ReuploadStatic(MeshBuffer& mesh, const char* call);
+  // Rebuild stale LODs, uploading them when the base indices already are.
+  void EnsureLods();
+  void CreateLodIndex(LodLevel& level, bool release);
+  void BuildWireIndices();
+  void FlushVertices();
+  void FlushIndices();
+  void FlushWireIndices();
+  void BuildBarycentrics();
+  // Undo vertex splitting so edits see the original vertex numbering.
+  void DropBarycentrics();
+  void CreateBarycentricVertex();
+  // Meshes that release host data cannot be split after upload, so in
+  // overlay mode they are split before their first upload.
+  void PrepareReleaseBarycentrics();
+  void CreateNormalVertex();
+  // Recompute cpu_bytes and gpu_bytes from the buffers.
+  void RefreshMemoryStats();
+
+  // Refreshes the published totals when a call that edits buffers returns.
+  struct StatsScope {
+    Impl& impl;
+    ~StatsScope() { impl.RefreshMemoryStats(); }
+  };
+
+  bool ReleaseAfterUpload() const {
+    return options.cpu_retention == CpuRetention::Release;
+  }
+  bool UseIndex16() const { return vertex_count <= 0x10000U; }
 };
 
+namespace {
+constexpr float kInt16Max = 32767.0F;
+// Index ratios of the generated LOD levels relative to the full mesh.
+constexpr float kLodRatios[] = {0.5F, 0.25F, 0.125F};
+// Meshes below this many triangles are cheap enough to always draw in full.
+constexpr size_t kMinLodTriangles = 512;
+
+// Move host data into a heap block owned by bgfx. bgfx calls the release
+// callback once the upload has consumed it, so the CPU copy does not outlive
+// the GPU upload.
+template <typename T>
+const bgfx::Memory* MakeReleasingRef(std::vector<T>& data) {
+  auto* owned = new std::vector<T>(std::move(data));
+  data = std::vector<T>();
+  return bgfx::makeRef(
+      owned->data(), static_cast<uint32_t>(owned->size() * sizeof(T)),
+      [](void* /*ptr*/, void* user_data) {
+        delete static_cast<std::vector<T>*>(user_data);
+      },
+      owned);
+}
+
+// Index data for upload: 16-bit copy when every index fits, otherwise the
+// 32-bit source is referenced directly (or handed over on release).
+const bgfx::Memory* PackIndices(std::vector<uint32_t>& indices, bool index16,
+                                bool release, uint16_t& flags) {
+  if (!index16) {
+    flags = BGFX_BUFFER_INDEX32;
+    if (release) {
+      return MakeReleasingRef(indices);
+    }
+    return bgfx::makeRef(
+        indices.data(), static_cast<uint32_t>(indices.size() * sizeof(uint32_t)));
+  }
+
+  flags = BGFX_BUFFER_NONE;
+  const bgfx::Memory* mem =
+      bgfx::alloc(static_cast<uint32_t>(indices.size() * sizeof(uint16_t)));
+  auto* dst = reinterpret_cast<uint16_t*>(mem->data);
+  for (size_t i = 0; i < indices.size(); ++i) {
+    dst[i] = static_cast<uint16_t>(indices[i]);
+  }
+  if (release) {
+    indices = std::vector<uint32_t>();
+  }
+  return mem;
+}
+
+int16_t QuantizeSnorm16(float value) {
+  const float scaled = std::round(std::clamp(value, -1.0F, 1.0F) * kInt16Max);
+  return static_cast<int16_t>(scaled);
+}
+
+// Layout matching the Vertex struct, for uploads without repacking.
+bgfx::VertexLayout FullVertexLayout() {
+  bgfx::VertexLayout layout;
+  layout.begin()
+      .add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float)
+      .add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float)
+      .end();
+  return layout;
+}
+
+// Past this many pending ranges they are merged into one upload.
+constexpr size_t kMaxDirtyRanges = 16;
+
+template <typename Range>
+void MarkDirty(std::vector<Range>& ranges, uint32_t begin, uint32_t end) {
+  for (Range& range : ranges) {
+    if (begin <= range.end && range.begin <= end) {
+      range.begin = std::min(range.begin, begin);
+      range.end = std::max(range.end, end);
+      return;
+    }
+  }
+  ranges.push_back({begin, end});
+  if (ranges.size() > kMaxDirtyRanges) {
+    Range merged = ranges.front();
+    for (const Range& range : ranges) {
+      merged.begin = std::min(merged.begin, range.begin);
+      merged.end = std::max(merged.end, range.end);
+    }
+    ranges.assign(1, merged);
+  }
+}
+
+// Queue a GPU handle for destruction on the render thread; the caller may
+// be any thread dropping the last reference to the mesh.
+template <typename Handle>
+void ReleaseHandle(Handle& handle, bool bgfx_alive) {
+  if (bgfx_alive && bgfx::isValid(handle)) {
+    internal::DeferDestroy(handle);
+  }
+  handle = BGFX_INVALID_HANDLE;
+}
+
+// Grow geometrically so steady growth reallocates only O(log n) times.
+uint32_t GrowCapacity(uint32_t current, uint32_t needed) {
+  return std::max(needed, current * 2);
+}
+}  // namespace
+
+void MeshBuffer::Impl::ComputeBounds() {
+  bounds_min = Eigen::Vector3f::Zero();
+  bounds_max = Eigen::Vector3f::Zero();
+  bounding_sphere = Eigen::Vector4f::Zero();
+  if (vertices.empty()) {
+    return;
+  }
+  bounds_min = Eigen::Vector3f::Constant(std::numeric_limits<float>::max());
+  bounds_max = Eigen::Vector3f::Constant(std::numeric_limits<float>::lowest());
+  for (const auto& v : vertices) {
+    const Eigen::Vector3f p(v.x, v.y, v.z);
+    bounds_min = bounds_min.cwiseMin(p);
+    bounds_max = bounds_max.cwiseMax(p);
+  }
+  const Eigen::Vector3f center = 0.5F * (bounds_min + bounds_max);
+  float radius_sq = 0.0F;
+  for (const auto& v : vertices) {
+    radius_sq = std::max(
+        radius_sq, (Eigen::Vector3f(v.x, v.y, v.z) - center).squaredNorm());
+  }
+  bounding_sphere << center, std::sqrt(radius_sq);
+}
+
+void MeshBuffer::Impl::ExtendBounds(uint32_t begin, uint32_t end) {
+  // Bounds only grow here; a full rescan per partial update would cost as
+  // much as uploading the whole mesh.
+  if (begin == 0 && end == vertices.size()) {
+    ComputeBounds();
+    return;
+  }
+  for (uint32_t i = begin; i < end; ++i) {
+    const Eigen::Vector3f p(vertices[i].x, vertices[i].y, vertices[i].z);
+    bounds_min = bounds_min.cwiseMin(p);
+    bounds_max = bounds_max.cwiseMax(p);
+  }
+  bounding_sphere << 0.5F * (bounds_min + bounds_max),
+      0.5F * (bounds_max - bounds_min).norm();
+}
+
+void MeshBuffer::Impl::PrepareStatic() {
+  lods.clear();
+  lods_stale = options.generate_lods;
+  quantized = false;
+  dequantize = Eigen::Affine3d::Identity();
+  normals.clear();
+  if (options.normals == MeshNormals::Smooth) {
+    normals = internal::mesh_normals::SmoothNormals(
+        {vertices.data(), vertex_count}, {indices.data(), index_count});
+  }
+
+  if (options.quantize_positions && !vertices.empty()) {
+    const Eigen::Vector3f center = 0.5F * (bounds_min + bounds_max);
+    Eigen::Vector3f half_extent = 0.5F * (bounds_max - bounds_min);
+    for (int axis = 0; axis < 3; ++axis) {
+      if (half_extent[axis] <= 0.0F) {
+        half_extent[axis] = 1.0F;
+      }
+    }
+    quantized = true;
+    dequantize = Eigen::Translation3d(center.cast<double>()) *
+                 Eigen::Scaling(Eigen::Vector3d(half_extent.cast<double>()));
+  }
+}
+
+void MeshBuffer::Impl::BuildLods() {
+  if (index_count < kMinLodTriangles * 3) {
+    return;
+  }
+  const std::vector<uint32_t>* source = &indices;
+  for (const float ratio : kLodRatios) {
+    auto target = static_cast<size_t>(static_cast<float>(index_count) * ratio);
+    target -= target % 3;
+    std::vector<uint32_t> simplified =
+        internal::mesh_simplifier::SimplifyMesh(vertices, *source, target);
+    // Stop once locked borders keep the simplifier from making progress.
+    if (simplified.empty() ||
+        simplified.size() * 10 > source->size() * 9) {
+      break;
+    }
+    internal::mesh_optimizer::OptimizeVertexCache(simplified, vertices.size());
+    LodLevel level;
+    level.index_count = static_cast<uint32_t>(simplified.size());
+    level.indices = std::move(simplified);
+    lods.push_back(std::move(level));
+    source = &lods.back().indices;
+  }
+}
+
+void MeshBuffer::Impl::ReuploadStatic(MeshBuffer& mesh, const char* call) {
+  if (!static_edit_logged) {
+    static_edit_logged = true;
+    LogMessage(LogLevel::Warn, call,
+               " on a static mesh re-uploads all of it; create the buffer "
+               "with MeshBufferOptions::dynamic for range uploads.");
+  }
+  mesh.Destroy();
+  PrepareStatic();
+}
+
+void MeshBuffer::Impl::EnsureLods() {
+  if (!lods_stale) {
+    return;
+  }
+  lods_stale = false;
+  BuildLods();
+  if (bgfx::isValid(ibh)) {
+    for (auto& level : lods) {
+      CreateLodIndex(level, false);
+    }
+  }
+}
+
+void MeshBuffer::Impl::CreateLodIndex(LodLevel& level, bool release) {
+  uint16_t flags = BGFX_BUFFER_NONE;
+  const bgfx::Memory* mem =
+      PackIndices(level.indices, UseIndex16(), release, flags);
+  static_gpu_bytes += mem->size;
+  level.ibh = bgfx::createIndexBuffer(mem, flags);
+}
+
 MeshBuffer::MeshBuffer(std::vector<Vertex> vertices,
-                       std::vector<uint32_t> indices, bool has_uv)
+                       std::vector<uint32_t> indices, bool has_uv,
+                       MeshBufferOptions options)
     : pimpl_(std::make_unique<Impl>()) {
   pimpl_->vertices = std::move(vertices);
   pimpl_->indices = std::move(indices);
+  pimpl_->vertex_count = static_cast<uint32_t>(pimpl_->vertices.size());
+  pimpl_->index_count = static_cast<uint32_t>(pimpl_->indices.size());
   pimpl_->has_uv = has_uv;
+  if (options.dynamic) {
+    options.cpu_retention = CpuRetention::Keep;
+    options.quantize_positions = false;
+    options.generate_lods = false;
+    options.normals = MeshNormals::Flat;
+  }
+  pimpl_->options = options;
+
+  pimpl_->ComputeBounds();
+  pimpl_->PrepareStatic();
+  // Loads build LODs up front, off the render thread.
+  pimpl_->EnsureLods();
+  pimpl_->RefreshMemoryStats();
+  pimpl_->registry = internal::MeshBufferManager::Register(this);
 }
 
-MeshBuffer::~MeshBuffer() { Destroy(); }
+MeshBuffer::~MeshBuffer() {
+  internal::MeshBufferManager::Unregister(pimpl_->registry);
+  Destroy();
+}
 
 void MeshBuffer::Destroy() {
-  if (!internal::MeshBufferManager::IsBgfxAlive()) {
-    pimpl_->vbh = BGFX_INVALID_HANDLE;
-    pimpl_->ibh = BGFX_INVALID_HANDLE;
-    pimpl_->wire_ibh = BGFX_INVALID_HANDLE;
+  const Impl::StatsScope stats{*pimpl_};
+  // Handles of a shut-down bgfx are already gone and are only forgotten.
+  const bool alive = internal::MeshBufferManager::IsBgfxAlive();
+  Impl& impl = *pimpl_;
+  ReleaseHandle(impl.vbh, alive);
+  ReleaseHandle(impl.ibh, alive);
+  ReleaseHandle(impl.wire_ibh, alive);
+  ReleaseHandle(impl.bary_vbh, alive);
+  ReleaseHandle(impl.normal_vbh, alive);
+  for (auto& level : impl.lods) {
+    ReleaseHandle(level.ibh, alive);
+  }
+  ReleaseHandle(impl.dyn_vbh, alive);
+  ReleaseHandle(impl.dyn_ibh, alive);
+  ReleaseHandle(impl.dyn_wire_ibh, alive);
+  impl.gpu_vertex_capacity = 0;
+  impl.gpu_index_capacity = 0;
+  impl.gpu_wire_capacity = 0;
+  impl.static_gpu_bytes = 0;
+  impl.wire_dirty = true;
+}
+
+bool MeshBuffer::HasCpuData() const {
+  return !pimpl_->vertices_released && !pimpl_->indices_released;
+}
+
+Bounds MeshBuffer::GetLocalBounds() const {
+  if (pimpl_->vertex_count == 0) {
+    return Bounds::Empty();
+  }
+  return Bounds::FromMinMax(pimpl_->bounds_min.cast<double>(),
+                            pimpl_->bounds_max.cast<double>());
+}
+
+bool MeshBuffer::IsDynamic() const { return pimpl_->options.dynamic; }
+
+void MeshBuffer::UpdateVertices(uint32_t offset,
+                                std::span<const Vertex> vertices) {
+  const Impl::StatsScope stats{*pimpl_};
+  Impl& impl = *pimpl_;
+  if (impl.vertices_released) {
+    LogMessage(LogLevel::Warn,
+               "UpdateVertices ignored: mesh CPU data was released.");
+    return;
+  }
+  if (vertices.size() > std::numeric_limits<uint32_t>::max() - offset) {
+    LogMessage(LogLevel::Warn,
+               "UpdateVertices ignored: range exceeds 2^32 vertices.");
+    return;
+  }
+  impl.DropBarycentrics();
+  impl.bvh.reset();
+  const auto end = static_cast<uint32_t>(offset + vertices.size());
+  // Writing past the end zero-fills [old count, offset), which is new data
+  // as well.
+  const uint32_t begin =
+      std::min(offset, static_cast<uint32_t>(impl.vertices.size()));
+  if (end > impl.vertices.size()) {
+    impl.vertices.resize(end);
+    impl.vertex_count = end;
+  }
+  std::copy(vertices.begin(), vertices.end(), impl.vertices.begin() + offset);
+
+  if (impl.options.dynamic) {
+    if (begin < end) {
+      impl.ExtendBounds(begin, end);
+      MarkDirty(impl.dirty_vertices, begin, end);
+    }
+    return;
+  }
+  impl.ComputeBounds();
+  impl.ReuploadStatic(*this, "UpdateVertices");
+}
+
+void MeshBuffer::UpdateIndices(uint32_t offset,
+                               std::span<const uint32_t> indices) {
+  const Impl::StatsScope stats{*pimpl_};
+  Impl& impl = *pimpl_;
+  if (impl.indices_released) {
+    LogMessage(LogLevel::Warn,
+               "UpdateIndices ignored: mesh CPU data was released.");
+    return;
+  }
+  if (indices.size() > std::numeric_limits<uint32_t>::max() - offset) {
+    LogMessage(LogLevel::Warn,
+               "UpdateIndices ignored: range exceeds 2^32 indices.");
+    return;
+  }
+  impl.DropBarycentrics();
+  impl.bvh.reset();
+  const auto end = static_cast<uint32_t>(offset + indices.size());
+  const uint32_t begin =
+      std::min(offset, static_cast<uint32_t>(impl.indices.size()));
+  if (end > impl.indices.size()) {
+    impl.indices.resize(end);
+    impl.index_count = end;
+  }
+  std::copy(indices.begin(), indices.end(), impl.indices.begin() + offset);
+  impl.wire_prebuilt = false;
+
+  if (impl.options.dynamic) {
+    if (begin < end) {
+      MarkDirty(impl.dirty_indices, begin, end);
+    }
+    impl.wire_dirty = true;
+    return;
+  }
+  impl.ReuploadStatic(*this, "UpdateIndices");
+}
+
+void MeshBuffer::Resize(uint32_t vertex_count, uint32_t index_count) {
+  const Impl::StatsScope stats{*pimpl_};
+  Impl& impl = *pimpl_;
+  if (impl.vertices_released || impl.indices_released) {
+    LogMessage(LogLevel::Warn, "Resize ignored: mesh CPU data was released.");
+    return;
+  }
+  impl.DropBarycentrics();
+  impl.bvh.reset();
+  const uint32_t old_vertex_count = impl.vertex_count;
+  const uint32_t old_index_count = impl.index_count;
+  impl.vertices.resize(vertex_count);
+  impl.indices.resize(index_count);
+  impl.vertex_count = vertex_count;
+  impl.index_count = index_count;
+  impl.wire_prebuilt &= index_count == old_index_count;
+  impl.ComputeBounds();
+
+  if (impl.options.dynamic) {
+    if (vertex_count > old_vertex_count) {
+      MarkDirty(impl.dirty_vertices, old_vertex_count, vertex_count);
+    }
+    if (index_count > old_index_count) {
+      MarkDirty(impl.dirty_indices, old_index_count, index_count);
+    }
+    impl.wire_dirty |= index_count != old_index_count;
+    return;
+  }
+  impl.ReuploadStatic(*this, "Resize");
+}
+
+void MeshBuffer::SetWireIndices(std::vector<uint32_t> wire_indices) {
+  const Impl::StatsScope stats{*pimpl_};
+  Impl& impl = *pimpl_;
+  // Overlay wireframes need no edges, and split meshes are renumbered.
+  if (impl.indices_released || impl.barycentric ||
+      (!impl.options.dynamic &&
+       internal::MeshBufferManager::UsesBarycentricWireframe())) {
     return;
   }
+  impl.wire_indices = std::move(wire_indices);
+  impl.wire_prebuilt = true;
+  impl.wire_dirty = true;
+  if (!impl.options.dynamic) {
+    ReleaseHandle(impl.wire_ibh, internal::MeshBufferManager::IsBgfxAlive());
+  }
+}
+
+void MeshBuffer::Reserve(uint32_t vertex_capacity, uint32_t index_capacity) {
+  const Impl::StatsScope stats{*pimpl_};
+  Impl& impl = *pimpl_;
+  if (impl.vertices_released || impl.indices_released) {
+    return;
+  }
+  impl.vertices.reserve(vertex_capacity);
+  impl.indices.reserve(index_capacity);
+  impl.vertex_capacity = std::max(impl.vertex_capacity, vertex_capacity);
+  impl.index_capacity = std::max(impl.index_capacity, index_capacity);
+}
 
-  if (bgfx::isValid(pimpl_->vbh)) {
-    bgfx::destroy(pimpl_->vbh);
-    pimpl_->vbh = BGFX_INVALID_HANDLE;
+void MeshBuffer::Impl::FlushVertices() {
+  if (vertex_count == 0) {
+    return;
   }
-  if (bgfx::isValid(pimpl_->ibh)) {
-    bgfx::destroy(pimpl_->ibh);
-    pimpl_->ibh = BGFX_INVALID_HANDLE;
+  const uint32_t needed = std::max(vertex_count, vertex_capacity);
+  if (!bgfx::isValid(dyn_vbh) || gpu_vertex_capacity < needed) {
+    if (bgfx::isValid(dyn_vbh)) {
+      bgfx::destroy(dyn_vbh);
+    }
+    gpu_vertex_capacity = GrowCapacity(gpu_vertex_capacity, needed);
+    dyn_vbh = bgfx::createDynamicVertexBuffer(gpu_vertex_capacity,
+                                              FullVertexLayout());
+    dirty_vertices.assign(1, Range{0, vertex_count});
   }
-  if (bgfx::isValid(pimpl_->wire_ibh)) {
-    bgfx::destroy(pimpl_->wire_ibh);
-    pimpl_->wire_ibh = BGFX_INVALID_HANDLE;
+  for (const Range& range : dirty_vertices) {
+    const uint32_t end = std::min(range.end, vertex_count);
+    if (range.begin < end) {
+      bgfx::update(dyn_vbh, range.begin,
+                   bgfx::copy(vertices.data() + range.begin,
+                              (end - range.begin) * sizeof(Vertex)));
+    }
   }
+  dirty_vertices.clear();
+}
+
+void MeshBuffer::Impl::FlushIndices() {
+  if (index_count == 0) {
+    return;
+  }
+  const uint32_t needed = std::max(index_count, index_capacity);
+  if (!bgfx::isValid(dyn_ibh) || gpu_index_capacity < needed) {
+    if (bgfx::isValid(dyn_ibh)) {
+      bgfx::destroy(dyn_ibh);
+    }
+    gpu_index_capacity = GrowCapacity(gpu_index_capacity, needed);
+    dyn_ibh =
+        bgfx::createDynamicIndexBuffer(gpu_index_capacity, BGFX_BUFFER_INDEX32);
+    dirty_indices.assign(1, Range{0, index_count});
+  }
+  for (const Range& range : dirty_indices) {
+    const uint32_t end = std::min(range.end, index_count);
+    if (range.begin < end) {
+      bgfx::update(dyn_ibh, range.begin,
+                   bgfx::copy(indices.data() + range.begin,
+                              (end - range.begin) * sizeof(uint32_t)));
+    }
+  }
+  dirty_indices.clear();
+}
+
+void MeshBuffer::Impl::FlushWireIndices() {
+  if (!wire_dirty) {
+    return;
+  }
+  // Edges depend on the whole triangle list, so they are rebuilt together.
+  BuildWireIndices();
+  wire_dirty = false;
+  wire_index_count = static_cast<uint32_t>(wire_indices.size());
+  if (wire_index_count == 0) {
+    return;
+  }
+  if (!bgfx::isValid(dyn_wire_ibh) || gpu_wire_capacity < wire_index_count) {
+    if (bgfx::isValid(dyn_wire_ibh)) {
+      bgfx::destroy(dyn_wire_ibh);
+    }
+    gpu_wire_capacity = GrowCapacity(gpu_wire_capacity, wire_index_count);
+    dyn_wire_ibh =
+        bgfx::createDynamicIndexBuffer(gpu_wire_capacity, BGFX_BUFFER_INDEX32);
+  }
+  bgfx::update(dyn_wire_ibh, 0,
+               bgfx::copy(wire_indices.data(),
+                          wire_index_count * sizeof(uint32_t)));
 }
 
 void MeshBuffer::CreateVertex() {
-  if (bgfx::isValid(pimpl_->vbh)) {
+  const Impl::StatsScope stats{*pimpl_};
+  if (pimpl_->options.dynamic) {
+    pimpl_->FlushVertices();
+    return;
+  }
+  pimpl_->PrepareReleaseBarycentrics();
+  if (bgfx::isValid(pimpl_->vbh) || pimpl_->vertices_released ||
+      pimpl_->vertices.empty()) {
+    return;
+  }
+  const bool release = pimpl_->ReleaseAfterUpload();
+  if (pimpl_->barycentric) {
+    pimpl_->CreateBarycentricVertex();
+  }
+  if (!pimpl_->normals.empty()) {
+    pimpl_->CreateNormalVertex();
+  }
+
+  // Full-precision position + UV matches the Vertex struct, so it can be
+  // uploaded without repacking.
+  if (!pimpl_->quantized && pimpl_->has_uv) {
+    const bgfx::VertexLayout layout = FullVertexLayout();
+    const bgfx::Memory* mem =
+        release ? MakeReleasingRef(pimpl_->vertices)
+                : bgfx::makeRef(pimpl_->vertices.data(),
+                                pimpl_->vertices.size() * sizeof(Vertex));
+    pimpl_->static_gpu_bytes += mem->size;
+    pimpl_->vbh = bgfx::createVertexBuffer(mem, layout);
+    pimpl_->vertices_released = release;
     return;
   }
-  bgfx::VertexLayout vec3_vlayout;
-  vec3_vlayout.begin()
-      .add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float)
-      .add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float)
-      .end();
 
-  pimpl_->vbh = bgfx::createVertexBuffer(
-      bgfx::makeRef(pimpl_->vertices.data(),
-                    pimpl_->vertices.size() * sizeof(Vertex)),
-      vec3_vlayout);
+  // Compact stream: UVs are skipped when absent, quantized meshes store
+  // positions as snorm16 relative to their bounds (restored by the model
+  // matrix) and UVs as half floats when the backend supports them.
+  const bool half_uv =
+      pimpl_->quantized && pimpl_->has_uv &&
+      (bgfx::getCaps()->supported & BGFX_CAPS_VERTEX_ATTRIB_HALF) != 0U;
+  bgfx::VertexLayout layout;
+  layout.begin();
+  if (pimpl_->quantized) {
+    layout.add(bgfx::Attrib::Position, 4, bgfx::AttribType::Int16, true);
+  } else {
+    layout.add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float);
+  }
+  if (pimpl_->has_uv) {
+    layout.add(bgfx::Attrib::TexCoord0, 2,
+               half_uv ? bgfx::AttribType::Half : bgfx::AttribType::Float);
+  }
+  layout.end();
+
+  const uint16_t stride = layout.getStride();
+  const bgfx::Memory* mem =
+      bgfx::alloc(static_cast<uint32_t>(pimpl_->vertices.size()) * stride);
+  const Eigen::Affine3f quantize =
+      pimpl_->dequantize.inverse().cast<float>();
+  uint8_t* dst = mem->data;
+  for (const auto& v : pimpl_->vertices) {
+    uint8_t* cursor = dst;
+    if (pimpl_->quantized) {
+      const Eigen::Vector3f q = quantize * Eigen::Vector3f(v.x, v.y, v.z);
+      const int16_t packed[4] = {QuantizeSnorm16(q.x()),
+                                 QuantizeSnorm16(q.y()),
+                                 QuantizeSnorm16(q.z()), 0};
+      std::memcpy(cursor, packed, sizeof(packed));
+      cursor += sizeof(packed);
+    } else {
+      const float packed[3] = {v.x, v.y, v.z};
+      std::memcpy(cursor, packed, sizeof(packed));
+      cursor += sizeof(packed);
+    }
+    if (pimpl_->has_uv) {
+      if (half_uv) {
+        const uint16_t packed[2] = {bx::halfFromFloat(v.u),
+                                    bx::halfFromFloat(v.v)};
+        std::memcpy(cursor, packed, sizeof(packed));
+      } else {
+        const float packed[2] = {v.u, v.v};
+        std::memcpy(cursor, packed, sizeof(packed));
+      }
+    }
+    dst += stride;
+  }
+  pimpl_->static_gpu_bytes += mem->size;
+  pimpl_->vbh = bgfx::createVertexBuffer(mem, layout);
+
+  if (release) {
+    pimpl_->vertices = std::vector<Vertex>();
+    pimpl_->vertices_released = true;
+  }
 }
 
 void MeshBuffer::CreateIndex() {
-  if (bgfx::isValid(pimpl_->ibh)) {
+  const Impl::StatsScope stats{*pimpl_};
+  if (pimpl_->options.dynamic) {
+    pimpl_->FlushIndices();
+    return;
+  }
+  pimpl_->PrepareReleaseBarycentrics();
+  if (bgfx::isValid(pimpl_->ibh) || pimpl_->indices_released ||
+      pimpl_->indices.empty()) {
     return;
   }
 
-  pimpl_->ibh = bgfx::createIndexBuffer(
-      bgfx::makeRef(pimpl_->indices.data(),
-                    pimpl_->indices.size() * sizeof(uint32_t)),
-      BGFX_BUFFER_INDEX32);
+  // Simplifies from the host indices, which the upload may hand over.
+  pimpl_->EnsureLods();
+  const bool release = pimpl_->ReleaseAfterUpload();
+  if (release && pimpl_->options.keep_wireframe && !pimpl_->barycentric) {
+    // Wireframe edges are derived from the triangle list, so they have to be
+    // built before the host indices go away.
+    CreateWireIndex();
+  }
+  uint16_t flags = BGFX_BUFFER_NONE;
+  const bgfx::Memory* mem =
+      PackIndices(pimpl_->indices, pimpl_->UseIndex16(), release, flags);
+  pimpl_->static_gpu_bytes += mem->size;
+  pimpl_->ibh = bgfx::createIndexBuffer(mem, flags);
+  for (auto& level : pimpl_->lods) {
+    pimpl_->CreateLodIndex(level, release);
+  }
+  if (release) {
+    pimpl_->indices_released = true;
+  }
 }
 
-void MeshBuffer::CreateWireIndex() {
-  if (bgfx::isValid(pimpl_->wire_ibh)) {
+void MeshBuffer::Impl::BuildWireIndices() {
+  if (wire_prebuilt) {
     return;
   }
+  // Loaded models come with edges extracted on the loading thread; this
+  // serial fallback only runs for meshes built in user code.
+  wire_indices =
+      internal::mesh_edges::ExtractEdges({indices.data(), index_count});
+}
 
-  // Build wireframe index buffer (unique edges)
-  pimpl_->wire_indices.reserve(pimpl_->indices.size() * 2);
-  std::unordered_set<uint64_t> seen_edges;
-  seen_edges.reserve(pimpl_->indices.size());
+void MeshBuffer::Impl::BuildBarycentrics() {
+  if (barycentric || vertex_count == 0 || index_count == 0) {
+    return;
+  }
+  internal::mesh_barycentric::Channels result =
+      internal::mesh_barycentric::AssignChannels(vertex_count, indices);
+  bary_base_count = vertex_count;
+  vertices.reserve(vertices.size() + result.split_sources.size());
+  for (const uint32_t source : result.split_sources) {
+    vertices.push_back(vertices[source]);
+    if (!normals.empty()) {
+      normals.push_back(normals[source]);
+    }
+  }
+  vertex_count = static_cast<uint32_t>(vertices.size());
+  bary_channels = std::move(result.channels);
+  bary_sources = std::move(result.split_sources);
+  barycentric = true;
+  // The overlay replaces the edge list.
+  wire_indices = std::vector<uint32_t>();
+  wire_prebuilt = false;
+}
 
-  auto add_edge = [&](uint32_t a, uint32_t b) {
-    if (a == b) return;
-    uint32_t lo = (a < b) ? a : b;
-    uint32_t hi = (a < b) ? b : a;
-    uint64_t key = (static_cast<uint64_t>(lo) << 32) | hi;
-    if (seen_edges.insert(key).second) {
-      pimpl_->wire_indices.push_back(lo);
-      pimpl_->wire_indices.push_back(hi);
+void MeshBuffer::Impl::DropBarycentrics() {
+  if (!barycentric) {
+    return;
+  }
+  for (uint32_t& index : indices) {
+    if (index >= bary_base_count) {
+      index = bary_sources[index - bary_base_count];
     }
-  };
+  }
+  vertices.resize(bary_base_count);
+  if (!normals.empty()) {
+    normals.resize(bary_base_count);
+  }
+  vertex_count = bary_base_count;
+  bary_channels = std::vector<uint8_t>();
+  bary_sources = std::vector<uint32_t>();
+  barycentric = false;
+}
 
-  for (size_t i = 0; i + 2 < pimpl_->indices.size(); i += 3) {
-    uint32_t i0 = pimpl_->indices[i];
-    uint32_t i1 = pimpl_->indices[i + 1];
-    uint32_t i2 = pimpl_->indices[i + 2];
-    add_edge(i0, i1);
-    add_edge(i1, i2);
-    add_edge(i2, i0);
+void MeshBuffer::Impl::CreateBarycentricVertex() {
+  static const bgfx::VertexLayout layout = []() {
+    bgfx::VertexLayout l;
+    l.begin().add(bgfx::Attrib::Color1, 4, bgfx::AttribType::Uint8, true).end();
+    return l;
+  }();
+  const bgfx::Memory* mem =
+      bgfx::alloc(static_cast<uint32_t>(bary_channels.size()) * 4);
+  std::memset(mem->data, 0, mem->size);
+  for (size_t i = 0; i < bary_channels.size(); ++i) {
+    mem->data[(i * 4) + bary_channels[i]] = 255U;
+  }
+  static_gpu_bytes += mem->size;
+  bary_vbh = bgfx::createVertexBuffer(mem, layout);
+  if (ReleaseAfterUpload()) {
+    bary_channels = std::vector<uint8_t>();
+    bary_sources = std::vector<uint32_t>();
+  }
+}
+
+void MeshBuffer::Impl::CreateNormalVertex() {
+  static const bgfx::VertexLayout layout = []() {
+    bgfx::VertexLayout l;
+    l.begin().add(bgfx::Attrib::Normal, 4, bgfx::AttribType::Uint8, true).end();
+    return l;
+  }();
+  // Copied, as vertex splitting may still append to the host array.
+  const bgfx::Memory* mem = bgfx::copy(
+      normals.data(), static_cast<uint32_t>(normals.size() * sizeof(uint32_t)));
+  static_gpu_bytes += mem->size;
+  normal_vbh = bgfx::createVertexBuffer(mem, layout);
+  if (ReleaseAfterUpload()) {
+    normals = std::vector<uint32_t>();
+  }
+}
+
+void MeshBuffer::Impl::RefreshMemoryStats() {
+  uint64_t cpu = (vertices.capacity() * sizeof(Vertex)) +
+                 ((indices.capacity() + wire_indices.capacity() +
+                   bary_sources.capacity() + normals.capacity()) *
+                  sizeof(uint32_t)) +
+                 bary_channels.capacity();
+  if (bvh) {
+    cpu += bvh->Bytes();
+  }
+  for (const auto& level : lods) {
+    cpu += level.indices.capacity() * sizeof(uint32_t);
+  }
+  cpu_bytes.store(cpu, std::memory_order_relaxed);
+  gpu_bytes.store(static_gpu_bytes +
+                      (uint64_t{gpu_vertex_capacity} * sizeof(Vertex)) +
+                      ((uint64_t{gpu_index_capacity} + gpu_wire_capacity) *
+                       sizeof(uint32_t)),
+                  std::memory_order_relaxed);
+}
+
+void MeshBuffer::Impl::PrepareReleaseBarycentrics() {
+  if (!barycentric && ReleaseAfterUpload() && !vertices_released &&
+      !indices_released &&
+      internal::MeshBufferManager::UsesBarycentricWireframe()) {
+    BuildBarycentrics();
+  }
+}
+
+void MeshBuffer::CreateWireIndex() {
+  const Impl::StatsScope stats{*pimpl_};
+  if (pimpl_->options.dynamic) {
+    pimpl_->FlushWireIndices();
+    return;
+  }
+  if (bgfx::isValid(pimpl_->wire_ibh) || pimpl_->indices_released) {
+    return;
+  }
+
+  pimpl_->BuildWireIndices();
+  if (pimpl_->wire_indices.empty()) {
+    return;
   }
 
-  pimpl_->wire_ibh = bgfx::createIndexBuffer(
-      bgfx::makeRef(pimpl_->wire_indices.data(),
-                    pimpl_->wire_indices.size() * sizeof(uint32_t)),
-      BGFX_BUFFER_INDEX32);
+  uint16_t flags = BGFX_BUFFER_NONE;
+  const bgfx::Memory* mem =
+      PackIndices(pimpl_->wire_indices, pimpl_->UseIndex16(),
+                  pimpl_->ReleaseAfterUpload(), flags);
+  pimpl_->static_gpu_bytes += mem->size;
+  pimpl_->wire_ibh = bgfx::createIndexBuffer(mem, flags);
 }
 
 namespace internal {
 
-bgfx::VertexBufferHandle MeshBufferAccess::VertexBuffer(MeshBuffer& mesh) {
+bool MeshBufferAccess::SetBuffers(MeshBuffer& mesh, uint32_t lod) {
+  mesh.CreateVertex();
+  mesh.CreateIndex();
+  const MeshBuffer::Impl& impl = *mesh.pimpl_;
+  if (impl.options.dynamic) {
+    if (impl.vertex_count == 0 || impl.index_count == 0 ||
+        !bgfx::isValid(impl.dyn_vbh) || !bgfx::isValid(impl.dyn_ibh)) {
+      return false;
+    }
+    bgfx::setVertexBuffer(0, impl.dyn_vbh, 0, impl.vertex_count);
+    bgfx::setIndexBuffer(impl.dyn_ibh, 0, impl.index_count);
+    return true;
+  }
+
+  const bgfx::IndexBufferHandle ibh =
+      (lod == 0 || lod > impl.lods.size()) ? impl.ibh : impl.lods[lod - 1].ibh;
+  if (!bgfx::isValid(impl.vbh) || !bgfx::isValid(ibh)) {
+    return false;
+  }
+  bgfx::setVertexBuffer(0, impl.vbh);
+  bgfx::setIndexBuffer(ibh);
+  return true;
+}
+
+bool MeshBufferAccess::SetWireBuffers(MeshBuffer& mesh) {
+  mesh.CreateVertex();
+  mesh.CreateWireIndex();
+  const MeshBuffer::Impl& impl = *mesh.pimpl_;
+  if (impl.options.dynamic) {
+    if (impl.vertex_count == 0 || impl.wire_index_count == 0 ||
+        !bgfx::isValid(impl.dyn_vbh) || !bgfx::isValid(impl.dyn_wire_ibh)) {
+      return false;
+    }
+    bgfx::setVertexBuffer(0, impl.dyn_vbh, 0, impl.vertex_count);
+    bgfx::setIndexBuffer(impl.dyn_wire_ibh, 0, impl.wire_index_count);
+    return true;
+  }
+  if (!bgfx::isValid(impl.vbh) || !bgfx::isValid(impl.wire_ibh)) {
+    return false;
+  }
+  bgfx::setVertexBuffer(0, impl.vbh);
+  bgfx::setIndexBuffer(impl.wire_ibh);
+  return true;
+}
+
+bool MeshBufferAccess::SetBarycentricBuffers(MeshBuffer& mesh) {
+  MeshBuffer::Impl& impl = *mesh.pimpl_;
+  if (impl.options.dynamic) {
+    return false;
+  }
+  if (!impl.barycentric) {
+    if (!mesh.HasCpuData()) {
+      return false;
+    }
+    // Splitting renumbers vertices, so buffers uploaded before are rebuilt.
+    mesh.Destroy();
+    impl.BuildBarycentrics();
+  }
   mesh.CreateVertex();
-  return mesh.pimpl_->vbh;
+  mesh.CreateIndex();
+  if (!bgfx::isValid(impl.vbh) || !bgfx::isValid(impl.bary_vbh) ||
+      !bgfx::isValid(impl.ibh)) {
+    return false;
+  }
+  bgfx::setVertexBuffer(0, impl.vbh);
+  bgfx::setVertexBuffer(1, impl.bary_vbh);
+  bgfx::setIndexBuffer(impl.ibh);
+  return true;
 }
 
-bgfx::IndexBufferHandle MeshBufferAccess::IndexBuffer(MeshBuffer& mesh) {
+bool MeshBufferAccess::SetNormalBuffers(MeshBuffer& mesh, uint32_t lod) {
+  const MeshBuffer::Impl& impl = *mesh.pimpl_;
+  if (impl.options.normals != MeshNormals::Smooth || impl.options.dynamic) {
+    return false;
+  }
+  mesh.CreateVertex();
   mesh.CreateIndex();
-  return mesh.pimpl_->ibh;
+  const bgfx::IndexBufferHandle ibh =
+      (lod == 0 || lod > impl.lods.size()) ? impl.ibh : impl.lods[lod - 1].ibh;
+  if (!bgfx::isValid(impl.vbh) || !bgfx::isValid(impl.normal_vbh) ||
+      !bgfx::isValid(ibh)) {
+    return false;
+  }
+  bgfx::setVertexBuffer(0, impl.vbh);
+  bgfx::setVertexBuffer(1, impl.normal_vbh);
+  bgfx::setIndexBuffer(ibh);
+  return true;
 }
 
-bgfx::IndexBufferHandle MeshBufferAccess::WireIndexBuffer(MeshBuffer& mesh) {
-  mesh.CreateWireIndex();
-  return mesh.pimpl_->wire_ibh;
+MeshRegistryHandle MeshBufferAccess::RegistryHandle(const MeshBuffer& mesh) {
+  return mesh.pimpl_->registry;
 }
 
-uint32_t MeshBufferAccess::GetIndexCount(MeshBuffer& mesh) {
-  return static_cast<uint32_t>(mesh.pimpl_->indices.size());
+uint64_t MeshBufferAccess::CpuBytes(const MeshBuffer& mesh) {
+  return mesh.pimpl_->cpu_bytes.load(std::memory_order_relaxed);
+}
+
+uint64_t MeshBufferAccess::GpuBytes(const MeshBuffer& mesh) {
+  return mesh.pimpl_->gpu_bytes.load(std::memory_order_relaxed);
 }
 
 bool MeshBufferAccess::HasUV(MeshBuffer& mesh) { return mesh.pimpl_->has_uv; }
 
+bool MeshBufferAccess::IsQuantized(MeshBuffer& mesh) {
+  return mesh.pimpl_->quantized;
+}
+
+const Eigen::Affine3d& MeshBufferAccess::DequantizeMatrix(MeshBuffer& mesh) {
+  return mesh.pimpl_->dequantize;
+}
+
+const Eigen::Vector4f& MeshBufferAccess::BoundingSphere(MeshBuffer& mesh) {
+  return mesh.pimpl_->bounding_sphere;
+}
+
+uint32_t MeshBufferAccess::LodCount(MeshBuffer& mesh) {
+  const MeshBuffer::Impl::StatsScope stats{*mesh.pimpl_};
+  mesh.pimpl_->EnsureLods();
+  return static_cast<uint32_t>(mesh.pimpl_->lods.size()) + 1U;
+}
+
+const MeshBvh* MeshBufferAccess::Bvh(MeshBuffer& mesh) {
+  MeshBuffer::Impl& impl = *mesh.pimpl_;
+  if (!impl.bvh && mesh.HasCpuData()) {
+    impl.bvh = std::make_unique<MeshBvh>(impl.vertices, impl.indices);
+    impl.RefreshMemoryStats();
+  }
+  return impl.bvh.get();
+}
+
 }  // namespace internal
 
+MeshBufferStats GetMeshBufferStats() {
+  return internal::MeshBufferManager::GetStats();
+}
+
 }  // namespace livision
@@ -1,12 +1,14 @@
 #include "livision/ObjectBase.hpp"
 
 #include "livision/Renderer.hpp"
+#include "livision/internal/mesh_buffer_access.hpp"
 
 namespace livision {
 void ObjectBase::OnDraw(Renderer& renderer) {
   if (mesh_buf_)
     renderer.Submit(*mesh_buf_, global_mtx_, params_.color, params_.texture,
-                    params_.wire_color);
+                    params_.wire_color,
+                    renderer.SelectLod(*mesh_buf_, global_mtx_));
 }
 
 void ObjectBase::Init() {
@@ -35,12 +37,47 @@ void ObjectBase::UpdateMatrix(const Eigen::Affine3d& parent_mtx) {
     local_mtx_changed_ = false;
   }
   global_mtx_ = parent_mtx * local_mtx_;
+  world_bounds_ = GetLocalBounds().Transformed(global_mtx_);
+}
+
+Bounds ObjectBase::GetLocalBounds() const {
+  return mesh_buf_ ? mesh_buf_->GetLocalBounds() : Bounds::Infinite();
+}
+
+bool ObjectBase::IntersectRay(const Eigen::Vector3d& origin,
+                              const Eigen::Vector3d& direction,
+                              double& distance) const {
+  if (!mesh_buf_) {
+    return false;
+  }
+  const internal::MeshBvh* bvh = internal::MeshBufferAccess::Bvh(*mesh_buf_);
+  if (!bvh) {
+    return world_bounds_.IntersectRay(origin, direction, distance);
+  }
+  // The ray is moved into mesh space without renormalizing, so the ray
+  // parameter stays a world-space distance under any scale.
+  const Eigen::Affine3d to_local = global_mtx_.inverse();
+  if (!to_local.matrix().allFinite()) {
+    return false;
+  }
+  internal::MeshBvh::Hit hit;
+  if (!bvh->Intersect((to_local * origin).cast<float>(),
+                      (to_local.linear() * direction).cast<float>(),
+                      static_cast<float>(distance), hit)) {
+    return false;
+  }
+  distance = hit.t;
+  return true;
 }
 
 ObjectBase* ObjectBase::SetParams(const Params& params) {
+  std::string old_name = std::move(name_);
   params_ = params;
   name_ = params_.name;
   local_mtx_changed_ = true;
+  if (parent_object_ && name_ != old_name) {
+    parent_object_->OnChildRenamed(*this, old_name);
+  }
   return this;
 }
 
@@ -101,13 +138,21 @@ ObjectBase* ObjectBase::SetWireColor(const Color& color) {
   return this;
 }
 ObjectBase* ObjectBase::SetName(const std::string& name) {
+  if (name == name_) {
+    return this;
+  }
+  std::string old_name = std::move(name_);
   name_ = name;
   params_.name = name;
+  if (parent_object_) {
+    parent_object_->OnChildRenamed(*this, old_name);
+  }
   return this;
 }
 
 ObjectBase* ObjectBase::SetGlobalMatrix(const Eigen::Affine3d& mtx) {
   global_mtx_ = mtx;
+  world_bounds_ = GetLocalBounds().Transformed(global_mtx_);
   return this;
 }
 
@@ -124,6 +169,8 @@ Eigen::Vector3d ObjectBase::GetGlobalPos() { return global_mtx_.translation(); }
 
 Eigen::Affine3d ObjectBase::GetGlobalMatrix() const { return global_mtx_; }
 
+const Bounds& ObjectBase::GetWorldBounds() const { return world_bounds_; }
+
 const std::string& ObjectBase::GetName() const { return name_; }
 
 void ObjectBase::RegisterParentObject(ObjectBase* obj) { parent_object_ = obj; }
@@ -3,61 +3,381 @@
 #include <bgfx/bgfx.h>
 #include <bgfx/defines.h>
 #include <bgfx/platform.h>
-#include <bimg/decode.h>
-#include <bx/allocator.h>
 #include <bx/math.h>
 
+#include <algorithm>
+#include <array>
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "livision/Log.hpp"
-#include "livision/imgui/imstb_truetype.h"
 #include "livision/internal/file_ops.hpp"
+#include "livision/internal/glyph_atlas.hpp"
+#include "livision/internal/gpu_release_queue.hpp"
 #include "livision/internal/mesh_buffer_access.hpp"
+#include "livision/internal/mesh_buffer_manager.hpp"
+#include "livision/internal/shader_variants.hpp"
+#include "livision/internal/texture_loader.hpp"
 
 namespace livision {
 
 static constexpr uint64_t kAlphaState =
     BGFX_STATE_DEFAULT | BGFX_STATE_BLEND_ALPHA;
 static constexpr uint64_t kPointState = kAlphaState | BGFX_STATE_PT_POINTS;
+// Edges drawn over an earlier fill pass share its depth.
+static constexpr uint64_t kOverlayState =
+    (kAlphaState & ~BGFX_STATE_DEPTH_TEST_MASK) | BGFX_STATE_DEPTH_TEST_LEQUAL;
 static constexpr uint64_t kPointSpriteState =
     kAlphaState | BGFX_STATE_PT_TRISTRIP;
+// Bounds the per-frame texture creation cost when many loads finish at once.
+static constexpr uint32_t kMaxTextureUploadsPerFrame = 4;
+// 16-bit indices limit a text draw to 65536 vertices.
+static constexpr uint32_t kMaxTextQuadsPerDraw = 0x10000 / 4;
+static constexpr uint64_t kTextLayoutEvictFrames = 300;
+// Declutter grid cell size, and how far outside the view (in NDC) a label
+// anchor may be before the label is skipped outright.
+static constexpr int kLabelCellPixels = 64;
+static constexpr double kLabelCullMargin = 1.5;
+
+// Selection outlines are drawn over the main view. The GPU pick ID pass
+// renders a small region around the cursor, then is copied out for readback
+// in a later view, as blits run before the draws of their view.
+static constexpr bgfx::ViewId kOutlineView = 1;
+static constexpr bgfx::ViewId kPickView = 2;
+static constexpr bgfx::ViewId kPickBlitView = 3;
+// Odd, so the requested pixel is the center texel.
+static constexpr uint16_t kPickSize = 9;
+static constexpr uint64_t kPickState = BGFX_STATE_DEFAULT;
+static constexpr uint64_t kOutlineState =
+    BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_BLEND_ALPHA |
+    BGFX_STATE_MSAA;
+// Fills of highlighted objects mark their silhouette, hidden parts included;
+// the enlarged outline copy is then drawn only outside it.
+static constexpr uint32_t kOutlineMaskStencil =
+    BGFX_STENCIL_TEST_ALWAYS | BGFX_STENCIL_FUNC_REF(1) |
+    BGFX_STENCIL_FUNC_RMASK(0xFF) | BGFX_STENCIL_OP_FAIL_S_REPLACE |
+    BGFX_STENCIL_OP_FAIL_Z_REPLACE | BGFX_STENCIL_OP_PASS_Z_REPLACE;
+static constexpr uint32_t kOutlineStencil =
+    BGFX_STENCIL_TEST_NOTEQUAL | BGFX_STENCIL_FUNC_REF(1) |
+    BGFX_STENCIL_FUNC_RMASK(0xFF) | BGFX_STENCIL_OP_FAIL_S_KEEP |
+    BGFX_STENCIL_OP_FAIL_Z_KEEP | BGFX_STENCIL_OP_PASS_Z_KEEP;
+// Upper bound on the outline scale for very small or distant meshes.
+static constexpr double kMaxOutlineScale = 4.0;
 
 struct Renderer::Impl {
+  struct TextVertex {
+    float x;
+    float y;
+    float z;
+    float u;
+    float v;
+    uint32_t abgr;
+    float rainbow[4];  // xyz: direction * delta, w: 1 for rainbow
+  };
+
+  // Glyph quad in atlas pixels relative to the label origin, y up.
+  struct GlyphQuad {
+    float x0, y0, x1, y1;
+    float s0, t0, s1, t1;
+    uint16_t page;
+  };
+
+  struct TextLayout {
+    std::vector<GlyphQuad> quads;
+    // Bounds of all quads, for screen-space declutter.
+    float min_x = 0.0F;
+    float min_y = 0.0F;
+    float max_x = 0.0F;
+    float max_y = 0.0F;
+    uint64_t last_used_frame = 0;
+  };
+
+  struct StringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view str) const {
+      return std::hash<std::string_view>{}(str);
+    }
+  };
+  using TextLayoutMap =
+      std::unordered_map<std::string, TextLayout, StringHash, std::equal_to<>>;
+
+  // Per-label color state, used only when the batched text shader is missing.
+  struct TextRun {
+    uint32_t first_quad;
+    uint32_t quad_count;
+    float color[4];
+    float mode[4];
+    float rainbow[4];
+  };
+
+  // Billboard glyph instance; the vertex shader expands it around the anchor
+  // along the camera axes.
+  struct GlyphInstance {
+    float anchor[4];
+    float rect[4];  // Local rect scaled to world units
+    float uv[4];
+    float color[4];
+    float rainbow[4];
+  };
+
+  // Quads of all labels sharing an atlas page and depth mode, drawn at
+  // EndFrame.
+  struct TextBatch {
+    std::vector<TextVertex> vertices;
+    std::vector<TextRun> runs;
+    std::vector<GlyphInstance> billboards;
+  };
+
   struct FontAtlas {
-    bgfx::TextureHandle texture = BGFX_INVALID_HANDLE;
-    int width = 0;
-    int height = 0;
-    int pixel_height = 0;
-    stbtt_bakedchar glyphs[96] = {};
+    internal::GlyphAtlas glyphs;
+    TextLayoutMap layouts[3];  // Indexed by TextAlign
+    // Indexed by glyph page, then TextDepthMode.
+    std::vector<std::array<TextBatch, 2>> batches;
+
+    TextBatch& Batch(uint16_t page, TextDepthMode depth_mode) {
+      if (page >= batches.size()) {
+        batches.resize(page + 1);
+      }
+      return batches[page][static_cast<int>(depth_mode)];
+    }
   };
 
-  bgfx::ProgramHandle program;
-  bgfx::ProgramHandle textured_program;
-  bgfx::ProgramHandle instancing_program;
+  // Label held back until EndFrame so overlaps can be resolved by priority.
+  struct PendingLabel {
+    FontAtlas* atlas;
+    const TextLayout* layout;
+    Eigen::Affine3d mtx;
+    Color color;
+    float height;
+    TextFacingMode facing_mode;
+    TextDepthMode depth_mode;
+    int priority;
+    Eigen::Vector4d clip;  // Anchor in clip space
+    uint32_t pick_id = 0;  // 0 when outside the pick region
+    bool highlighted = false;
+  };
+
+  struct ScreenRect {
+    double x0, y0, x1, y1;
+  };
+
+  // Mesh, textured, point and lit programs by feature mask.
+  internal::ShaderVariantCache shaders;
+  bgfx::ProgramHandle wireframe_program = BGFX_INVALID_HANDLE;
+  bgfx::ProgramHandle text_program = BGFX_INVALID_HANDLE;
+  bgfx::ProgramHandle text_billboard_program = BGFX_INVALID_HANDLE;
+  bgfx::VertexBufferHandle glyph_quad_vbh = BGFX_INVALID_HANDLE;
+  bgfx::IndexBufferHandle glyph_quad_ibh = BGFX_INVALID_HANDLE;
 
   bgfx::UniformHandle u_color;
   bgfx::UniformHandle u_color_mode;
   bgfx::UniformHandle u_rainbow_params;
   bgfx::UniformHandle s_texture;
+  bgfx::UniformHandle u_text_axes;
+  bgfx::UniformHandle u_wire_color;
+  bgfx::UniformHandle u_wire_rainbow;
+  bgfx::UniformHandle u_wire_params;
+
+  struct CachedTexture {
+    bgfx::TextureHandle handle = BGFX_INVALID_HANDLE;
+    uint32_t bytes = 0;
+    uint64_t last_used_frame = 0;
+  };
 
-  std::unordered_map<std::string, bgfx::TextureHandle> texture_cache;
+  // Finished loads; an invalid handle marks a texture that failed to load.
+  std::unordered_map<std::string, CachedTexture> texture_cache;
+  std::unordered_set<std::string> pending_textures;
+  uint64_t texture_bytes = 0;
+  uint64_t texture_budget_bytes = 0;
+  uint32_t texture_evict_frames = 0;
+  uint32_t gpu_releases_per_frame = 0;
+  uint64_t frame_index = 0;
+  internal::TextureLoader texture_loader;
+  bgfx::TextureHandle placeholder_texture = BGFX_INVALID_HANDLE;
   std::unordered_map<std::string, FontAtlas> font_cache;
+  // Font path as passed to SubmitText -> atlas, nullptr if unavailable.
+  std::unordered_map<std::string, FontAtlas*, StringHash, std::equal_to<>>
+      font_lookup;
   std::unordered_set<std::string> warned_no_uv_textures;
-  std::unordered_set<std::string> warned_missing_fonts;
 
   std::vector<std::string> shader_search_paths_;
   float cam_right[3] = {1.0F, 0.0F, 0.0F};
   float cam_up[3] = {0.0F, 1.0F, 0.0F};
+  Eigen::Vector3d cam_pos = Eigen::Vector3d::Zero();
+  float proj_y_scale = 1.0F;
+  int viewport_width = 1;
+  int viewport_height = 1;
+  float lod_pixel_threshold = 0.0F;
+  bool wireframe_overlay = false;
+  float wireframe_width = 1.0F;
+
+  // Directional lighting. The light uniforms are resolved once per frame.
+  bgfx::UniformHandle u_light_dir = BGFX_INVALID_HANDLE;
+  bgfx::UniformHandle u_light_color = BGFX_INVALID_HANDLE;
+  bgfx::UniformHandle u_normal_mtx = BGFX_INVALID_HANDLE;
+  Lighting lighting;
+  float light_dir[4] = {0.0F, 0.0F, 1.0F, 0.0F};  // Towards the light
+  float light_color[4] = {1.0F, 1.0F, 1.0F, 1.0F};
+
+  // View frustum planes (xyz: inward normal, w: offset) from view * proj.
+  float view[16] = {1.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F, 0.0F, 0.0F,
+                    0.0F, 0.0F, 1.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F};
+  float proj[16] = {1.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F, 0.0F, 0.0F,
+                    0.0F, 0.0F, 1.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F};
+  Eigen::Vector4d frustum_planes[5];
+  bool frustum_culling = true;
+  bool frustum_valid = false;
+  Eigen::Matrix4d view_proj = Eigen::Matrix4d::Identity();
+
+  bool label_declutter = false;
+  std::vector<PendingLabel> pending_labels;
+  std::vector<ScreenRect> placed_labels;
+  std::vector<std::vector<uint32_t>> label_cells;  // Screen grid buckets
+
+  // Objects being drawn, innermost last.
+  struct DrawScope {
+    const ObjectBase* object;
+    bool highlighted;
+  };
+  std::vector<DrawScope> draw_scopes;
+  std::unordered_set<const ObjectBase*> highlighted_objects;
+  Color outline_color = color::orange;
+  float outline_width = 3.0F;
+
+  // Consecutive pick IDs [first_id, first_id + count) drawn for an object.
+  struct PickDraw {
+    const ObjectBase* object;
+    uint32_t first_id;
+    uint32_t count;
+  };
+  bgfx::ProgramHandle pick_program = BGFX_INVALID_HANDLE;
+  bgfx::ProgramHandle pick_instanced_program = BGFX_INVALID_HANDLE;
+  bgfx::UniformHandle u_pick_id = BGFX_INVALID_HANDLE;
+  bgfx::TextureHandle pick_color = BGFX_INVALID_HANDLE;  // Owned by pick_fb
+  bgfx::TextureHandle pick_readback = BGFX_INVALID_HANDLE;
+  bgfx::FrameBufferHandle pick_fb = BGFX_INVALID_HANDLE;
+  bool pick_init_tried = false;
+  bool pick_requested = false;
+  int pick_x = 0;
+  int pick_y = 0;
+  bool pick_active = false;  // This frame renders the ID pass
+  uint32_t pick_next_id = 1;  // 0 is the background
+  std::vector<PickDraw> pick_draws;
+  Eigen::Vector4d pick_planes[4];  // Side planes of the pick region
+  // Readback in flight, with the ID table of the frame it was rendered in.
+  bool pick_in_flight = false;
+  uint32_t pick_ready_frame = 0;
+  std::vector<PickDraw> pick_flight_draws;
+  std::array<uint8_t, kPickSize * kPickSize * 4> pick_pixels{};
+  bool pick_result_ready = false;
+  const ObjectBase* pick_object = nullptr;
+  uint32_t pick_instance = 0;
+
+  void UpdateFrustum();
+  // Texture to bind for a fill draw, or invalid to draw plain color.
+  bgfx::TextureHandle ResolveTexture(MeshBuffer& mesh_buffer,
+                                     const std::string& texture);
+  const Eigen::Matrix4d& ViewProj();
+  void EvictTextures();
+  FontAtlas* FindFontAtlas(const std::string& font_path);
+  static TextLayout BuildTextLayout(FontAtlas& atlas,
+                                    std::string_view text, TextAlign align);
+  void EmitText(FontAtlas& atlas, const TextLayout& layout,
+                const Eigen::Affine3d& mtx, const Color& color, float height,
+                TextFacingMode facing_mode, TextDepthMode depth_mode);
+  // World axes of one layout unit of a label: layout point (lx, ly) lies at
+  // the anchor + ax * lx + ay * ly.
+  void LabelAxes(const Eigen::Affine3d& mtx, double scale,
+                 TextFacingMode facing_mode, Eigen::Vector3d& ax,
+                 Eigen::Vector3d& ay) const;
+  // Draw the layout bounds of a label into the ID pass, and a frame of
+  // outline_width pixels around them when it is highlighted.
+  void SubmitLabelMarks(const PendingLabel& label);
+  void DeclutterLabels();
+  void FlushText();
+  // Create the ID pass target and programs on first use. False when the
+  // backend or the shader binaries do not support GPU picking.
+  bool InitPicking();
+  void BeginPickPass();
+  void DecodePick();
+  bool InPickRegion(const Eigen::Vector3d& center, double radius) const;
+  // First of count new IDs for the current object; 0 when out of IDs.
+  uint32_t AllocatePickIds(uint32_t count);
+  bool Highlighted() const {
+    return !draw_scopes.empty() && draw_scopes.back().highlighted;
+  }
+  // Distance in world units covered by one pixel at a point.
+  double WorldPerPixel(const Eigen::Vector3d& point) const;
+  void SetColorUniforms(const Color& c);
+
+  void UpdateLight();
+  // Bind the buffers and light uniforms of a lit fill and return the
+  // program for its color features, or an invalid handle (binding nothing)
+  // when it cannot be lit.
+  bgfx::ProgramHandle BindLitFill(MeshBuffer& mesh_buffer, uint32_t lod,
+                                  const Eigen::Affine3d& mtx,
+                                  uint32_t features);
 };
 
+void Renderer::Impl::EvictTextures() {
+  if (texture_budget_bytes == 0 || texture_bytes <= texture_budget_bytes) {
+    return;
+  }
+  // Least recently used first, among textures idle long enough.
+  std::vector<std::unordered_map<std::string, CachedTexture>::iterator> idle;
+  for (auto it = texture_cache.begin(); it != texture_cache.end(); ++it) {
+    if (it->second.bytes > 0 &&
+        frame_index - it->second.last_used_frame >= texture_evict_frames) {
+      idle.push_back(it);
+    }
+  }
+  std::ranges::sort(idle, [](const auto& l, const auto& r) {
+    return l->second.last_used_frame < r->second.last_used_frame;
+  });
+  for (const auto& it : idle) {
+    if (texture_bytes <= texture_budget_bytes) {
+      break;
+    }
+    // Evicted textures are reloaded through the async path on next use.
+    bgfx::destroy(it->second.handle);
+    texture_bytes -= it->second.bytes;
+    texture_cache.erase(it);
+  }
+}
+
+void Renderer::Impl::UpdateFrustum() {
+  // bx matrices map column vectors when read column-major.
+  view_proj = Eigen::Map<const Eigen::Matrix4f>(proj).cast<double>() *
+              Eigen::Map<const Eigen::Matrix4f>(view).cast<double>();
+  // Left, right, bottom, top and far. The near plane differs between depth
+  // conventions and adds little over the side planes, so it is skipped.
+  frustum_planes[0] = view_proj.row(3) + view_proj.row(0);
+  frustum_planes[1] = view_proj.row(3) - view_proj.row(0);
+  frustum_planes[2] = view_proj.row(3) + view_proj.row(1);
+  frustum_planes[3] = view_proj.row(3) - view_proj.row(1);
+  frustum_planes[4] = view_proj.row(3) - view_proj.row(2);
+  frustum_valid = true;
+}
+
+const Eigen::Matrix4d& Renderer::Impl::ViewProj() {
+  if (!frustum_valid) {
+    UpdateFrustum();
+  }
+  return view_proj;
+}
+
 Renderer::Renderer() : pimpl_(std::make_unique<Impl>()) {}
 
 Renderer::~Renderer() = default;
@@ -118,7 +438,7 @@ std::vector<std::string> CollectShaderSearchPaths(
   return paths;
 }
 
-bgfx::ShaderHandle CreateShaderFromPaths(
+bgfx::ShaderHandle TryCreateShaderFromPaths(
     const std::string& file_name, const char* name,
     const std::vector<std::string>& search_paths) {
   std::string shader;
@@ -134,7 +454,11 @@ bgfx::ShaderHandle CreateShaderFromPaths(
       return handle;
     }
   }
+  return BGFX_INVALID_HANDLE;
+}
 
+[[noreturn]] void ThrowShaderNotFound(
+    const char* name, const std::vector<std::string>& search_paths) {
   std::string msg = "Could not find shader: ";
   msg += name;
   msg += "\nSearch paths:";
@@ -145,65 +469,35 @@ bgfx::ShaderHandle CreateShaderFromPaths(
   throw std::runtime_error(msg);
 }
 
-bgfx::TextureHandle LoadTexture(const std::string& path, bool srgb) {
-  std::string texture_file;
-  if (!internal::file_ops::ReadFile(path, texture_file)) {
-    LogMessage(LogLevel::Error, "Failed to read texture: ", path);
-    return BGFX_INVALID_HANDLE;
-  }
-
-  bx::DefaultAllocator allocator;
-  bimg::ImageContainer* image = bimg::imageParse(
-      &allocator, reinterpret_cast<const void*>(texture_file.data()),
-      static_cast<uint32_t>(texture_file.size()));
-  if (!image) {
-    LogMessage(LogLevel::Error, "Failed to decode texture: ", path);
-    return BGFX_INVALID_HANDLE;
-  }
-
-  uint64_t flags = BGFX_TEXTURE_NONE | BGFX_SAMPLER_MIN_ANISOTROPIC |
-                   BGFX_SAMPLER_MAG_ANISOTROPIC;
-  if (srgb) {
-    flags |= BGFX_TEXTURE_SRGB;
+// Program for an optional feature; invalid (with a warning) when the shader
+// binaries are not installed, so callers can fall back to a basic path.
+bgfx::ProgramHandle CreateOptionalProgram(
+    const std::string& vs_file, const std::string& fs_file, const char* name,
+    const std::vector<std::string>& search_paths) {
+  const bgfx::ShaderHandle vsh =
+      TryCreateShaderFromPaths(vs_file, name, search_paths);
+  const bgfx::ShaderHandle fsh =
+      TryCreateShaderFromPaths(fs_file, name, search_paths);
+  if (bgfx::isValid(vsh) && bgfx::isValid(fsh)) {
+    return bgfx::createProgram(vsh, fsh, true);
   }
-
-  const auto create2d =
-      [&](const bimg::ImageContainer& img) -> bgfx::TextureHandle {
-    const auto format = static_cast<bgfx::TextureFormat::Enum>(img.m_format);
-    if (!bgfx::isTextureValid(0, img.m_cubeMap,
-                              static_cast<uint16_t>(img.m_numLayers), format,
-                              flags)) {
-      return BGFX_INVALID_HANDLE;
-    }
-    const bgfx::Memory* mem = bgfx::copy(img.m_data, img.m_size);
-    return bgfx::createTexture2D(
-        static_cast<uint16_t>(img.m_width), static_cast<uint16_t>(img.m_height),
-        img.m_numMips > 1, static_cast<uint16_t>(img.m_numLayers), format,
-        flags, mem);
-  };
-
-  bgfx::TextureHandle handle = create2d(*image);
-  if (bgfx::isValid(handle)) {
-    bimg::imageFree(image);
-    return handle;
+  if (bgfx::isValid(vsh)) {
+    bgfx::destroy(vsh);
   }
-
-  // Fallback: convert unsupported source format (e.g. RGB8 PNG) to RGBA8.
-  bimg::ImageContainer* converted =
-      bimg::imageConvert(&allocator, bimg::TextureFormat::RGBA8, *image, true);
-  bimg::imageFree(image);
-  if (!converted) {
-    LogMessage(LogLevel::Error, "Failed to create texture: ", path);
-    return BGFX_INVALID_HANDLE;
+  if (bgfx::isValid(fsh)) {
+    bgfx::destroy(fsh);
   }
+  LogMessage(LogLevel::Warn, "Shader not found, using fallback for: ", name);
+  return BGFX_INVALID_HANDLE;
+}
 
-  handle = create2d(*converted);
-  bimg::imageFree(converted);
-  if (!bgfx::isValid(handle)) {
-    LogMessage(LogLevel::Error, "Failed to create texture: ", path);
-    return BGFX_INVALID_HANDLE;
-  }
-  return handle;
+bgfx::TextureHandle CreatePlaceholderTexture() {
+  // 1x1 white: the textured shader multiplies by the base color, so pending
+  // textures render as plain color.
+  static constexpr uint8_t kWhite[4] = {255U, 255U, 255U, 255U};
+  return bgfx::createTexture2D(1, 1, false, 1, bgfx::TextureFormat::RGBA8,
+                               BGFX_TEXTURE_NONE | BGFX_SAMPLER_POINT,
+                               bgfx::copy(kWhite, sizeof(kWhite)));
 }
 
 std::string ResolveDefaultFontPath() {
@@ -221,80 +515,614 @@ std::string ResolveDefaultFontPath() {
   return {};
 }
 
-bool LoadFontAtlas(bgfx::TextureHandle& out_texture, int& out_width,
-                   int& out_height, stbtt_bakedchar out_glyphs[96],
-                   const std::string& font_path, int pixel_height) {
-  std::string font_file;
-  if (!internal::file_ops::ReadFile(font_path, font_file)) {
+// Suffix of the shader binaries built for this platform.
+const char* ShaderPlatformName() {
+#if BX_PLATFORM_WINDOWS
+  return "win";
+#elif BX_PLATFORM_OSX
+  return "mac";
+#else
+  return "linux";
+#endif
+}
+
+// Shader features needed to draw a color.
+uint32_t ColorFeatures(const Color& color) {
+  return color.mode == Color::ColorMode::Rainbow ? internal::kShaderRainbow
+                                                 : 0U;
+}
+
+// Column-major float copy for bgfx::setTransform.
+void StoreMatrix(const Eigen::Affine3d& mtx, float out[16]) {
+  const Eigen::Matrix4d& m = mtx.matrix();
+  for (int col = 0; col < 4; ++col) {
+    for (int row = 0; row < 4; ++row) {
+      out[(col * 4) + row] = static_cast<float>(m(row, col));
+    }
+  }
+}
+
+// Pick ID as the normalized RGBA8 color that stores its bytes, low first.
+void PackPickId(uint32_t id, float out[4]) {
+  for (int i = 0; i < 4; ++i) {
+    out[i] = static_cast<float>((id >> (8 * i)) & 0xFFU) / 255.0F;
+  }
+}
+
+uint32_t PackAbgr(const float rgba[4]) {
+  uint32_t abgr = 0;
+  for (int i = 0; i < 4; ++i) {
+    const float c = std::clamp(rgba[i], 0.0F, 1.0F);
+    abgr |= static_cast<uint32_t>((c * 255.0F) + 0.5F) << (8 * i);
+  }
+  return abgr;
+}
+
+}  // namespace
+
+void Renderer::Impl::SetColorUniforms(const Color& c) {
+  bgfx::setUniform(u_color, &c.base);
+  float mode_val[4] = {static_cast<float>(static_cast<int>(c.mode)), 0.0F,
+                       0.0F, 0.0F};
+  float rparams[4];
+  BuildRainbowParams(c.direction, rparams);
+  bgfx::setUniform(u_color_mode, mode_val);
+  bgfx::setUniform(u_rainbow_params, rparams);
+}
+
+void Renderer::Impl::UpdateLight() {
+  Eigen::Vector3d direction = lighting.direction;
+  if (lighting.follow_camera) {
+    // Rows of the view rotation are the camera axes in world space.
+    direction = Eigen::Map<const Eigen::Matrix4f>(view)
+                    .topLeftCorner<3, 3>()
+                    .cast<double>()
+                    .transpose() *
+                direction;
+  }
+  const double length = direction.norm();
+  const Eigen::Vector3d towards =
+      length > 0.0 ? Eigen::Vector3d(-direction / length)
+                   : Eigen::Vector3d::UnitZ();
+  light_dir[0] = static_cast<float>(towards.x());
+  light_dir[1] = static_cast<float>(towards.y());
+  light_dir[2] = static_cast<float>(towards.z());
+  std::copy(lighting.color.base, lighting.color.base + 3, light_color);
+  light_color[3] = std::clamp(lighting.ambient, 0.0F, 1.0F);
+}
+
+bgfx::ProgramHandle Renderer::Impl::BindLitFill(MeshBuffer& mesh_buffer,
+                                                uint32_t lod,
+                                                const Eigen::Affine3d& mtx,
+                                                uint32_t features) {
+  using internal::ShaderFamily;
+  bgfx::ProgramHandle lit = BGFX_INVALID_HANDLE;
+  const bgfx::ProgramHandle smooth = shaders.Get(
+      ShaderFamily::Lit,
+      features | (lighting.per_vertex ? internal::kShaderPerVertex : 0U));
+  if (bgfx::isValid(smooth) &&
+      internal::MeshBufferAccess::SetNormalBuffers(mesh_buffer, lod)) {
+    // Normals are in object space; quantization is not applied to them.
+    Eigen::Affine3d normal_mtx = Eigen::Affine3d::Identity();
+    const Eigen::Matrix3d linear = mtx.linear();
+    normal_mtx.linear() = std::abs(linear.determinant()) > 1e-12
+                              ? Eigen::Matrix3d(linear.inverse().transpose())
+                              : linear;
+    float normal_mtx_f[16];
+    StoreMatrix(normal_mtx, normal_mtx_f);
+    bgfx::setUniform(u_normal_mtx, normal_mtx_f);
+    lit = smooth;
+  } else if (const bgfx::ProgramHandle flat = shaders.Get(
+                 ShaderFamily::Mesh, features | internal::kShaderLitFlat);
+             bgfx::isValid(flat) &&
+             internal::MeshBufferAccess::SetBuffers(mesh_buffer, lod)) {
+    lit = flat;
+  }
+  if (bgfx::isValid(lit)) {
+    bgfx::setUniform(u_light_dir, light_dir);
+    bgfx::setUniform(u_light_color, light_color);
+  }
+  return lit;
+}
+
+bool Renderer::Impl::InitPicking() {
+  if (pick_init_tried) {
+    return bgfx::isValid(pick_fb);
+  }
+  pick_init_tried = true;
+  constexpr uint64_t kNeeded =
+      BGFX_CAPS_TEXTURE_BLIT | BGFX_CAPS_TEXTURE_READ_BACK;
+  if ((bgfx::getCaps()->supported & kNeeded) != kNeeded) {
+    LogMessage(LogLevel::Warn,
+               "GPU picking is not supported by this renderer backend.");
+    return false;
+  }
+  const std::vector<std::string> search_paths =
+      CollectShaderSearchPaths(shader_search_paths_);
+  const std::string suffix = std::string("_") + ShaderPlatformName() + ".bin";
+  pick_program = CreateOptionalProgram("v_pick" + suffix, "f_pick" + suffix,
+                                       "pick", search_paths);
+  // Without it, instanced draws only occlude nothing in the ID pass.
+  pick_instanced_program =
+      CreateOptionalProgram("v_points_pick" + suffix, "f_pick" + suffix,
+                            "pick_instanced", search_paths);
+  if (!bgfx::isValid(pick_program)) {
     return false;
   }
+  u_pick_id = bgfx::createUniform("u_pick_id", bgfx::UniformType::Vec4);
+
+  constexpr uint64_t kSampler =
+      BGFX_SAMPLER_POINT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP;
+  const bgfx::TextureHandle targets[2] = {
+      bgfx::createTexture2D(kPickSize, kPickSize, false, 1,
+                            bgfx::TextureFormat::RGBA8,
+                            BGFX_TEXTURE_RT | kSampler),
+      bgfx::createTexture2D(kPickSize, kPickSize, false, 1,
+                            bgfx::TextureFormat::D24,
+                            BGFX_TEXTURE_RT_WRITE_ONLY)};
+  pick_color = targets[0];
+  pick_fb = bgfx::createFrameBuffer(2, targets, true);
+  pick_readback = bgfx::createTexture2D(
+      kPickSize, kPickSize, false, 1, bgfx::TextureFormat::RGBA8,
+      BGFX_TEXTURE_BLIT_DST | BGFX_TEXTURE_READ_BACK | kSampler);
+  return true;
+}
+
+void Renderer::Impl::BeginPickPass() {
+  // Crop the projection to the pick region, centered on the pixel center.
+  const double width = viewport_width;
+  const double height = viewport_height;
+  const double half_w = kPickSize / width;
+  const double half_h = kPickSize / height;
+  const double cx = (2.0 * (pick_x + 0.5) / width) - 1.0;
+  const double cy = 1.0 - (2.0 * (pick_y + 0.5) / height);
+  Eigen::Matrix4d crop = Eigen::Matrix4d::Identity();
+  crop(0, 0) = 1.0 / half_w;
+  crop(0, 3) = -cx / half_w;
+  crop(1, 1) = 1.0 / half_h;
+  crop(1, 3) = -cy / half_h;
+  const Eigen::Matrix4d pick_proj =
+      crop * Eigen::Map<const Eigen::Matrix4f>(proj).cast<double>();
+  const Eigen::Matrix4d pick_view_proj =
+      pick_proj * Eigen::Map<const Eigen::Matrix4f>(view).cast<double>();
+  pick_planes[0] = pick_view_proj.row(3) + pick_view_proj.row(0);
+  pick_planes[1] = pick_view_proj.row(3) - pick_view_proj.row(0);
+  pick_planes[2] = pick_view_proj.row(3) + pick_view_proj.row(1);
+  pick_planes[3] = pick_view_proj.row(3) - pick_view_proj.row(1);
+
+  float pick_proj_f[16];
+  Eigen::Map<Eigen::Matrix4f> pick_proj_map(pick_proj_f);
+  pick_proj_map = pick_proj.cast<float>();
+  bgfx::setViewFrameBuffer(kPickView, pick_fb);
+  bgfx::setViewRect(kPickView, 0, 0, kPickSize, kPickSize);
+  bgfx::setViewClear(kPickView, BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH, 0, 1.0F,
+                     0);
+  bgfx::setViewTransform(kPickView, view, pick_proj_f);
+  bgfx::touch(kPickView);
+  pick_draws.clear();
+  pick_next_id = 1;
+  pick_active = true;
+}
+
+void Renderer::Impl::DecodePick() {
+  // The ID nearest to the center wins, so small points are easy to hit.
+  constexpr int kCenter = kPickSize / 2;
+  uint32_t best_id = 0;
+  int best_distance = std::numeric_limits<int>::max();
+  for (int y = 0; y < kPickSize; ++y) {
+    for (int x = 0; x < kPickSize; ++x) {
+      const uint8_t* texel = &pick_pixels[((y * kPickSize) + x) * 4];
+      const uint32_t id = texel[0] | (uint32_t{texel[1]} << 8U) |
+                          (uint32_t{texel[2]} << 16U) |
+                          (uint32_t{texel[3]} << 24U);
+      const int distance = ((x - kCenter) * (x - kCenter)) +
+                           ((y - kCenter) * (y - kCenter));
+      if (id != 0 && distance < best_distance) {
+        best_id = id;
+        best_distance = distance;
+      }
+    }
+  }
+  pick_object = nullptr;
+  pick_instance = 0;
+  const auto it = std::upper_bound(
+      pick_flight_draws.begin(), pick_flight_draws.end(), best_id,
+      [](uint32_t id, const PickDraw& draw) { return id < draw.first_id; });
+  if (best_id != 0 && it != pick_flight_draws.begin()) {
+    const PickDraw& draw = *std::prev(it);
+    if (best_id - draw.first_id < draw.count) {
+      pick_object = draw.object;
+      pick_instance = best_id - draw.first_id;
+    }
+  }
+  pick_result_ready = true;
+}
+
+bool Renderer::Impl::InPickRegion(const Eigen::Vector3d& center,
+                                  double radius) const {
+  for (const auto& plane : pick_planes) {
+    if (plane.head<3>().dot(center) + plane.w() <
+        -radius * plane.head<3>().norm()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint32_t Renderer::Impl::AllocatePickIds(uint32_t count) {
+  if (!pick_active || draw_scopes.empty() || count == 0 ||
+      count > std::numeric_limits<uint32_t>::max() - pick_next_id) {
+    return 0;
+  }
+  const uint32_t first = pick_next_id;
+  pick_next_id += count;
+  pick_draws.push_back({draw_scopes.back().object, first, count});
+  return first;
+}
 
-  const std::vector<int> sizes = {512, 1024, 2048, 4096};
-  for (const int side : sizes) {
-    std::vector<unsigned char> alpha(side * side, 0U);
-    if (stbtt_BakeFontBitmap(
-            reinterpret_cast<const unsigned char*>(font_file.data()), 0,
-            static_cast<float>(pixel_height), alpha.data(), side, side, 32, 96,
-            out_glyphs) <= 0) {
+double Renderer::Impl::WorldPerPixel(const Eigen::Vector3d& point) const {
+  return 2.0 * (point - cam_pos).norm() /
+         (std::max(std::abs(static_cast<double>(proj_y_scale)), 1e-6) *
+          viewport_height);
+}
+
+Renderer::Impl::FontAtlas* Renderer::Impl::FindFontAtlas(
+    const std::string& font_path) {
+  if (const auto it = font_lookup.find(std::string_view(font_path));
+      it != font_lookup.end()) {
+    return it->second;
+  }
+
+  FontAtlas* atlas = nullptr;
+  std::string resolved_font = font_path;
+  if (resolved_font.empty()) {
+    resolved_font = ResolveDefaultFontPath();
+  }
+  if (resolved_font.empty()) {
+    LogMessage(LogLevel::Warn, "No default font found for text rendering.");
+  } else if (const auto cached = font_cache.find(resolved_font);
+             cached != font_cache.end()) {
+    atlas = &cached->second;
+  } else if (!std::filesystem::exists(resolved_font)) {
+    LogMessage(LogLevel::Warn, "Font not found: ", resolved_font);
+  } else {
+    // Distance-field glyphs need the text shader; the textured fallback
+    // program samples plain coverage bitmaps.
+    FontAtlas loaded;
+    if (loaded.glyphs.Load(resolved_font, bgfx::isValid(text_program))) {
+      atlas =
+          &font_cache.emplace(resolved_font, std::move(loaded)).first->second;
+    } else {
+      LogMessage(LogLevel::Warn, "Failed to load font: ", resolved_font);
+    }
+  }
+  // Failures are remembered too, so each font path is warned about once.
+  font_lookup.emplace(font_path, atlas);
+  return atlas;
+}
+
+// Glyph quads for a label in atlas pixels. Lines stack downwards from the
+// origin, each shifted for the requested alignment.
+Renderer::Impl::TextLayout Renderer::Impl::BuildTextLayout(
+    FontAtlas& atlas, std::string_view text, TextAlign align) {
+  TextLayout layout;
+  layout.quads.reserve(text.size());
+  const float line_advance = atlas.glyphs.PixelHeight() * 1.2F;
+  float pen_y = 0.0F;
+  std::size_t line_begin = 0;
+  const auto finish_line = [&](float width) {
+    float shift = 0.0F;
+    if (align == TextAlign::Center) {
+      shift = -0.5F * width;
+    } else if (align == TextAlign::Right) {
+      shift = -width;
+    }
+    for (std::size_t i = line_begin; i < layout.quads.size(); ++i) {
+      layout.quads[i].x0 += shift;
+      layout.quads[i].x1 += shift;
+    }
+    line_begin = layout.quads.size();
+  };
+
+  float pen_x = 0.0F;
+  const internal::GlyphAtlas::Glyph* previous = nullptr;
+  std::size_t pos = 0;
+  while (pos < text.size()) {
+    const uint32_t codepoint = internal::DecodeUtf8(text, pos);
+    if (codepoint == '\n') {
+      finish_line(pen_x);
+      pen_x = 0.0F;
+      pen_y += line_advance;
+      previous = nullptr;
+      continue;
+    }
+    if (codepoint < 32 || codepoint == 0x7F) {
       continue;
     }
+    const internal::GlyphAtlas::Glyph* glyph = atlas.glyphs.GetGlyph(codepoint);
+    if (previous) {
+      pen_x += atlas.glyphs.Kerning(*previous, *glyph);
+    }
+    if (glyph->visible) {
+      layout.quads.push_back({pen_x + glyph->x0,
+                              -(pen_y + glyph->y0) - line_advance,
+                              pen_x + glyph->x1,
+                              -(pen_y + glyph->y1) - line_advance, glyph->s0,
+                              glyph->t0, glyph->s1, glyph->t1, glyph->page});
+    }
+    pen_x += glyph->advance;
+    previous = glyph;
+  }
+  finish_line(pen_x);
+
+  if (!layout.quads.empty()) {
+    layout.min_x = layout.max_x = layout.quads.front().x0;
+    layout.min_y = layout.max_y = layout.quads.front().y0;
+    for (const GlyphQuad& q : layout.quads) {
+      layout.min_x = std::min({layout.min_x, q.x0, q.x1});
+      layout.max_x = std::max({layout.max_x, q.x0, q.x1});
+      layout.min_y = std::min({layout.min_y, q.y0, q.y1});
+      layout.max_y = std::max({layout.max_y, q.y0, q.y1});
+    }
+  }
+  return layout;
+}
 
-    std::vector<unsigned char> rgba(side * side * 4U, 255U);
-    for (size_t i = 0; i < alpha.size(); ++i) {
-      rgba[i * 4U + 3U] = alpha[i];
+void Renderer::Impl::DeclutterLabels() {
+  // Higher priority first, nearer first among equals; a label is dropped
+  // when its screen rect overlaps one already placed.
+  std::ranges::stable_sort(pending_labels, [](const PendingLabel& l,
+                                              const PendingLabel& r) {
+    if (l.priority != r.priority) {
+      return l.priority > r.priority;
+    }
+    return l.clip.w() < r.clip.w();
+  });
+
+  const double half_w = 0.5 * viewport_width;
+  const double half_h = 0.5 * viewport_height;
+  const int cols = (viewport_width / kLabelCellPixels) + 1;
+  const int rows = (viewport_height / kLabelCellPixels) + 1;
+  label_cells.resize(static_cast<std::size_t>(cols) * rows);
+  for (auto& cell : label_cells) {
+    cell.clear();
+  }
+  placed_labels.clear();
+
+  for (const PendingLabel& label : pending_labels) {
+    const double w = label.clip.w();
+    const double cx = (label.clip.x() / w + 1.0) * half_w;
+    const double cy = (label.clip.y() / w + 1.0) * half_h;
+    const double scale =
+        static_cast<double>(label.height) / label.atlas->glyphs.PixelHeight();
+    const Eigen::Matrix3d linear = label.mtx.linear();
+    const double px = scale * linear.col(0).norm() * proj[0] * half_w / w;
+    const double py = scale * linear.col(1).norm() * proj[5] * half_h / w;
+    const TextLayout& layout = *label.layout;
+    const ScreenRect rect{cx + (layout.min_x * px), cy + (layout.min_y * py),
+                          cx + (layout.max_x * px), cy + (layout.max_y * py)};
+    if (rect.x1 < 0.0 || rect.y1 < 0.0 || rect.x0 > viewport_width ||
+        rect.y0 > viewport_height) {
+      continue;
     }
 
-    const uint64_t flags = BGFX_TEXTURE_NONE | BGFX_SAMPLER_U_CLAMP |
-                           BGFX_SAMPLER_V_CLAMP | BGFX_SAMPLER_MIN_ANISOTROPIC |
-                           BGFX_SAMPLER_MAG_ANISOTROPIC;
-    const bgfx::Memory* mem =
-        bgfx::copy(rgba.data(), static_cast<uint32_t>(rgba.size()));
-    const auto handle = bgfx::createTexture2D(
-        static_cast<uint16_t>(side), static_cast<uint16_t>(side), false, 1,
-        bgfx::TextureFormat::RGBA8, flags, mem);
-    if (!bgfx::isValid(handle)) {
+    const auto cell_index = [](double v, int count) {
+      return std::clamp(static_cast<int>(v) / kLabelCellPixels, 0, count - 1);
+    };
+    const int c0 = cell_index(rect.x0, cols);
+    const int c1 = cell_index(rect.x1, cols);
+    const int r0 = cell_index(rect.y0, rows);
+    const int r1 = cell_index(rect.y1, rows);
+    bool overlaps = false;
+    for (int r = r0; r <= r1 && !overlaps; ++r) {
+      for (int c = c0; c <= c1 && !overlaps; ++c) {
+        for (const uint32_t other : label_cells[(r * cols) + c]) {
+          const ScreenRect& o = placed_labels[other];
+          if (rect.x0 < o.x1 && o.x0 < rect.x1 && rect.y0 < o.y1 &&
+              o.y0 < rect.y1) {
+            overlaps = true;
+            break;
+          }
+        }
+      }
+    }
+    if (overlaps) {
       continue;
     }
 
-    out_width = side;
-    out_height = side;
-    out_texture = handle;
-    return true;
+    const auto placed = static_cast<uint32_t>(placed_labels.size());
+    placed_labels.push_back(rect);
+    for (int r = r0; r <= r1; ++r) {
+      for (int c = c0; c <= c1; ++c) {
+        label_cells[(r * cols) + c].push_back(placed);
+      }
+    }
+    EmitText(*label.atlas, layout, label.mtx, label.color, label.height,
+             label.facing_mode, label.depth_mode);
+    SubmitLabelMarks(label);
+  }
+  pending_labels.clear();
+}
+
+void Renderer::Impl::FlushText() {
+  static bgfx::VertexLayout layout = []() {
+    bgfx::VertexLayout l;
+    l.begin()
+        .add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float)
+        .add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float)
+        .add(bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true)
+        .add(bgfx::Attrib::TexCoord1, 4, bgfx::AttribType::Float)
+        .end();
+    return l;
+  }();
+  const float identity[16] = {1.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F, 0.0F, 0.0F,
+                              0.0F, 0.0F, 1.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F};
+
+  // Draws quads [first, first + count) in chunks that fit 16-bit indices.
+  const auto draw_quads = [&](const TextBatch& batch, uint32_t first,
+                              uint32_t count, uint64_t state,
+                              bgfx::TextureHandle texture,
+                              bgfx::ProgramHandle program,
+                              const TextRun* run) {
+    while (count > 0) {
+      const uint32_t quads = std::min(count, kMaxTextQuadsPerDraw);
+      const uint32_t vertex_count = quads * 4;
+      const uint32_t index_count = quads * 6;
+      if (bgfx::getAvailTransientVertexBuffer(vertex_count, layout) <
+              vertex_count ||
+          bgfx::getAvailTransientIndexBuffer(index_count) < index_count) {
+        return;
+      }
+      bgfx::TransientVertexBuffer tvb;
+      bgfx::TransientIndexBuffer tib;
+      bgfx::allocTransientVertexBuffer(&tvb, vertex_count, layout);
+      bgfx::allocTransientIndexBuffer(&tib, index_count);
+      std::memcpy(tvb.data, batch.vertices.data() + (first * 4),
+                  vertex_count * sizeof(TextVertex));
+      auto* idx = reinterpret_cast<uint16_t*>(tib.data);
+      for (uint32_t q = 0; q < quads; ++q) {
+        const auto base = static_cast<uint16_t>(q * 4);
+        const uint16_t quad[6] = {base,
+                                  static_cast<uint16_t>(base + 1),
+                                  static_cast<uint16_t>(base + 2),
+                                  base,
+                                  static_cast<uint16_t>(base + 2),
+                                  static_cast<uint16_t>(base + 3)};
+        std::memcpy(idx + (q * 6), quad, sizeof(quad));
+      }
+
+      bgfx::setState(state);
+      if (run) {
+        bgfx::setUniform(u_color, run->color);
+        bgfx::setUniform(u_color_mode, run->mode);
+        bgfx::setUniform(u_rainbow_params, run->rainbow);
+      }
+      bgfx::setTransform(identity);
+      bgfx::setVertexBuffer(0, &tvb);
+      bgfx::setIndexBuffer(&tib);
+      bgfx::setTexture(0, s_texture, texture);
+      bgfx::submit(0, program);
+      first += quads;
+      count -= quads;
+    }
+  };
+
+  const bool batched = bgfx::isValid(text_program);
+  const float text_axes[8] = {cam_right[0], cam_right[1], cam_right[2], 0.0F,
+                              cam_up[0],    cam_up[1],    cam_up[2],    0.0F};
+  const auto draw_batch = [&](TextBatch& batch, bgfx::TextureHandle texture,
+                              TextDepthMode depth_mode) {
+    uint64_t state =
+        BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_BLEND_ALPHA;
+    if (depth_mode == TextDepthMode::DepthTest) {
+      state |= BGFX_STATE_DEPTH_TEST_LESS | BGFX_STATE_WRITE_Z;
+    }
+
+    if (!batch.billboards.empty()) {
+      constexpr auto kStride = static_cast<uint16_t>(sizeof(GlyphInstance));
+      const auto count = std::min(
+          static_cast<uint32_t>(batch.billboards.size()),
+          bgfx::getAvailInstanceDataBuffer(
+              static_cast<uint32_t>(batch.billboards.size()), kStride));
+      if (count > 0) {
+        bgfx::InstanceDataBuffer idb;
+        bgfx::allocInstanceDataBuffer(&idb, count, kStride);
+        std::memcpy(idb.data, batch.billboards.data(),
+                    static_cast<std::size_t>(count) * kStride);
+        bgfx::setState(state);
+        bgfx::setUniform(u_text_axes, text_axes, 2);
+        bgfx::setVertexBuffer(0, glyph_quad_vbh);
+        bgfx::setIndexBuffer(glyph_quad_ibh);
+        bgfx::setInstanceDataBuffer(&idb);
+        bgfx::setTexture(0, s_texture, texture);
+        bgfx::submit(0, text_billboard_program);
+      }
+      batch.billboards.clear();
+    }
+
+    if (batch.vertices.empty()) {
+      return;
+    }
+    if (batched) {
+      draw_quads(batch, 0, static_cast<uint32_t>(batch.vertices.size() / 4),
+                 state, texture, text_program, nullptr);
+    } else {
+      for (const TextRun& run : batch.runs) {
+        const uint32_t features =
+            run.mode[0] != 0.0F ? internal::kShaderRainbow : 0U;
+        draw_quads(batch, run.first_quad, run.quad_count, state, texture,
+                   shaders.Get(internal::ShaderFamily::Textured, features),
+                   &run);
+      }
+    }
+    batch.vertices.clear();
+    batch.runs.clear();
+  };
+
+  for (auto& [_, atlas] : font_cache) {
+    for (std::size_t page = 0; page < atlas.batches.size(); ++page) {
+      const bgfx::TextureHandle texture = atlas.glyphs.PageTexture(page);
+      draw_batch(atlas.batches[page][0], texture, TextDepthMode::DepthTest);
+      draw_batch(atlas.batches[page][1], texture,
+                 TextDepthMode::AlwaysVisible);
+    }
+
+    // Drop layouts of labels that changed text or went away.
+    if (frame_index % kTextLayoutEvictFrames == 0) {
+      for (TextLayoutMap& layouts : atlas.layouts) {
+        std::erase_if(layouts, [this](const auto& entry) {
+          return frame_index - entry.second.last_used_frame >=
+                 kTextLayoutEvictFrames;
+        });
+      }
+    }
   }
-  return false;
 }
-}  // namespace
 
 void Renderer::Init() {
-#if BX_PLATFORM_WINDOWS
-  const std::string plt_name = "win";
-#elif BX_PLATFORM_OSX
-  const std::string plt_name = "mac";
-#elif BX_PLATFORM_LINUX
-  const std::string plt_name = "linux";
-#endif
+  const std::string plt_name = ShaderPlatformName();
 
   const std::vector<std::string> search_paths =
       CollectShaderSearchPaths(pimpl_->shader_search_paths_);
 
-  bgfx::ShaderHandle vsh = CreateShaderFromPaths(
-      "v_simple_" + plt_name + ".bin", "vshader", search_paths);
-  bgfx::ShaderHandle fsh = CreateShaderFromPaths(
-      "f_simple_" + plt_name + ".bin", "fshader", search_paths);
-  pimpl_->program = bgfx::createProgram(vsh, fsh, true);
-
-  bgfx::ShaderHandle vtsh = CreateShaderFromPaths(
-      "v_textured_" + plt_name + ".bin", "vshader_textured", search_paths);
-  bgfx::ShaderHandle ftsh = CreateShaderFromPaths(
-      "f_textured_" + plt_name + ".bin", "fshader_textured", search_paths);
-  pimpl_->textured_program = bgfx::createProgram(vtsh, ftsh, true);
+  // Variants load on first use; the base variants of the core families
+  // are required up front.
+  pimpl_->shaders.SetLoader(
+      [plt_name, search_paths](const std::string& name) {
+        return TryCreateShaderFromPaths(name + "_" + plt_name + ".bin",
+                                        name.c_str(), search_paths);
+      });
+  for (const auto& [family, name] :
+       {std::pair{internal::ShaderFamily::Mesh, "simple"},
+        std::pair{internal::ShaderFamily::Textured, "textured"},
+        std::pair{internal::ShaderFamily::Points, "points"}}) {
+    if (!bgfx::isValid(pimpl_->shaders.Get(family, 0))) {
+      pimpl_->shaders.Clear();
+      ThrowShaderNotFound(name, search_paths);
+    }
+  }
 
-  bgfx::ShaderHandle vph = CreateShaderFromPaths(
-      "v_points_" + plt_name + ".bin", "vshader_points", search_paths);
-  bgfx::ShaderHandle fph = CreateShaderFromPaths(
-      "f_points_" + plt_name + ".bin", "fshader_points", search_paths);
-  if (bgfx::isValid(vph) && bgfx::isValid(fph)) {
-    pimpl_->instancing_program = bgfx::createProgram(vph, fph, true);
+  pimpl_->wireframe_program = CreateOptionalProgram(
+      "v_wireframe_" + plt_name + ".bin", "f_wireframe_" + plt_name + ".bin",
+      "wireframe", search_paths);
+  pimpl_->text_program = CreateOptionalProgram(
+      "v_text_" + plt_name + ".bin", "f_text_" + plt_name + ".bin", "text",
+      search_paths);
+  pimpl_->text_billboard_program = CreateOptionalProgram(
+      "v_text_billboard_" + plt_name + ".bin", "f_text_" + plt_name + ".bin",
+      "text_billboard", search_paths);
+  if (bgfx::isValid(pimpl_->text_billboard_program)) {
+    static const float kCorners[12] = {0.0F, 0.0F, 0.0F, 1.0F, 0.0F, 0.0F,
+                                       1.0F, 1.0F, 0.0F, 0.0F, 1.0F, 0.0F};
+    static const uint16_t kQuad[6] = {0, 1, 2, 0, 2, 3};
+    bgfx::VertexLayout corner_layout;
+    corner_layout.begin()
+        .add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float)
+        .end();
+    pimpl_->glyph_quad_vbh = bgfx::createVertexBuffer(
+        bgfx::makeRef(kCorners, sizeof(kCorners)), corner_layout);
+    pimpl_->glyph_quad_ibh =
+        bgfx::createIndexBuffer(bgfx::makeRef(kQuad, sizeof(kQuad)));
   }
 
   PrintBackend();
@@ -306,35 +1134,134 @@ void Renderer::Init() {
       bgfx::createUniform("u_rainbow_params", bgfx::UniformType::Vec4);
   pimpl_->s_texture =
       bgfx::createUniform("s_texture", bgfx::UniformType::Sampler);
+  pimpl_->u_text_axes =
+      bgfx::createUniform("u_text_axes", bgfx::UniformType::Vec4, 2);
+  pimpl_->u_wire_color =
+      bgfx::createUniform("u_wire_color", bgfx::UniformType::Vec4);
+  pimpl_->u_wire_rainbow =
+      bgfx::createUniform("u_wire_rainbow", bgfx::UniformType::Vec4);
+  pimpl_->u_wire_params =
+      bgfx::createUniform("u_wire_params", bgfx::UniformType::Vec4);
+  pimpl_->u_light_dir =
+      bgfx::createUniform("u_light_dir", bgfx::UniformType::Vec4);
+  pimpl_->u_light_color =
+      bgfx::createUniform("u_light_color", bgfx::UniformType::Vec4);
+  pimpl_->u_normal_mtx =
+      bgfx::createUniform("u_normal_mtx", bgfx::UniformType::Mat4);
+
+  pimpl_->placeholder_texture = CreatePlaceholderTexture();
+  pimpl_->texture_loader.Init();
 }
 
 void Renderer::DeInit() {
-  bgfx::destroy(pimpl_->program);
-  pimpl_->program = BGFX_INVALID_HANDLE;
-  bgfx::destroy(pimpl_->textured_program);
-  pimpl_->textured_program = BGFX_INVALID_HANDLE;
-  bgfx::destroy(pimpl_->instancing_program);
-  pimpl_->instancing_program = BGFX_INVALID_HANDLE;
+  pimpl_->shaders.Clear();
+  if (bgfx::isValid(pimpl_->wireframe_program)) {
+    bgfx::destroy(pimpl_->wireframe_program);
+    pimpl_->wireframe_program = BGFX_INVALID_HANDLE;
+  }
+  internal::MeshBufferManager::SetBarycentricWireframe(false);
+  if (bgfx::isValid(pimpl_->text_program)) {
+    bgfx::destroy(pimpl_->text_program);
+    pimpl_->text_program = BGFX_INVALID_HANDLE;
+  }
+  if (bgfx::isValid(pimpl_->text_billboard_program)) {
+    bgfx::destroy(pimpl_->text_billboard_program);
+    bgfx::destroy(pimpl_->glyph_quad_vbh);
+    bgfx::destroy(pimpl_->glyph_quad_ibh);
+    pimpl_->text_billboard_program = BGFX_INVALID_HANDLE;
+    pimpl_->glyph_quad_vbh = BGFX_INVALID_HANDLE;
+    pimpl_->glyph_quad_ibh = BGFX_INVALID_HANDLE;
+  }
 
-  for (auto& [_, handle] : pimpl_->texture_cache) {
-    if (bgfx::isValid(handle)) {
-      bgfx::destroy(handle);
+  pimpl_->texture_loader.Shutdown();
+  pimpl_->pending_textures.clear();
+  for (auto& [_, cached] : pimpl_->texture_cache) {
+    if (bgfx::isValid(cached.handle)) {
+      bgfx::destroy(cached.handle);
     }
   }
   pimpl_->texture_cache.clear();
-  for (auto& [_, atlas] : pimpl_->font_cache) {
-    if (bgfx::isValid(atlas.texture)) {
-      bgfx::destroy(atlas.texture);
-    }
+  pimpl_->texture_bytes = 0;
+  if (bgfx::isValid(pimpl_->placeholder_texture)) {
+    bgfx::destroy(pimpl_->placeholder_texture);
+    pimpl_->placeholder_texture = BGFX_INVALID_HANDLE;
   }
   pimpl_->font_cache.clear();
+  pimpl_->font_lookup.clear();
   pimpl_->warned_no_uv_textures.clear();
-  pimpl_->warned_missing_fonts.clear();
 
   bgfx::destroy(pimpl_->u_color);
   bgfx::destroy(pimpl_->u_color_mode);
   bgfx::destroy(pimpl_->u_rainbow_params);
   bgfx::destroy(pimpl_->s_texture);
+  bgfx::destroy(pimpl_->u_text_axes);
+  bgfx::destroy(pimpl_->u_wire_color);
+  bgfx::destroy(pimpl_->u_wire_rainbow);
+  bgfx::destroy(pimpl_->u_wire_params);
+  bgfx::destroy(pimpl_->u_light_dir);
+  bgfx::destroy(pimpl_->u_light_color);
+  bgfx::destroy(pimpl_->u_normal_mtx);
+
+  if (bgfx::isValid(pimpl_->pick_program)) {
+    bgfx::destroy(pimpl_->pick_program);
+    pimpl_->pick_program = BGFX_INVALID_HANDLE;
+  }
+  if (bgfx::isValid(pimpl_->pick_instanced_program)) {
+    bgfx::destroy(pimpl_->pick_instanced_program);
+    pimpl_->pick_instanced_program = BGFX_INVALID_HANDLE;
+  }
+  if (bgfx::isValid(pimpl_->pick_fb)) {
+    bgfx::destroy(pimpl_->pick_fb);
+    bgfx::destroy(pimpl_->pick_readback);
+    bgfx::destroy(pimpl_->u_pick_id);
+    pimpl_->pick_fb = BGFX_INVALID_HANDLE;
+    pimpl_->pick_color = BGFX_INVALID_HANDLE;
+    pimpl_->pick_readback = BGFX_INVALID_HANDLE;
+    pimpl_->u_pick_id = BGFX_INVALID_HANDLE;
+  } else if (bgfx::isValid(pimpl_->u_pick_id)) {
+    bgfx::destroy(pimpl_->u_pick_id);
+    pimpl_->u_pick_id = BGFX_INVALID_HANDLE;
+  }
+  pimpl_->pick_init_tried = false;
+  pimpl_->pick_active = false;
+  pimpl_->pick_in_flight = false;
+}
+
+void Renderer::BeginFrame() {
+  ++pimpl_->frame_index;
+  internal::DrainDeferredDestroys(pimpl_->gpu_releases_per_frame);
+  pimpl_->texture_loader.UploadReady(
+      kMaxTextureUploadsPerFrame,
+      [this](const std::string& path, bgfx::TextureHandle handle,
+             uint32_t bytes) {
+        pimpl_->pending_textures.erase(path);
+        pimpl_->texture_cache[path] = {handle, bytes, pimpl_->frame_index};
+        pimpl_->texture_bytes += bytes;
+      });
+  pimpl_->EvictTextures();
+
+  pimpl_->UpdateLight();
+  pimpl_->draw_scopes.clear();
+  bgfx::setViewRect(kOutlineView, 0, 0,
+                    static_cast<uint16_t>(pimpl_->viewport_width),
+                    static_cast<uint16_t>(pimpl_->viewport_height));
+  bgfx::setViewTransform(kOutlineView, pimpl_->view, pimpl_->proj);
+  // One region is read back at a time; requests made meanwhile are dropped.
+  if (pimpl_->pick_requested && !pimpl_->pick_in_flight &&
+      pimpl_->InitPicking()) {
+    pimpl_->BeginPickPass();
+  }
+  pimpl_->pick_requested = false;
+}
+
+void Renderer::SetTextureBudget(uint64_t budget_bytes,
+                                uint32_t evict_after_frames) {
+  pimpl_->texture_budget_bytes = budget_bytes;
+  pimpl_->texture_evict_frames = evict_after_frames;
+}
+
+void Renderer::SetGpuReleaseBudget(uint32_t handles_per_frame) {
+  pimpl_->gpu_releases_per_frame = handles_per_frame;
 }
 
 void Renderer::SetShaderSearchPaths(std::vector<std::string> paths) {
@@ -350,79 +1277,258 @@ void Renderer::SetCameraViewMatrix(const float view[16]) {
   pimpl_->cam_up[0] = inv_view[4];
   pimpl_->cam_up[1] = inv_view[5];
   pimpl_->cam_up[2] = inv_view[6];
+  pimpl_->cam_pos = Eigen::Vector3d(inv_view[12], inv_view[13], inv_view[14]);
+  std::memcpy(pimpl_->view, view, sizeof(pimpl_->view));
+  pimpl_->frustum_valid = false;
+}
+
+void Renderer::SetProjection(const float proj[16], int viewport_width,
+                             int viewport_height) {
+  pimpl_->proj_y_scale = proj[5];
+  pimpl_->viewport_width = std::max(viewport_width, 1);
+  pimpl_->viewport_height = std::max(viewport_height, 1);
+  std::memcpy(pimpl_->proj, proj, sizeof(pimpl_->proj));
+  pimpl_->frustum_valid = false;
+}
+
+void Renderer::SetLabelDeclutter(bool enabled) {
+  pimpl_->label_declutter = enabled;
+}
+
+void Renderer::SetFrustumCulling(bool enabled) {
+  pimpl_->frustum_culling = enabled;
+}
+
+void Renderer::SetLighting(const Lighting& lighting) {
+  pimpl_->lighting = lighting;
+}
+
+void Renderer::SetWireframeOverlay(bool enabled, float line_width) {
+  pimpl_->wireframe_overlay =
+      enabled && bgfx::isValid(pimpl_->wireframe_program);
+  pimpl_->wireframe_width = std::max(line_width, 0.0F);
+  internal::MeshBufferManager::SetBarycentricWireframe(
+      pimpl_->wireframe_overlay);
+}
+
+bool Renderer::InFrustum(const Bounds& bounds) const {
+  if (!pimpl_->frustum_culling || bounds.IsInfinite()) {
+    return true;
+  }
+  if (bounds.IsEmpty()) {
+    return false;
+  }
+  if (!pimpl_->frustum_valid) {
+    pimpl_->UpdateFrustum();
+  }
+  for (const auto& plane : pimpl_->frustum_planes) {
+    // Corner furthest along the plane normal.
+    const Eigen::Vector3d corner(
+        plane.x() >= 0.0 ? bounds.max.x() : bounds.min.x(),
+        plane.y() >= 0.0 ? bounds.max.y() : bounds.min.y(),
+        plane.z() >= 0.0 ? bounds.max.z() : bounds.min.z());
+    if (plane.head<3>().dot(corner) + plane.w() < 0.0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Renderer::SetLodPixelThreshold(float pixels) {
+  pimpl_->lod_pixel_threshold = pixels;
+}
+
+uint32_t Renderer::SelectLod(MeshBuffer& mesh_buffer,
+                             const Eigen::Affine3d& mtx) const {
+  const uint32_t levels = internal::MeshBufferAccess::LodCount(mesh_buffer);
+  if (levels <= 1 || pimpl_->lod_pixel_threshold <= 0.0F) {
+    return 0;
+  }
+
+  const Eigen::Vector4f& sphere =
+      internal::MeshBufferAccess::BoundingSphere(mesh_buffer);
+  const Eigen::Vector3d center = mtx * sphere.head<3>().cast<double>();
+  const double scale = mtx.linear().colwise().norm().maxCoeff();
+  const double radius = static_cast<double>(sphere.w()) * scale;
+  const double distance = (center - pimpl_->cam_pos).norm();
+  if (distance <= radius) {
+    return 0;
+  }
+
+  // Projected diameter in pixels of the bounding sphere.
+  double pixels = radius * pimpl_->proj_y_scale * pimpl_->viewport_height /
+                  distance;
+  double threshold = pimpl_->lod_pixel_threshold;
+  uint32_t level = 0;
+  while (pixels < threshold && level + 1 < levels) {
+    ++level;
+    threshold *= 0.5;
+  }
+  return level;
+}
+
+bgfx::TextureHandle Renderer::Impl::ResolveTexture(
+    MeshBuffer& mesh_buffer, const std::string& texture) {
+  if (texture.empty()) {
+    return BGFX_INVALID_HANDLE;
+  }
+  if (!internal::MeshBufferAccess::HasUV(mesh_buffer)) {
+    if (warned_no_uv_textures.insert(texture).second) {
+      LogMessage(LogLevel::Warn,
+                 "Texture specified but mesh has no UV. Falling back to "
+                 "color: ",
+                 texture);
+    }
+    return BGFX_INVALID_HANDLE;
+  }
+  const auto it = texture_cache.find(texture);
+  if (it != texture_cache.end()) {
+    it->second.last_used_frame = frame_index;
+    return it->second.handle;
+  }
+  if (pending_textures.insert(texture).second) {
+    texture_loader.Request(texture, true);
+  }
+  return placeholder_texture;
 }
 
 void Renderer::Submit(MeshBuffer& mesh_buffer, const Eigen::Affine3d& mtx,
                       const Color& color, const std::string& texture,
-                      const Color& wire_color) {
-  if (color.mode != Color::ColorMode::InVisible) {
-    bgfx::setState(kAlphaState);
-    bgfx::setUniform(pimpl_->u_color, &color.base);
-    float mode_val[4] = {static_cast<float>(static_cast<int>(color.mode)), 0.0F,
-                         0.0F, 0.0F};
+                      const Color& wire_color, uint32_t lod) {
+  const bool draw_fill = color.mode != Color::ColorMode::InVisible;
+  const bool draw_wire = wire_color.mode != Color::ColorMode::InVisible;
+  if (!draw_fill && !draw_wire) {
+    return;
+  }
+  const bool highlighted = draw_fill && pimpl_->Highlighted();
+
+  // Quantized meshes store positions normalized to their bounds; fold the
+  // inverse mapping into the model matrix.
+  const Eigen::Affine3d dequantize =
+      internal::MeshBufferAccess::IsQuantized(mesh_buffer)
+          ? internal::MeshBufferAccess::DequantizeMatrix(mesh_buffer)
+          : Eigen::Affine3d::Identity();
+  const Eigen::Affine3d draw_mtx = mtx * dequantize;
+  float model_mtx[16];
+  StoreMatrix(draw_mtx, model_mtx);
+  const auto set_color = [&](const Color& c) { pimpl_->SetColorUniforms(c); };
+  // Overlay pass shading the edges, and the fill too when shade_fill is set.
+  const auto submit_overlay = [&](bool shade_fill, uint64_t state) {
+    bgfx::setState(state);
+    set_color(color);
     float rparams[4];
-    BuildRainbowParams(color.direction, rparams);
-    bgfx::setUniform(pimpl_->u_color_mode, mode_val);
-    bgfx::setUniform(pimpl_->u_rainbow_params, rparams);
-
-    const Eigen::Matrix4d& eigen_mtx = mtx.matrix();
-    float model_mtx[16];
-    for (int col = 0; col < 4; ++col) {
-      for (int row = 0; row < 4; ++row) {
-        model_mtx[(col * 4) + row] = static_cast<float>(eigen_mtx(row, col));
-      }
-    }
+    BuildRainbowParams(wire_color.direction, rparams);
+    const float wire_params[4] = {
+        pimpl_->wireframe_width,
+        static_cast<float>(static_cast<int>(wire_color.mode)),
+        shade_fill ? 1.0F : 0.0F, 0.0F};
+    bgfx::setUniform(pimpl_->u_wire_color, &wire_color.base);
+    bgfx::setUniform(pimpl_->u_wire_rainbow, rparams);
+    bgfx::setUniform(pimpl_->u_wire_params, wire_params);
     bgfx::setTransform(model_mtx);
-    const auto vbh = internal::MeshBufferAccess::VertexBuffer(mesh_buffer);
-    const auto ibh = internal::MeshBufferAccess::IndexBuffer(mesh_buffer);
-    const bool has_uv = internal::MeshBufferAccess::HasUV(mesh_buffer);
-    bgfx::setVertexBuffer(0, vbh);
-    bgfx::setIndexBuffer(ibh);
-    bool use_textured = false;
-    if (!texture.empty()) {
-      if (has_uv) {
-        auto it = pimpl_->texture_cache.find(texture);
-        if (it == pimpl_->texture_cache.end()) {
-          const bgfx::TextureHandle loaded = LoadTexture(texture, true);
-          it = pimpl_->texture_cache.emplace(texture, loaded).first;
-        }
-        if (it != pimpl_->texture_cache.end() && bgfx::isValid(it->second)) {
-          bgfx::setTexture(0, pimpl_->s_texture, it->second);
-          use_textured = true;
-        }
-      } else if (pimpl_->warned_no_uv_textures.insert(texture).second) {
-        LogMessage(LogLevel::Warn,
-                   "Texture specified but mesh has no UV. Falling back to "
-                   "color: ",
-                   texture);
-      }
+    if (highlighted && shade_fill) {
+      bgfx::setStencil(kOutlineMaskStencil);
+    }
+    bgfx::submit(0, pimpl_->wireframe_program);
+  };
+  const bool overlay = draw_wire && pimpl_->wireframe_overlay;
+
+  const Eigen::Vector4f& sphere =
+      internal::MeshBufferAccess::BoundingSphere(mesh_buffer);
+  const Eigen::Vector3d center = sphere.head<3>().cast<double>();
+  const double radius = static_cast<double>(sphere.w()) *
+                        mtx.linear().colwise().norm().maxCoeff();
+  if (pimpl_->pick_active && pimpl_->InPickRegion(mtx * center, radius)) {
+    if (const uint32_t id = pimpl_->AllocatePickIds(1);
+        id != 0 && internal::MeshBufferAccess::SetBuffers(mesh_buffer)) {
+      float pick_color[4];
+      PackPickId(id, pick_color);
+      bgfx::setUniform(pimpl_->u_pick_id, pick_color);
+      bgfx::setState(kPickState);
+      bgfx::setTransform(model_mtx);
+      bgfx::submit(kPickView, pimpl_->pick_program);
+    }
+  }
+  if (highlighted && internal::MeshBufferAccess::SetBuffers(mesh_buffer)) {
+    // Inflate about the bounding sphere center so the copy peeks out by
+    // about outline_width pixels behind the stencil mask.
+    double scale = kMaxOutlineScale;
+    if (radius > 0.0) {
+      scale = std::min(1.0 + (pimpl_->outline_width *
+                              pimpl_->WorldPerPixel(mtx * center) / radius),
+                       kMaxOutlineScale);
     }
-    bgfx::submit(0, use_textured ? pimpl_->textured_program : pimpl_->program);
+    float outline_mtx[16];
+    StoreMatrix(mtx * Eigen::Translation3d(center) * Eigen::Scaling(scale) *
+                    Eigen::Translation3d(-center) * dequantize,
+                outline_mtx);
+    bgfx::setStencil(kOutlineStencil);
+    bgfx::setState(kOutlineState);
+    set_color(pimpl_->outline_color);
+    bgfx::setTransform(outline_mtx);
+    bgfx::submit(kOutlineView,
+                 pimpl_->shaders.Get(internal::ShaderFamily::Mesh,
+                                     ColorFeatures(pimpl_->outline_color)));
   }
 
-  if (wire_color.mode != Color::ColorMode::InVisible) {
-    bgfx::setState((kAlphaState & ~BGFX_STATE_PT_MASK) | BGFX_STATE_PT_LINES);
-    bgfx::setUniform(pimpl_->u_color, &wire_color.base);
-    float mode_val[4] = {static_cast<float>(static_cast<int>(wire_color.mode)),
-                         0.0F, 0.0F, 0.0F};
-    float rparams[4];
-    BuildRainbowParams(wire_color.direction, rparams);
-    bgfx::setUniform(pimpl_->u_color_mode, mode_val);
-    bgfx::setUniform(pimpl_->u_rainbow_params, rparams);
-
-    const Eigen::Matrix4d& eigen_mtx = mtx.matrix();
-    float model_mtx[16];
-    for (int col = 0; col < 4; ++col) {
-      for (int row = 0; row < 4; ++row) {
-        model_mtx[(col * 4) + row] = static_cast<float>(eigen_mtx(row, col));
+  bool filled = false;
+  if (draw_fill) {
+    const bgfx::TextureHandle bound =
+        pimpl_->ResolveTexture(mesh_buffer, texture);
+    const bool use_textured = bgfx::isValid(bound);
+    const bool lit = !use_textured && pimpl_->lighting.enabled;
+    // Untextured fills and their edges are shaded in a single draw. Lit
+    // fills are drawn on their own and get the edges as an overlay pass.
+    if (overlay && !use_textured && !lit &&
+        internal::MeshBufferAccess::SetBarycentricBuffers(mesh_buffer)) {
+      submit_overlay(true, kAlphaState);
+      return;
+    }
+    // Edges are drawn over the full-resolution mesh, so the fill matches.
+    const uint32_t fill_lod = overlay ? 0 : lod;
+    // The cheapest program variant that covers this draw.
+    const uint32_t features = ColorFeatures(color);
+    bgfx::ProgramHandle fill_program = BGFX_INVALID_HANDLE;
+    if (lit) {
+      fill_program =
+          pimpl_->BindLitFill(mesh_buffer, fill_lod, mtx, features);
+    }
+    if (!bgfx::isValid(fill_program) &&
+        internal::MeshBufferAccess::SetBuffers(mesh_buffer, fill_lod)) {
+      const internal::ShaderFamily family =
+          use_textured ? internal::ShaderFamily::Textured
+                       : internal::ShaderFamily::Mesh;
+      fill_program = pimpl_->shaders.Get(family, features);
+    }
+    if (bgfx::isValid(fill_program)) {
+      bgfx::setState(kAlphaState);
+      set_color(color);
+      bgfx::setTransform(model_mtx);
+      if (use_textured) {
+        bgfx::setTexture(0, pimpl_->s_texture, bound);
+      }
+      if (highlighted) {
+        bgfx::setStencil(kOutlineMaskStencil);
       }
+      bgfx::submit(0, fill_program);
+      filled = true;
     }
+  }
+  if (!draw_wire) {
+    return;
+  }
+
+  if (overlay &&
+      internal::MeshBufferAccess::SetBarycentricBuffers(mesh_buffer)) {
+    submit_overlay(false, filled ? kOverlayState : kAlphaState);
+    return;
+  }
+  if (internal::MeshBufferAccess::SetWireBuffers(mesh_buffer)) {
+    bgfx::setState((kAlphaState & ~BGFX_STATE_PT_MASK) | BGFX_STATE_PT_LINES);
+    set_color(wire_color);
     bgfx::setTransform(model_mtx);
-    const auto vbh = internal::MeshBufferAccess::VertexBuffer(mesh_buffer);
-    const auto ibh = internal::MeshBufferAccess::WireIndexBuffer(mesh_buffer);
-    bgfx::setVertexBuffer(0, vbh);
-    bgfx::setIndexBuffer(ibh);
-    bgfx::submit(0, pimpl_->program);
+    bgfx::submit(0, pimpl_->shaders.Get(internal::ShaderFamily::Mesh,
+                                        ColorFeatures(wire_color)));
   }
 }
 
@@ -433,7 +1539,8 @@ void Renderer::SubmitInstanced(MeshBuffer& mesh_buffer,
   const auto instance_count = static_cast<uint32_t>(points.size());
   const uint16_t instance_stride = sizeof(float) * 4;
   if (bgfx::getAvailInstanceDataBuffer(instance_count, instance_stride) <
-      instance_count) {
+          instance_count ||
+      !internal::MeshBufferAccess::SetBuffers(mesh_buffer)) {
     return;
   }
   bgfx::allocInstanceDataBuffer(&idb, instance_count, instance_stride);
@@ -448,240 +1555,426 @@ void Renderer::SubmitInstanced(MeshBuffer& mesh_buffer,
   }
 
   bgfx::setState(kAlphaState);
-  bgfx::setUniform(pimpl_->u_color, &color.base);
-  float mode_val[4] = {static_cast<float>(static_cast<int>(color.mode)), 0.0F,
-                       0.0F, 0.0F};
-  float rparams[4];
-  BuildRainbowParams(color.direction, rparams);
-  bgfx::setUniform(pimpl_->u_color_mode, mode_val);
-  bgfx::setUniform(pimpl_->u_rainbow_params, rparams);
-
-  const Eigen::Matrix4d& eigen_mtx = mtx.matrix();
+  pimpl_->SetColorUniforms(color);
   float model_mtx[16];
-  for (int col = 0; col < 4; ++col) {
-    for (int row = 0; row < 4; ++row) {
-      model_mtx[(col * 4) + row] = static_cast<float>(eigen_mtx(row, col));
-    }
-  }
+  StoreMatrix(mtx, model_mtx);
   bgfx::setTransform(model_mtx);
-
-  const auto vbh = internal::MeshBufferAccess::VertexBuffer(mesh_buffer);
-  const auto ibh = internal::MeshBufferAccess::IndexBuffer(mesh_buffer);
-  const auto mesh_index_count =
-      internal::MeshBufferAccess::GetIndexCount(mesh_buffer);
-
-  bgfx::setVertexBuffer(0, vbh);
-  bgfx::setIndexBuffer(ibh, 0, mesh_index_count);
   bgfx::setInstanceDataBuffer(&idb);
+  const bool highlighted = pimpl_->Highlighted();
+  if (highlighted) {
+    bgfx::setStencil(kOutlineMaskStencil);
+  }
+  bgfx::submit(0, pimpl_->shaders.Get(internal::ShaderFamily::Points,
+                                      ColorFeatures(color)));
+
+  const Eigen::Vector4f& sphere =
+      internal::MeshBufferAccess::BoundingSphere(mesh_buffer);
+  const double scale = mtx.linear().colwise().norm().maxCoeff();
+  const auto world_center = [&](const Eigen::Vector4d& p) {
+    return mtx * (p.head<3>() + (p.w() * sphere.head<3>().cast<double>()));
+  };
+  if (pimpl_->pick_active &&
+      bgfx::isValid(pimpl_->pick_instanced_program)) {
+    // Only instances overlapping the pick region are drawn, but IDs cover
+    // all of them so an ID maps straight back to its point index.
+    std::vector<uint32_t> candidates;
+    for (uint32_t i = 0; i < instance_count; ++i) {
+      const double radius = std::abs(points[i].w()) * sphere.w() * scale;
+      if (pimpl_->InPickRegion(world_center(points[i]), radius)) {
+        candidates.push_back(i);
+      }
+    }
+    const auto candidate_count = static_cast<uint32_t>(candidates.size());
+    constexpr uint16_t kPickStride = sizeof(float) * 8;
+    if (candidate_count > 0 &&
+        bgfx::getAvailInstanceDataBuffer(candidate_count, kPickStride) >=
+            candidate_count) {
+      const uint32_t first_id = pimpl_->AllocatePickIds(instance_count);
+      if (first_id != 0 &&
+          internal::MeshBufferAccess::SetBuffers(mesh_buffer)) {
+        bgfx::InstanceDataBuffer pick_idb;
+        bgfx::allocInstanceDataBuffer(&pick_idb, candidate_count,
+                                      kPickStride);
+        auto* pick_data = reinterpret_cast<float*>(pick_idb.data);
+        for (const uint32_t i : candidates) {
+          for (int k = 0; k < 4; ++k) {
+            pick_data[k] = static_cast<float>(points[i][k]);
+          }
+          PackPickId(first_id + i, pick_data + 4);
+          pick_data += 8;
+        }
+        bgfx::setState(kPickState);
+        bgfx::setTransform(model_mtx);
+        bgfx::setInstanceDataBuffer(&pick_idb);
+        bgfx::submit(kPickView, pimpl_->pick_instanced_program);
+      }
+    }
+  }
 
-  bgfx::submit(0, pimpl_->instancing_program);
+  if (highlighted && sphere.w() > 0.0F && scale > 0.0 &&
+      bgfx::getAvailInstanceDataBuffer(instance_count, instance_stride) >=
+          instance_count &&
+      internal::MeshBufferAccess::SetBuffers(mesh_buffer)) {
+    // Grow each instance by outline_width pixels at its own depth.
+    bgfx::InstanceDataBuffer outline_idb;
+    bgfx::allocInstanceDataBuffer(&outline_idb, instance_count,
+                                  instance_stride);
+    auto* outline_data = reinterpret_cast<float*>(outline_idb.data);
+    for (const auto& p : points) {
+      const double grow = pimpl_->outline_width *
+                          pimpl_->WorldPerPixel(world_center(p)) /
+                          (sphere.w() * scale);
+      const double size = std::min(std::abs(p.w()) + grow,
+                                   std::abs(p.w()) * kMaxOutlineScale);
+      outline_data[0] = static_cast<float>(p.x());
+      outline_data[1] = static_cast<float>(p.y());
+      outline_data[2] = static_cast<float>(p.z());
+      outline_data[3] = static_cast<float>(size);
+      outline_data += 4;
+    }
+    bgfx::setStencil(kOutlineStencil);
+    bgfx::setState(kOutlineState);
+    pimpl_->SetColorUniforms(pimpl_->outline_color);
+    bgfx::setTransform(model_mtx);
+    bgfx::setInstanceDataBuffer(&outline_idb);
+    bgfx::submit(kOutlineView,
+                 pimpl_->shaders.Get(internal::ShaderFamily::Points,
+                                     ColorFeatures(pimpl_->outline_color)));
+  }
 }
 
 void Renderer::SubmitText(const std::string& text, const Eigen::Affine3d& mtx,
                           const Color& color, const std::string& font_path,
                           float height, TextFacingMode facing_mode,
-                          TextDepthMode depth_mode, TextAlign align) {
+                          TextDepthMode depth_mode, TextAlign align,
+                          int priority) {
   if (text.empty() || color.mode == Color::ColorMode::InVisible ||
       height <= 0.0F) {
     return;
   }
 
-  std::string resolved_font = font_path;
-  if (resolved_font.empty()) {
-    resolved_font = ResolveDefaultFontPath();
-    if (resolved_font.empty()) {
-      if (pimpl_->warned_missing_fonts.insert("<default>").second) {
-        LogMessage(LogLevel::Warn, "No default font found for text rendering.");
-      }
+  // Labels whose anchor is off screen are skipped before any glyph work.
+  Eigen::Vector4d clip = Eigen::Vector4d::Zero();
+  if (pimpl_->label_declutter) {
+    clip = pimpl_->ViewProj() * mtx.translation().homogeneous();
+    if (clip.w() <= 0.0 || clip.head<2>().cwiseAbs().maxCoeff() >
+                               kLabelCullMargin * clip.w()) {
       return;
     }
   }
-  if (!std::filesystem::exists(resolved_font)) {
-    if (pimpl_->warned_missing_fonts.insert(resolved_font).second) {
-      LogMessage(LogLevel::Warn, "Font not found: ", resolved_font);
+
+  Impl::FontAtlas* atlas = pimpl_->FindFontAtlas(font_path);
+  if (!atlas) {
+    return;
+  }
+
+  // Layouts depend only on the string, so they are built once and reused
+  // until the label text changes.
+  Impl::TextLayoutMap& layouts = atlas->layouts[static_cast<int>(align)];
+  auto it = layouts.find(std::string_view(text));
+  if (it == layouts.end()) {
+    it = layouts.emplace(text, Impl::BuildTextLayout(*atlas, text, align))
+             .first;
+  }
+  Impl::TextLayout& layout = it->second;
+  layout.last_used_frame = pimpl_->frame_index;
+  if (layout.quads.empty()) {
+    return;
+  }
+
+  Impl::PendingLabel label{atlas, &layout, mtx, color, height,
+                           facing_mode, depth_mode, priority, clip};
+  label.highlighted = pimpl_->Highlighted();
+  if (pimpl_->pick_active) {
+    // IDs are taken while the object scope is open; decluttered labels that
+    // end up hidden simply never draw theirs.
+    Eigen::Vector3d ax;
+    Eigen::Vector3d ay;
+    pimpl_->LabelAxes(mtx, height / atlas->glyphs.PixelHeight(), facing_mode,
+                      ax, ay);
+    const Eigen::Vector3d center =
+        mtx.translation() + (ax * 0.5 * (layout.min_x + layout.max_x)) +
+        (ay * 0.5 * (layout.min_y + layout.max_y));
+    const double radius = 0.5 * ((ax * (layout.max_x - layout.min_x)).norm() +
+                                 (ay * (layout.max_y - layout.min_y)).norm());
+    if (pimpl_->InPickRegion(center, radius)) {
+      label.pick_id = pimpl_->AllocatePickIds(1);
     }
+  }
+
+  if (pimpl_->label_declutter) {
+    pimpl_->pending_labels.push_back(label);
     return;
   }
+  pimpl_->EmitText(*atlas, layout, mtx, color, height, facing_mode,
+                   depth_mode);
+  pimpl_->SubmitLabelMarks(label);
+}
 
-  const int pixel_height = 48;
-  const std::string font_key =
-      resolved_font + "#" + std::to_string(pixel_height);
-  auto it = pimpl_->font_cache.find(font_key);
-  if (it == pimpl_->font_cache.end()) {
-    Impl::FontAtlas atlas;
-    if (!LoadFontAtlas(atlas.texture, atlas.width, atlas.height, atlas.glyphs,
-                       resolved_font, pixel_height)) {
-      if (pimpl_->warned_missing_fonts.insert(font_key).second) {
-        LogMessage(LogLevel::Warn,
-                   "Failed to bake font atlas: ", resolved_font);
-      }
-      return;
+void Renderer::Impl::EmitText(FontAtlas& atlas, const TextLayout& layout,
+                              const Eigen::Affine3d& mtx, const Color& color,
+                              float height, TextFacingMode facing_mode,
+                              TextDepthMode depth_mode) {
+  const double scale =
+      static_cast<double>(height) / atlas.glyphs.PixelHeight();
+  float rparams[4];
+  BuildRainbowParams(color.direction, rparams);
+  const bool rainbow = color.mode == Color::ColorMode::Rainbow;
+  const float vertex_rainbow[4] = {rparams[0] * rparams[3],
+                                   rparams[1] * rparams[3],
+                                   rparams[2] * rparams[3],
+                                   rainbow ? 1.0F : 0.0F};
+  // Billboards are expanded on the GPU, so their instances do not depend on
+  // the camera and cost one copy per glyph.
+  if (facing_mode == TextFacingMode::Billboard &&
+      bgfx::isValid(text_billboard_program)) {
+    const Eigen::Matrix3d linear = mtx.linear();
+    const auto sx = static_cast<float>(linear.col(0).norm() * scale);
+    const auto sy = static_cast<float>(linear.col(1).norm() * scale);
+    Impl::GlyphInstance proto{};
+    proto.anchor[0] = static_cast<float>(mtx.translation().x());
+    proto.anchor[1] = static_cast<float>(mtx.translation().y());
+    proto.anchor[2] = static_cast<float>(mtx.translation().z());
+    std::copy(color.base, color.base + 4, proto.color);
+    std::copy(vertex_rainbow, vertex_rainbow + 4, proto.rainbow);
+    for (const Impl::GlyphQuad& q : layout.quads) {
+      Impl::GlyphInstance& glyph =
+          atlas.Batch(q.page, depth_mode).billboards.emplace_back(proto);
+      glyph.rect[0] = q.x0 * sx;
+      glyph.rect[1] = q.y0 * sy;
+      glyph.rect[2] = q.x1 * sx;
+      glyph.rect[3] = q.y1 * sy;
+      glyph.uv[0] = q.s0;
+      glyph.uv[1] = q.t0;
+      glyph.uv[2] = q.s1;
+      glyph.uv[3] = q.t1;
     }
-    atlas.pixel_height = pixel_height;
-    it = pimpl_->font_cache.emplace(font_key, std::move(atlas)).first;
+    return;
   }
-  Impl::FontAtlas& atlas = it->second;
 
-  struct TextVertex {
-    float x;
-    float y;
-    float z;
-    float u;
-    float v;
+  Eigen::Vector3d ax;
+  Eigen::Vector3d ay;
+  LabelAxes(mtx, scale, facing_mode, ax, ay);
+  const Eigen::Vector3f origin = mtx.translation().cast<float>();
+  const Eigen::Vector3f axf = ax.cast<float>();
+  const Eigen::Vector3f ayf = ay.cast<float>();
+
+  Impl::TextVertex proto{};
+  proto.abgr = PackAbgr(color.base);
+  std::copy(vertex_rainbow, vertex_rainbow + 4, proto.rainbow);
+
+  Impl::TextRun run{};
+  std::copy(color.base, color.base + 4, run.color);
+  run.mode[0] = static_cast<float>(static_cast<int>(color.mode));
+  std::copy(rparams, rparams + 4, run.rainbow);
+
+  Impl::TextBatch* batch = nullptr;
+  const auto emit = [&](float lx, float ly, float u, float v) {
+    const Eigen::Vector3f p = origin + (axf * lx) + (ayf * ly);
+    Impl::TextVertex& vtx = batch->vertices.emplace_back(proto);
+    vtx.x = p.x();
+    vtx.y = p.y();
+    vtx.z = p.z();
+    vtx.u = u;
+    vtx.v = v;
   };
-  static bgfx::VertexLayout layout = []() {
+  for (const Impl::GlyphQuad& q : layout.quads) {
+    // A run covers consecutive quads of this label on one atlas page.
+    Impl::TextBatch& target = atlas.Batch(q.page, depth_mode);
+    if (&target != batch || target.runs.empty()) {
+      batch = &target;
+      run.first_quad = static_cast<uint32_t>(batch->vertices.size() / 4);
+      run.quad_count = 0;
+      batch->runs.push_back(run);
+    }
+    ++batch->runs.back().quad_count;
+    emit(q.x0, q.y0, q.s0, q.t0);
+    emit(q.x1, q.y0, q.s1, q.t0);
+    emit(q.x1, q.y1, q.s1, q.t1);
+    emit(q.x0, q.y1, q.s0, q.t1);
+  }
+}
+
+void Renderer::Impl::LabelAxes(const Eigen::Affine3d& mtx, double scale,
+                               TextFacingMode facing_mode,
+                               Eigen::Vector3d& ax,
+                               Eigen::Vector3d& ay) const {
+  if (facing_mode == TextFacingMode::Billboard) {
+    const Eigen::Matrix3d linear = mtx.linear();
+    ax = Eigen::Vector3d(cam_right[0], cam_right[1], cam_right[2]) *
+         (linear.col(0).norm() * scale);
+    ay = Eigen::Vector3d(cam_up[0], cam_up[1], cam_up[2]) *
+         (linear.col(1).norm() * scale);
+  } else {
+    ax = mtx.linear().col(0) * scale;
+    ay = mtx.linear().col(1) * scale;
+  }
+}
+
+void Renderer::Impl::SubmitLabelMarks(const PendingLabel& label) {
+  if (label.pick_id == 0 && !label.highlighted) {
+    return;
+  }
+  const TextLayout& layout = *label.layout;
+  const double scale = static_cast<double>(label.height) /
+                       label.atlas->glyphs.PixelHeight();
+  Eigen::Vector3d ax;
+  Eigen::Vector3d ay;
+  LabelAxes(label.mtx, scale, label.facing_mode, ax, ay);
+  const Eigen::Vector3d anchor = label.mtx.translation();
+
+  static bgfx::VertexLayout position_layout = []() {
     bgfx::VertexLayout l;
-    l.begin()
-        .add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float)
-        .add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float)
-        .end();
+    l.begin().add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float).end();
     return l;
   }();
-
-  std::vector<TextVertex> vertices;
-  std::vector<uint16_t> indices;
-  vertices.reserve(text.size() * 4U);
-  indices.reserve(text.size() * 6U);
-
-  const float scale = height / static_cast<float>(atlas.pixel_height);
-  const Eigen::Vector3d anchor = mtx.translation();
-  const Eigen::Matrix3d linear = mtx.linear();
-  const double sx = linear.col(0).norm();
-  const double sy = linear.col(1).norm();
-  const Eigen::Vector3d billboard_right(
-      static_cast<double>(pimpl_->cam_right[0]) * sx,
-      static_cast<double>(pimpl_->cam_right[1]) * sx,
-      static_cast<double>(pimpl_->cam_right[2]) * sx);
-  const Eigen::Vector3d billboard_up(
-      static_cast<double>(pimpl_->cam_up[0]) * sy,
-      static_cast<double>(pimpl_->cam_up[1]) * sy,
-      static_cast<double>(pimpl_->cam_up[2]) * sy);
-  const float line_height = height * 1.2F;
-  std::vector<std::string> lines;
-  lines.emplace_back();
-  for (const char ch : text) {
-    if (ch == '\n') {
-      lines.emplace_back();
-      continue;
+  const float identity[16] = {1.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F, 0.0F, 0.0F,
+                              0.0F, 0.0F, 1.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F};
+  // Rects are (x0, y0, x1, y1) in layout units; uniforms are set by the
+  // caller.
+  const auto submit_rects = [&](std::span<const Eigen::Vector4d> rects,
+                                bgfx::ViewId view, uint64_t state,
+                                bgfx::ProgramHandle program) {
+    const auto vertex_count = static_cast<uint32_t>(rects.size() * 4);
+    const auto index_count = static_cast<uint32_t>(rects.size() * 6);
+    if (bgfx::getAvailTransientVertexBuffer(vertex_count, position_layout) <
+            vertex_count ||
+        bgfx::getAvailTransientIndexBuffer(index_count) < index_count) {
+      return;
     }
-    lines.back().push_back(ch);
-  }
-
-  for (size_t li = 0; li < lines.size(); ++li) {
-    const std::string& line = lines[li];
-    float width_px = 0.0F;
-    {
-      float tmp_x = 0.0F;
-      float tmp_y = 0.0F;
-      for (const char ch : line) {
-        if (ch < 32 || ch >= 128) {
-          continue;
-        }
-        stbtt_aligned_quad q{};
-        stbtt_GetBakedQuad(atlas.glyphs, atlas.width, atlas.height, ch - 32,
-                           &tmp_x, &tmp_y, &q, 1);
+    bgfx::TransientVertexBuffer tvb;
+    bgfx::TransientIndexBuffer tib;
+    bgfx::allocTransientVertexBuffer(&tvb, vertex_count, position_layout);
+    bgfx::allocTransientIndexBuffer(&tib, index_count);
+    auto* pos = reinterpret_cast<float*>(tvb.data);
+    auto* idx = reinterpret_cast<uint16_t*>(tib.data);
+    for (std::size_t i = 0; i < rects.size(); ++i) {
+      const Eigen::Vector4d& r = rects[i];
+      const double corners[4][2] = {
+          {r[0], r[1]}, {r[2], r[1]}, {r[2], r[3]}, {r[0], r[3]}};
+      for (const auto& c : corners) {
+        const Eigen::Vector3d p = anchor + (ax * c[0]) + (ay * c[1]);
+        *pos++ = static_cast<float>(p.x());
+        *pos++ = static_cast<float>(p.y());
+        *pos++ = static_cast<float>(p.z());
       }
-      width_px = tmp_x;
+      const auto base = static_cast<uint16_t>(i * 4);
+      const uint16_t quad[6] = {base,
+                                static_cast<uint16_t>(base + 1),
+                                static_cast<uint16_t>(base + 2),
+                                base,
+                                static_cast<uint16_t>(base + 2),
+                                static_cast<uint16_t>(base + 3)};
+      std::memcpy(idx + (i * 6), quad, sizeof(quad));
     }
+    bgfx::setState(state);
+    bgfx::setTransform(identity);
+    bgfx::setVertexBuffer(0, &tvb);
+    bgfx::setIndexBuffer(&tib);
+    bgfx::submit(view, program);
+  };
 
-    float pen_x = 0.0F;
-    if (align == TextAlign::Center) {
-      pen_x = -0.5F * width_px;
-    } else if (align == TextAlign::Right) {
-      pen_x = -width_px;
+  const Eigen::Vector4d bounds(layout.min_x, layout.min_y, layout.max_x,
+                               layout.max_y);
+  if (label.pick_id != 0) {
+    float pick_color[4];
+    PackPickId(label.pick_id, pick_color);
+    bgfx::setUniform(u_pick_id, pick_color);
+    uint64_t state = kPickState & ~BGFX_STATE_CULL_MASK;
+    if (label.depth_mode == TextDepthMode::AlwaysVisible) {
+      state &= ~BGFX_STATE_DEPTH_TEST_MASK;
     }
-    float pen_y =
-        static_cast<float>(li) * static_cast<float>(atlas.pixel_height) * 1.2F;
+    submit_rects({&bounds, 1}, kPickView, state, pick_program);
+  }
+  const double unit_x = ax.norm();
+  const double unit_y = ay.norm();
+  if (label.highlighted && unit_x > 0.0 && unit_y > 0.0) {
+    // Labels draw no stencil mask, so the outline is a frame around the
+    // layout bounds instead of a silhouette.
+    const Eigen::Vector3d center =
+        anchor + (ax * 0.5 * (bounds[0] + bounds[2])) +
+        (ay * 0.5 * (bounds[1] + bounds[3]));
+    const double width = outline_width * WorldPerPixel(center);
+    const double px = width / unit_x;
+    const double py = width / unit_y;
+    const double x0 = bounds[0] - px;
+    const double y0 = bounds[1] - py;
+    const double x1 = bounds[2] + px;
+    const double y1 = bounds[3] + py;
+    const Eigen::Vector4d frame[4] = {
+        {x0, y0, x1, bounds[1]},
+        {x0, bounds[3], x1, y1},
+        {x0, bounds[1], bounds[0], bounds[3]},
+        {bounds[2], bounds[1], x1, bounds[3]},
+    };
+    SetColorUniforms(outline_color);
+    submit_rects(frame, kOutlineView, kOutlineState,
+                 shaders.Get(internal::ShaderFamily::Mesh,
+                             ColorFeatures(outline_color)));
+  }
+}
 
-    for (const char ch : line) {
-      if (ch < 32 || ch >= 128) {
-        continue;
-      }
-      stbtt_aligned_quad q{};
-      stbtt_GetBakedQuad(atlas.glyphs, atlas.width, atlas.height, ch - 32,
-                         &pen_x, &pen_y, &q, 1);
-
-      const float lx0 = q.x0 * scale;
-      const float ly0 = -q.y0 * scale - line_height;
-      const float lx1 = q.x1 * scale;
-      const float ly1 = -q.y1 * scale - line_height;
-
-      const auto to_world = [&](float lx, float ly) -> Eigen::Vector3d {
-        if (facing_mode == TextFacingMode::Billboard) {
-          return anchor + billboard_right * static_cast<double>(lx) +
-                 billboard_up * static_cast<double>(ly);
-        }
-        return mtx * Eigen::Vector3d(lx, ly, 0.0);
-      };
-
-      const Eigen::Vector3d p0 = to_world(lx0, ly0);
-      const Eigen::Vector3d p1 = to_world(lx1, ly0);
-      const Eigen::Vector3d p2 = to_world(lx1, ly1);
-      const Eigen::Vector3d p3 = to_world(lx0, ly1);
-
-      const uint16_t base = static_cast<uint16_t>(vertices.size());
-      vertices.push_back({static_cast<float>(p0.x()),
-                          static_cast<float>(p0.y()),
-                          static_cast<float>(p0.z()), q.s0, q.t0});
-      vertices.push_back({static_cast<float>(p1.x()),
-                          static_cast<float>(p1.y()),
-                          static_cast<float>(p1.z()), q.s1, q.t0});
-      vertices.push_back({static_cast<float>(p2.x()),
-                          static_cast<float>(p2.y()),
-                          static_cast<float>(p2.z()), q.s1, q.t1});
-      vertices.push_back({static_cast<float>(p3.x()),
-                          static_cast<float>(p3.y()),
-                          static_cast<float>(p3.z()), q.s0, q.t1});
-      indices.push_back(base + 0);
-      indices.push_back(base + 1);
-      indices.push_back(base + 2);
-      indices.push_back(base + 0);
-      indices.push_back(base + 2);
-      indices.push_back(base + 3);
-    }
-  }
-
-  if (vertices.empty() || indices.empty()) {
-    return;
+void Renderer::EndFrame() {
+  if (pimpl_->label_declutter) {
+    pimpl_->DeclutterLabels();
+  }
+  pimpl_->FlushText();
+
+  Impl& impl = *pimpl_;
+  if (impl.pick_active) {
+    bgfx::blit(kPickBlitView, impl.pick_readback, 0, 0, impl.pick_color);
+    impl.pick_ready_frame =
+        bgfx::readTexture(impl.pick_readback, impl.pick_pixels.data());
+    impl.pick_flight_draws.swap(impl.pick_draws);
+    impl.pick_draws.clear();
+    impl.pick_in_flight = true;
+    impl.pick_active = false;
   }
+}
 
-  if (bgfx::getAvailTransientVertexBuffer(
-          static_cast<uint32_t>(vertices.size()), layout) <
-          static_cast<uint32_t>(vertices.size()) ||
-      bgfx::getAvailTransientIndexBuffer(static_cast<uint32_t>(
-          indices.size())) < static_cast<uint32_t>(indices.size())) {
-    return;
+void Renderer::BeginObject(const ObjectBase* object) {
+  const bool highlighted = pimpl_->Highlighted() ||
+                           pimpl_->highlighted_objects.contains(object);
+  pimpl_->draw_scopes.push_back({object, highlighted});
+}
+
+void Renderer::EndObject() {
+  if (!pimpl_->draw_scopes.empty()) {
+    pimpl_->draw_scopes.pop_back();
   }
+}
 
-  bgfx::TransientVertexBuffer tvb;
-  bgfx::TransientIndexBuffer tib;
-  bgfx::allocTransientVertexBuffer(&tvb, static_cast<uint32_t>(vertices.size()),
-                                   layout);
-  bgfx::allocTransientIndexBuffer(&tib, static_cast<uint32_t>(indices.size()));
-  std::memcpy(tvb.data, vertices.data(), vertices.size() * sizeof(TextVertex));
-  std::memcpy(tib.data, indices.data(), indices.size() * sizeof(uint16_t));
+void Renderer::SetHighlightedObjects(std::vector<const ObjectBase*> objects) {
+  pimpl_->highlighted_objects.clear();
+  pimpl_->highlighted_objects.insert(objects.begin(), objects.end());
+}
 
-  uint64_t state =
-      BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_BLEND_ALPHA;
-  if (depth_mode == TextDepthMode::DepthTest) {
-    state |= BGFX_STATE_DEPTH_TEST_LESS | BGFX_STATE_WRITE_Z;
+void Renderer::SetOutlineStyle(const Color& color, float width) {
+  pimpl_->outline_color = color;
+  pimpl_->outline_width = std::max(width, 0.0F);
+}
+
+void Renderer::RequestPick(int x, int y) {
+  pimpl_->pick_requested = true;
+  pimpl_->pick_x = x;
+  pimpl_->pick_y = y;
+}
+
+void Renderer::OnFrameSubmitted(uint32_t frame_number) {
+  if (pimpl_->pick_in_flight && frame_number >= pimpl_->pick_ready_frame) {
+    pimpl_->DecodePick();
+    pimpl_->pick_in_flight = false;
   }
-  bgfx::setState(state);
-  bgfx::setUniform(pimpl_->u_color, &color.base);
-  float mode_val[4] = {static_cast<float>(static_cast<int>(color.mode)), 0.0F,
-                       0.0F, 0.0F};
-  float rparams[4];
-  BuildRainbowParams(color.direction, rparams);
-  bgfx::setUniform(pimpl_->u_color_mode, mode_val);
-  bgfx::setUniform(pimpl_->u_rainbow_params, rparams);
+}
 
-  const float identity[16] = {1.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F, 0.0F, 0.0F,
-                              0.0F, 0.0F, 1.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F};
-  bgfx::setTransform(identity);
-  bgfx::setVertexBuffer(0, &tvb);
-  bgfx::setIndexBuffer(&tib);
-  bgfx::setTexture(0, pimpl_->s_texture, atlas.texture);
-  bgfx::submit(0, pimpl_->textured_program);
+bool Renderer::FetchPick(const ObjectBase*& object, uint32_t& instance) {
+  if (!pimpl_->pick_result_ready) {
+    return false;
+  }
+  pimpl_->pick_result_ready = false;
+  object = pimpl_->pick_object;
+  instance = pimpl_->pick_instance;
+  return true;
 }
 
 void Renderer::PrintBackend() {
@@ -0,0 +1,422 @@
+#include "livision/ScenePool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "livision/Renderer.hpp"
+
+namespace livision {
+namespace {
+constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+enum EntityFlag : uint8_t {
+  kAlive = 1U << 0U,
+  kVisible = 1U << 1U,
+  kLocalDirty = 1U << 2U,
+  kWorldVisible = 1U << 3U,
+};
+
+const std::string kNoTexture;
+}  // namespace
+
+// Per-entity state lives in parallel arrays indexed by slot. Hot data for the
+// transform pass (pose, matrices, parent, flags) is kept apart from the
+// colors and mesh references that are only read when drawing.
+struct ScenePool::Impl {
+  std::vector<Eigen::Vector3f> pos;
+  std::vector<Eigen::Quaternionf> rot;
+  std::vector<Eigen::Vector3f> scale;
+  std::vector<Eigen::Affine3f> local;
+  std::vector<Eigen::Affine3f> world;
+  std::vector<Bounds> bounds;  // World-space, for culling
+  std::vector<uint32_t> parent;
+  std::vector<uint32_t> generation;
+  std::vector<uint8_t> flags;
+  std::vector<uint32_t> mesh;  // Index into meshes, or kNone
+  std::vector<Color> color;
+  std::vector<Color> wire_color;
+
+  // Meshes are shared by many entities, so entities store a small index.
+  // Each id is counted per referencing entity and freed on its last use.
+  std::vector<std::shared_ptr<MeshBuffer>> meshes;
+  std::vector<uint32_t> mesh_refs;
+  // Local bounds of each mesh, refreshed every UpdateMatrix since any mesh
+  // may be edited in place (UpdateVertices, Resize).
+  std::vector<Bounds> mesh_bounds;
+  std::unordered_map<const MeshBuffer*, uint32_t> mesh_ids;
+  std::vector<uint32_t> free_mesh_ids;
+
+  std::vector<uint32_t> free_slots;
+  std::size_t live_count = 0;
+
+  // Live slots with every parent before its children; rebuilt lazily when
+  // the hierarchy changes.
+  std::vector<uint32_t> order;
+  bool order_dirty = false;
+
+  bool Valid(Handle handle) const {
+    return handle.index < flags.size() &&
+           generation[handle.index] == handle.generation &&
+           (flags[handle.index] & kAlive) != 0;
+  }
+  uint32_t MeshId(std::shared_ptr<MeshBuffer> mesh_buffer);
+  void ReleaseMesh(uint32_t id);
+  void RebuildOrder();
+};
+
+uint32_t ScenePool::Impl::MeshId(std::shared_ptr<MeshBuffer> mesh_buffer) {
+  if (!mesh_buffer) {
+    return kNone;
+  }
+  if (const auto it = mesh_ids.find(mesh_buffer.get());
+      it != mesh_ids.end()) {
+    ++mesh_refs[it->second];
+    return it->second;
+  }
+  uint32_t id = 0;
+  if (!free_mesh_ids.empty()) {
+    id = free_mesh_ids.back();
+    free_mesh_ids.pop_back();
+  } else {
+    id = static_cast<uint32_t>(meshes.size());
+    meshes.emplace_back();
+    mesh_refs.push_back(0);
+    mesh_bounds.emplace_back();
+  }
+  mesh_ids.emplace(mesh_buffer.get(), id);
+  mesh_bounds[id] = mesh_buffer->GetLocalBounds();
+  meshes[id] = std::move(mesh_buffer);
+  mesh_refs[id] = 1;
+  return id;
+}
+
+void ScenePool::Impl::ReleaseMesh(uint32_t id) {
+  if (id == kNone || --mesh_refs[id] != 0) {
+    return;
+  }
+  mesh_ids.erase(meshes[id].get());
+  meshes[id].reset();
+  mesh_bounds[id] = Bounds::Empty();
+  free_mesh_ids.push_back(id);
+}
+
+void ScenePool::Impl::RebuildOrder() {
+  // Counting sort by depth keeps parents ahead of children without a
+  // recursive walk.
+  std::vector<uint32_t> depth(flags.size(), kNone);
+  uint32_t max_depth = 0;
+  std::vector<uint32_t> chain;
+  for (uint32_t i = 0; i < flags.size(); ++i) {
+    if ((flags[i] & kAlive) == 0 || depth[i] != kNone) {
+      continue;
+    }
+    uint32_t node = i;
+    while (node != kNone && depth[node] == kNone) {
+      chain.push_back(node);
+      node = parent[node];
+    }
+    uint32_t d = node == kNone ? 0 : depth[node] + 1;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+      depth[*it] = d++;
+    }
+    max_depth = std::max(max_depth, d - 1);
+    chain.clear();
+  }
+
+  std::vector<uint32_t> offsets(std::size_t{max_depth} + 2, 0);
+  for (uint32_t i = 0; i < flags.size(); ++i) {
+    if ((flags[i] & kAlive) != 0) {
+      ++offsets[depth[i] + 1];
+    }
+  }
+  for (std::size_t d = 1; d < offsets.size(); ++d) {
+    offsets[d] += offsets[d - 1];
+  }
+  order.resize(live_count);
+  for (uint32_t i = 0; i < flags.size(); ++i) {
+    if ((flags[i] & kAlive) != 0) {
+      order[offsets[depth[i]]++] = i;
+    }
+  }
+  order_dirty = false;
+}
+
+ScenePool::ScenePool(Params params)
+    : ObjectBase(std::move(params)), pimpl_(std::make_unique<Impl>()) {}
+
+ScenePool::~ScenePool() = default;
+
+void ScenePool::UpdateMatrix(const Eigen::Affine3d& parent_mtx) {
+  if (local_mtx_changed_) {
+    Eigen::Affine3d translation(Eigen::Translation3d(params_.pos));
+    Eigen::Affine3d rotation(params_.quat);
+    Eigen::Affine3d scale(Eigen::Scaling(params_.scale));
+
+    local_mtx_ = translation * rotation * scale;
+    local_mtx_changed_ = false;
+  }
+  global_mtx_ = parent_mtx * local_mtx_;
+
+  Impl& impl = *pimpl_;
+  if (impl.order_dirty) {
+    impl.RebuildOrder();
+  }
+  for (std::size_t id = 0; id < impl.meshes.size(); ++id) {
+    if (impl.meshes[id]) {
+      impl.mesh_bounds[id] = impl.meshes[id]->GetLocalBounds();
+    }
+  }
+  const Eigen::Affine3f root = global_mtx_.cast<float>();
+  world_bounds_ = Bounds::Empty();
+  for (const uint32_t i : impl.order) {
+    uint8_t& flags = impl.flags[i];
+    if ((flags & kLocalDirty) != 0) {
+      impl.local[i] = Eigen::Translation3f(impl.pos[i]) * impl.rot[i] *
+                      Eigen::Scaling(impl.scale[i]);
+      flags &= ~kLocalDirty;
+    }
+    const uint32_t p = impl.parent[i];
+    const bool parent_visible =
+        p == kNone || (impl.flags[p] & kWorldVisible) != 0;
+    impl.world[i] = (p == kNone ? root : impl.world[p]) * impl.local[i];
+    if (parent_visible && (flags & kVisible) != 0) {
+      flags |= kWorldVisible;
+    } else {
+      flags &= ~kWorldVisible;
+    }
+
+    if (impl.mesh[i] == kNone) {
+      impl.bounds[i] = Bounds::Empty();
+      continue;
+    }
+    const Bounds& mesh_bounds = impl.mesh_bounds[impl.mesh[i]];
+    if (mesh_bounds.IsEmpty() || mesh_bounds.IsInfinite()) {
+      impl.bounds[i] = mesh_bounds;
+    } else {
+      const Eigen::Affine3f& mtx = impl.world[i];
+      const Eigen::Vector3f center =
+          mtx * (0.5 * (mesh_bounds.min + mesh_bounds.max)).cast<float>();
+      const Eigen::Vector3f extent =
+          mtx.linear().cwiseAbs() *
+          (0.5 * (mesh_bounds.max - mesh_bounds.min)).cast<float>();
+      impl.bounds[i] = Bounds::FromMinMax((center - extent).cast<double>(),
+                                          (center + extent).cast<double>());
+    }
+    world_bounds_.Extend(impl.bounds[i]);
+  }
+}
+
+void ScenePool::OnDraw(Renderer& renderer) {
+  Impl& impl = *pimpl_;
+  for (const uint32_t i : impl.order) {
+    if ((impl.flags[i] & kWorldVisible) == 0 || impl.mesh[i] == kNone ||
+        !renderer.InFrustum(impl.bounds[i])) {
+      continue;
+    }
+    MeshBuffer& mesh_buffer = *impl.meshes[impl.mesh[i]];
+    const Eigen::Affine3d mtx = impl.world[i].cast<double>();
+    renderer.Submit(mesh_buffer, mtx, impl.color[i], kNoTexture,
+                    impl.wire_color[i], renderer.SelectLod(mesh_buffer, mtx));
+  }
+}
+
+ScenePool::Entity ScenePool::Add(std::shared_ptr<MeshBuffer> mesh,
+                                 Handle parent) {
+  Impl& impl = *pimpl_;
+  uint32_t slot = 0;
+  if (!impl.free_slots.empty()) {
+    slot = impl.free_slots.back();
+    impl.free_slots.pop_back();
+  } else {
+    slot = static_cast<uint32_t>(impl.flags.size());
+    impl.pos.emplace_back();
+    impl.rot.emplace_back();
+    impl.scale.emplace_back();
+    impl.local.emplace_back();
+    impl.world.emplace_back();
+    impl.bounds.emplace_back();
+    impl.parent.push_back(kNone);
+    impl.generation.push_back(0);
+    impl.flags.push_back(0);
+    impl.mesh.push_back(kNone);
+    impl.color.push_back(params_.color);
+    impl.wire_color.push_back(params_.wire_color);
+  }
+
+  impl.pos[slot] = Eigen::Vector3f::Zero();
+  impl.rot[slot] = Eigen::Quaternionf::Identity();
+  impl.scale[slot] = Eigen::Vector3f::Ones();
+  impl.world[slot] = Eigen::Affine3f::Identity();
+  impl.bounds[slot] = Bounds::Empty();
+  impl.parent[slot] = impl.Valid(parent) ? parent.index : kNone;
+  impl.flags[slot] = kAlive | kVisible | kLocalDirty;
+  impl.mesh[slot] = impl.MeshId(std::move(mesh));
+  impl.color[slot] = params_.color;
+  impl.wire_color[slot] = params_.wire_color;
+
+  ++impl.live_count;
+  impl.order_dirty = true;
+  return {this, Handle{slot, impl.generation[slot]}};
+}
+
+void ScenePool::Destroy(Handle handle) {
+  Impl& impl = *pimpl_;
+  if (!impl.Valid(handle)) {
+    return;
+  }
+  if (impl.order_dirty) {
+    impl.RebuildOrder();
+  }
+  // Descendants come after their parents in order, so one pass from the
+  // destroyed entity onward catches the whole subtree.
+  impl.flags[handle.index] &= ~kAlive;
+  const auto start =
+      std::find(impl.order.begin(), impl.order.end(), handle.index);
+  for (auto it = start; it != impl.order.end(); ++it) {
+    const uint32_t i = *it;
+    const uint32_t p = impl.parent[i];
+    if (i != handle.index &&
+        (p == kNone || (impl.flags[p] & kAlive) != 0)) {
+      continue;
+    }
+    impl.flags[i] &= ~kAlive;
+    impl.parent[i] = kNone;
+    impl.ReleaseMesh(impl.mesh[i]);
+    impl.mesh[i] = kNone;
+    ++impl.generation[i];
+    impl.free_slots.push_back(i);
+    --impl.live_count;
+  }
+  impl.order_dirty = true;
+}
+
+void ScenePool::Clear() {
+  Impl& impl = *pimpl_;
+  impl.free_slots.clear();
+  // Generations keep counting so handles from before the clear stay invalid.
+  for (uint32_t i = 0; i < impl.flags.size(); ++i) {
+    if ((impl.flags[i] & kAlive) != 0) {
+      ++impl.generation[i];
+    }
+    impl.flags[i] = 0;
+    impl.parent[i] = kNone;
+    impl.mesh[i] = kNone;
+    impl.free_slots.push_back(i);
+  }
+  impl.meshes.clear();
+  impl.mesh_refs.clear();
+  impl.mesh_bounds.clear();
+  impl.mesh_ids.clear();
+  impl.free_mesh_ids.clear();
+  impl.order.clear();
+  impl.live_count = 0;
+  impl.order_dirty = false;
+}
+
+bool ScenePool::SetParent(Handle handle, Handle parent) {
+  Impl& impl = *pimpl_;
+  if (!impl.Valid(handle)) {
+    return false;
+  }
+  uint32_t new_parent = kNone;
+  if (impl.Valid(parent)) {
+    for (uint32_t node = parent.index; node != kNone;
+         node = impl.parent[node]) {
+      if (node == handle.index) {
+        return false;
+      }
+    }
+    new_parent = parent.index;
+  }
+  impl.parent[handle.index] = new_parent;
+  impl.order_dirty = true;
+  return true;
+}
+
+bool ScenePool::IsValid(Handle handle) const { return pimpl_->Valid(handle); }
+
+std::size_t ScenePool::Size() const { return pimpl_->live_count; }
+
+ScenePool::Entity& ScenePool::Entity::SetPos(const Eigen::Vector3d& pos) {
+  if (IsValid()) {
+    pool_->pimpl_->pos[handle_.index] = pos.cast<float>();
+    pool_->pimpl_->flags[handle_.index] |= kLocalDirty;
+  }
+  return *this;
+}
+
+ScenePool::Entity& ScenePool::Entity::SetPos(double x, double y, double z) {
+  return SetPos(Eigen::Vector3d(x, y, z));
+}
+
+ScenePool::Entity& ScenePool::Entity::SetScale(const Eigen::Vector3d& scale) {
+  if (IsValid()) {
+    pool_->pimpl_->scale[handle_.index] = scale.cast<float>();
+    pool_->pimpl_->flags[handle_.index] |= kLocalDirty;
+  }
+  return *this;
+}
+
+ScenePool::Entity& ScenePool::Entity::SetQuatRotation(
+    const Eigen::Quaterniond& q) {
+  if (IsValid()) {
+    pool_->pimpl_->rot[handle_.index] = q.cast<float>();
+    pool_->pimpl_->flags[handle_.index] |= kLocalDirty;
+  }
+  return *this;
+}
+
+ScenePool::Entity& ScenePool::Entity::SetDegRotation(
+    const Eigen::Vector3d& euler_deg) {
+  Eigen::Vector3d euler_rad = euler_deg * M_PI / 180.0;
+  return SetRadRotation(euler_rad);
+}
+
+ScenePool::Entity& ScenePool::Entity::SetRadRotation(
+    const Eigen::Vector3d& euler_rad) {
+  Eigen::Quaterniond q =
+      Eigen::AngleAxisd(euler_rad[2], Eigen::Vector3d::UnitZ()) *
+      Eigen::AngleAxisd(euler_rad[1], Eigen::Vector3d::UnitY()) *
+      Eigen::AngleAxisd(euler_rad[0], Eigen::Vector3d::UnitX());
+  return SetQuatRotation(q);
+}
+
+ScenePool::Entity& ScenePool::Entity::SetVisible(bool visible) {
+  if (IsValid()) {
+    uint8_t& flags = pool_->pimpl_->flags[handle_.index];
+    flags = visible ? (flags | kVisible) : (flags & ~kVisible);
+  }
+  return *this;
+}
+
+ScenePool::Entity& ScenePool::Entity::SetColor(const Color& color) {
+  if (IsValid()) {
+    pool_->pimpl_->color[handle_.index] = color;
+  }
+  return *this;
+}
+
+ScenePool::Entity& ScenePool::Entity::SetWireColor(const Color& color) {
+  if (IsValid()) {
+    pool_->pimpl_->wire_color[handle_.index] = color;
+  }
+  return *this;
+}
+
+Eigen::Affine3d ScenePool::Entity::GetGlobalMatrix() const {
+  if (!IsValid()) {
+    return Eigen::Affine3d::Identity();
+  }
+  return pool_->pimpl_->world[handle_.index].cast<double>();
+}
+
+bool ScenePool::Entity::IsValid() const {
+  return pool_ && pool_->IsValid(handle_);
+}
+
+}  // namespace livision
@@ -10,14 +10,25 @@
 #include <bx/math.h>
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
 #include <stdexcept>
+#include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include "imgui_impl_bgfx.h"
 #include "livision/Camera.hpp"
+#include "livision/Container.hpp"
 #include "livision/Log.hpp"
 #include "livision/Renderer.hpp"
+#include "livision/internal/bvh.hpp"
+#include "livision/internal/gpu_release_queue.hpp"
 #include "livision/internal/mesh_buffer_manager.hpp"
+#include "livision/internal/thread_pool.hpp"
+#include "livision/internal/transform_update.hpp"
 #include "livision/imgui/imgui_impl_sdl2.h"
 
 namespace livision {
@@ -40,6 +51,17 @@ uint32_t ToRGBA8(const Color& color) {
   return (static_cast<uint32_t>(r) << 24) | (static_cast<uint32_t>(g) << 16) |
          (static_cast<uint32_t>(b) << 8) | 0xFFU;
 }
+
+constexpr uint32_t kNoContainer = std::numeric_limits<uint32_t>::max();
+
+// World bounds in float, padded so rounding never shrinks the box.
+internal::BvhBox ToBvhBox(const Bounds& bounds) {
+  const auto pad = [](const Eigen::Vector3d& p) {
+    return ((p.cwiseAbs().array() * 1e-6) + 1e-6).matrix();
+  };
+  return {(bounds.min - pad(bounds.min)).cast<float>(),
+          (bounds.max + pad(bounds.max)).cast<float>()};
+}
 }  // namespace
 
 struct Viewer::Impl {
@@ -47,6 +69,7 @@ struct Viewer::Impl {
   std::vector<std::shared_ptr<ObjectBase>> draw_objects;
   ViewerConfig config;
   Renderer renderer;
+  std::unique_ptr<internal::ThreadPool> transform_pool;
   std::function<void()> ui_callback = []() {};
 
   bool initialized = false;
@@ -59,6 +82,34 @@ struct Viewer::Impl {
   std::unique_ptr<CameraBase> camera = std::make_unique<MouseOrbitCamera>();
   float view[16] = {};
   float proj[16];
+  bool has_view_proj = false;
+
+  // Pick candidates, gathered on the first pick after a transform update.
+  // Leaves are stored in the leaf order of pick_bvh.
+  struct PickLeaf {
+    std::shared_ptr<ObjectBase> object;
+    uint32_t container = kNoContainer;
+  };
+  std::vector<std::string> pick_paths;  // Path of each visited container
+  std::vector<PickLeaf> pick_leaves;
+  std::vector<PickLeaf> pick_unbounded;  // Tested without the BVH
+  internal::Bvh pick_bvh;
+  bool pick_valid = false;
+
+  void CollectPickable(const std::shared_ptr<ObjectBase>& object,
+                       uint32_t container);
+  void UpdatePickBvh();
+  std::string PickPath(const PickLeaf& leaf) const;
+
+  PickResult hovered;
+  std::vector<std::weak_ptr<ObjectBase>> selected;
+
+  // Find the drawn object behind a renderer pick and its path.
+  bool ResolvePick(const ObjectBase* target,
+                   const std::vector<std::shared_ptr<ObjectBase>>& objects,
+                   const std::string& parent_path, PickResult& result) const;
+  void UpdateHovered(uint32_t frame_number);
+  void SyncSelection();
 
   void Resize(int width, int height) {
     if (width <= 0 || height <= 0) {
@@ -76,6 +127,124 @@ struct Viewer::Impl {
   }
 };
 
+void Viewer::Impl::CollectPickable(const std::shared_ptr<ObjectBase>& object,
+                                   uint32_t container) {
+  if (!object || !object->IsVisible()) {
+    return;
+  }
+  if (const auto* as_container = dynamic_cast<const Container*>(object.get())) {
+    PickLeaf node{object, container};
+    const auto index = static_cast<uint32_t>(pick_paths.size());
+    pick_paths.push_back(PickPath(node));
+    for (const auto& child : as_container->GetObjects()) {
+      CollectPickable(child, index);
+    }
+    return;
+  }
+  const Bounds& bounds = object->GetWorldBounds();
+  if (bounds.IsEmpty()) {
+    return;
+  }
+  if (bounds.IsInfinite()) {
+    pick_unbounded.push_back({object, container});
+  } else {
+    pick_leaves.push_back({object, container});
+  }
+}
+
+void Viewer::Impl::UpdatePickBvh() {
+  if (pick_valid) {
+    return;
+  }
+  pick_paths.clear();
+  pick_leaves.clear();
+  pick_unbounded.clear();
+  for (const auto& object : draw_objects) {
+    CollectPickable(object, kNoContainer);
+  }
+  std::vector<internal::BvhBox> boxes;
+  boxes.reserve(pick_leaves.size());
+  for (const PickLeaf& leaf : pick_leaves) {
+    boxes.push_back(ToBvhBox(leaf.object->GetWorldBounds()));
+  }
+  const std::vector<uint32_t> order = pick_bvh.Build(boxes);
+  std::vector<PickLeaf> ordered;
+  ordered.reserve(order.size());
+  for (const uint32_t index : order) {
+    ordered.push_back(std::move(pick_leaves[index]));
+  }
+  pick_leaves = std::move(ordered);
+  pick_valid = true;
+}
+
+std::string Viewer::Impl::PickPath(const PickLeaf& leaf) const {
+  std::string path =
+      leaf.container == kNoContainer ? "" : pick_paths[leaf.container];
+  const std::string& name = leaf.object->GetName();
+  if (!name.empty()) {
+    if (!path.empty()) {
+      path += "/";
+    }
+    path += name;
+  }
+  return path;
+}
+
+bool Viewer::Impl::ResolvePick(
+    const ObjectBase* target,
+    const std::vector<std::shared_ptr<ObjectBase>>& objects,
+    const std::string& parent_path, PickResult& result) const {
+  for (const auto& object : objects) {
+    if (!object) {
+      continue;
+    }
+    std::string path = parent_path;
+    if (!object->GetName().empty()) {
+      if (!path.empty()) {
+        path += "/";
+      }
+      path += object->GetName();
+    }
+    if (object.get() == target) {
+      result.object = object;
+      result.path = std::move(path);
+      return true;
+    }
+    if (const auto* as_container =
+            dynamic_cast<const Container*>(object.get());
+        as_container &&
+        ResolvePick(target, as_container->GetObjects(), path, result)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Viewer::Impl::UpdateHovered(uint32_t frame_number) {
+  renderer.OnFrameSubmitted(frame_number);
+  const ObjectBase* object = nullptr;
+  uint32_t instance = 0;
+  if (!renderer.FetchPick(object, instance)) {
+    return;
+  }
+  hovered = PickResult();
+  if (object && ResolvePick(object, draw_objects, "", hovered)) {
+    hovered.instance = instance;
+  }
+}
+
+void Viewer::Impl::SyncSelection() {
+  std::erase_if(selected, [](const std::weak_ptr<ObjectBase>& object) {
+    return object.expired();
+  });
+  std::vector<const ObjectBase*> objects;
+  objects.reserve(selected.size());
+  for (const auto& object : selected) {
+    objects.push_back(object.lock().get());
+  }
+  renderer.SetHighlightedObjects(std::move(objects));
+}
+
 Viewer::Viewer(const ViewerConfig& config) : pimpl_(std::make_unique<Impl>()) {
   pimpl_->config = config;
   SetLogLevel(pimpl_->config.log_level);
@@ -146,7 +315,9 @@ Viewer::Viewer(const ViewerConfig& config) : pimpl_(std::make_unique<Impl>()) {
   bgfx::init(bgfx_init);
   internal::MeshBufferManager::SetBgfxAlive(true);
 
-  bgfx::setViewClear(0, BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH,
+  // Stencil marks the silhouettes of selected objects for their outline.
+  bgfx::setViewClear(0,
+                     BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH | BGFX_CLEAR_STENCIL,
                      ToRGBA8(pimpl_->config.background), 1.0F, 0);
   bgfx::setViewRect(0, 0, 0, pimpl_->config.width, pimpl_->config.height);
 
@@ -172,9 +343,37 @@ Viewer::Viewer(const ViewerConfig& config) : pimpl_(std::make_unique<Impl>()) {
   }
 
   pimpl_->renderer.Init();
+  pimpl_->renderer.SetLodPixelThreshold(pimpl_->config.lod_pixel_threshold);
+  pimpl_->renderer.SetFrustumCulling(pimpl_->config.frustum_culling);
+  pimpl_->renderer.SetLabelDeclutter(pimpl_->config.label_declutter);
+  pimpl_->renderer.SetWireframeOverlay(pimpl_->config.wireframe_overlay,
+                                       pimpl_->config.wireframe_width);
+  pimpl_->renderer.SetTextureBudget(pimpl_->config.texture_budget_mb << 20U,
+                                    pimpl_->config.texture_evict_frames);
+  pimpl_->renderer.SetGpuReleaseBudget(pimpl_->config.gpu_release_budget);
+  pimpl_->renderer.SetOutlineStyle(pimpl_->config.outline_color,
+                                   pimpl_->config.outline_width);
+  pimpl_->renderer.SetLighting(pimpl_->config.lighting);
+
+  // The main thread joins every parallel update, so it counts as one of the
+  // transform threads.
+  const uint32_t transform_threads = pimpl_->config.transform_threads;
+  const std::size_t workers =
+      transform_threads == 0
+          ? internal::ThreadPool::DefaultThreadCount(
+                std::thread::hardware_concurrency())
+          : transform_threads - 1U;
+  if (workers > 0 && std::thread::hardware_concurrency() > 1) {
+    pimpl_->transform_pool = std::make_unique<internal::ThreadPool>(workers);
+    internal::SetTransformPool(pimpl_->transform_pool.get());
+  }
 }
 
 Viewer::~Viewer() {
+  if (internal::GetTransformPool() == pimpl_->transform_pool.get()) {
+    internal::SetTransformPool(nullptr);
+  }
+  pimpl_->transform_pool.reset();
   for (auto& object : pimpl_->draw_objects) {
     if (object) {
       object->DeInit();
@@ -182,6 +381,14 @@ Viewer::~Viewer() {
   }
   pimpl_->draw_objects.clear();
   internal::MeshBufferManager::DestroyAllBuffers();
+  const MeshBufferStats mesh_stats = GetMeshBufferStats();
+  const std::size_t live_meshes = mesh_stats.shared.count +
+                                  mesh_stats.unique.count +
+                                  mesh_stats.dynamic.count;
+  if (live_meshes > 0) {
+    LogMessage(LogLevel::Debug,
+               "Mesh buffers still referenced at shutdown: ", live_meshes);
+  }
   pimpl_->renderer.DeInit();
 
   ImGui_ImplSDL2_Shutdown();
@@ -190,11 +397,13 @@ Viewer::~Viewer() {
   ImPlot::DestroyContext();
   ImGui::DestroyContext();
   internal::MeshBufferManager::SetBgfxAlive(false);
+  internal::DrainDeferredDestroys(0);
   bgfx::shutdown();
 
   SDL_DestroyWindow(pimpl_->window);
   SDL_Quit();
   LogMessage(LogLevel::Info, "Viewer Exit");
+  FlushLog();
 }
 
 bool Viewer::SpinOnce() {
@@ -204,9 +413,8 @@ bool Viewer::SpinOnce() {
     pimpl_->last_frame_time = pimpl_->last_fps_time;
     pimpl_->initialized = true;
   }
-  for (const auto& object : pimpl_->draw_objects) {
-    object->UpdateMatrix(Eigen::Affine3d::Identity());
-  }
+  internal::UpdateMatrices(pimpl_->draw_objects, Eigen::Affine3d::Identity());
+  pimpl_->pick_valid = false;
 
   if (!pimpl_->config.headless) {
     // Event handling
@@ -236,6 +444,8 @@ bool Viewer::SpinOnce() {
                     static_cast<float>(pimpl_->config.height),
                 0.1F, 1000.0F, bgfx::getCaps()->homogeneousDepth,
                 bx::Handedness::Right);
+    pimpl_->renderer.SetProjection(pimpl_->proj, pimpl_->config.width,
+                                   pimpl_->config.height);
 
     if (pimpl_->camera) {
       CameraInputContext input_context;
@@ -248,10 +458,28 @@ bool Viewer::SpinOnce() {
 
     pimpl_->renderer.SetCameraViewMatrix(pimpl_->view);
     bgfx::setViewTransform(0, pimpl_->view, pimpl_->proj);
+    pimpl_->has_view_proj = true;
+    if (pimpl_->config.gpu_picking) {
+      const ImGuiIO& io = ImGui::GetIO();
+      if (!io.WantCaptureMouse && ImGui::IsMousePosValid(&io.MousePos)) {
+        pimpl_->renderer.RequestPick(static_cast<int>(io.MousePos.x),
+                                     static_cast<int>(io.MousePos.y));
+      } else {
+        pimpl_->hovered = PickResult();
+      }
+    }
+    pimpl_->SyncSelection();
+    pimpl_->renderer.BeginFrame();
 
     for (const auto& object : pimpl_->draw_objects) {
-      if (object->IsVisible()) object->OnDraw(pimpl_->renderer);
+      if (object->IsVisible() &&
+          pimpl_->renderer.InFrustum(object->GetWorldBounds())) {
+        pimpl_->renderer.BeginObject(object.get());
+        object->OnDraw(pimpl_->renderer);
+        pimpl_->renderer.EndObject();
+      }
     }
+    pimpl_->renderer.EndFrame();
 
     // Render ImGui
     ImGui_Implbgfx_NewFrame();
@@ -276,7 +504,10 @@ bool Viewer::SpinOnce() {
     }
   }
 
-  bgfx::frame();
+  const uint32_t frame_number = bgfx::frame();
+  if (pimpl_->config.gpu_picking && !pimpl_->config.headless) {
+    pimpl_->UpdateHovered(frame_number);
+  }
 
   // Increment frame count for FPS calculation
   pimpl_->frame_count++;
@@ -307,16 +538,105 @@ void Viewer::AddObject(std::shared_ptr<ObjectBase> object) {
   }
   object->Init();
   pimpl_->draw_objects.push_back(object);
+  pimpl_->pick_valid = false;
 }
 
 void Viewer::RegisterUICallback(std::function<void()> ui_callback) {
   pimpl_->ui_callback = std::move(ui_callback);
 }
 
+void Viewer::SetLighting(const Lighting& lighting) {
+  pimpl_->config.lighting = lighting;
+  pimpl_->renderer.SetLighting(lighting);
+}
+
 void Viewer::SetCameraController(std::unique_ptr<CameraBase> camera) {
   if (camera) {
     pimpl_->camera = std::move(camera);
   }
 }
 
+const PickResult& Viewer::GetHovered() const { return pimpl_->hovered; }
+
+void Viewer::SetSelected(const std::shared_ptr<ObjectBase>& object,
+                         bool selected) {
+  if (!object) {
+    return;
+  }
+  auto& list = pimpl_->selected;
+  const auto it = std::find_if(
+      list.begin(), list.end(), [&](const std::weak_ptr<ObjectBase>& entry) {
+        return entry.lock() == object;
+      });
+  if (selected && it == list.end()) {
+    list.push_back(object);
+  } else if (!selected && it != list.end()) {
+    list.erase(it);
+  }
+}
+
+void Viewer::ClearSelection() { pimpl_->selected.clear(); }
+
+PickResult Viewer::Pick(int x, int y) {
+  if (!pimpl_->has_view_proj) {
+    return {};
+  }
+  const Eigen::Matrix4d inv_view_proj =
+      (Eigen::Map<const Eigen::Matrix4f>(pimpl_->proj).cast<double>() *
+       Eigen::Map<const Eigen::Matrix4f>(pimpl_->view).cast<double>())
+          .inverse();
+  const double ndc_x =
+      (2.0 * (x + 0.5) / static_cast<double>(pimpl_->config.width)) - 1.0;
+  const double ndc_y =
+      1.0 - (2.0 * (y + 0.5) / static_cast<double>(pimpl_->config.height));
+  const double near_z = bgfx::getCaps()->homogeneousDepth ? -1.0 : 0.0;
+  const Eigen::Vector4d near_point =
+      inv_view_proj * Eigen::Vector4d(ndc_x, ndc_y, near_z, 1.0);
+  const Eigen::Vector4d far_point =
+      inv_view_proj * Eigen::Vector4d(ndc_x, ndc_y, 1.0, 1.0);
+  const Eigen::Vector3d origin = near_point.head<3>() / near_point.w();
+  return Pick(origin, (far_point.head<3>() / far_point.w()) - origin);
+}
+
+PickResult Viewer::Pick(const Eigen::Vector3d& origin,
+                        const Eigen::Vector3d& direction) {
+  PickResult result;
+  const double length = direction.norm();
+  if (!(length > 0.0) || !origin.allFinite()) {
+    return result;
+  }
+  const Eigen::Vector3d dir = direction / length;
+  pimpl_->UpdatePickBvh();
+
+  double best = std::numeric_limits<double>::infinity();
+  const Impl::PickLeaf* hit = nullptr;
+  const auto test = [&](const Impl::PickLeaf& leaf) {
+    double distance = best;
+    if (leaf.object->IntersectRay(origin, dir, distance) && distance < best) {
+      best = distance;
+      hit = &leaf;
+    }
+  };
+  // Objects are visited nearest box first, and boxes entered beyond the
+  // best hit so far are skipped.
+  float max_t = std::numeric_limits<float>::infinity();
+  pimpl_->pick_bvh.Traverse(
+      origin.cast<float>(), dir.cast<float>(), max_t, [&](uint32_t position) {
+        test(pimpl_->pick_leaves[position]);
+        max_t = std::nextafter(static_cast<float>(best),
+                               std::numeric_limits<float>::infinity());
+      });
+  for (const Impl::PickLeaf& leaf : pimpl_->pick_unbounded) {
+    test(leaf);
+  }
+  if (!hit) {
+    return result;
+  }
+  result.object = hit->object;
+  result.path = pimpl_->PickPath(*hit);
+  result.point = origin + (best * dir);
+  result.distance = best;
+  return result;
+}
+
 }  // namespace livision
@@ -0,0 +1,283 @@
+#include "livision/internal/bvh.hpp"
+
+#include <cmath>
+
+namespace livision::internal {
+
+namespace {
+constexpr uint32_t kBins = 12;
+constexpr uint32_t kMaxLeafSize = 4;
+// Nodes that SAH keeps unsplit are still split when they hold more than
+// this, so no single leaf becomes a linear scan.
+constexpr uint32_t kMaxSahLeafSize = 16;
+// Past this depth nodes are split at the median, which bounds the total
+// depth by this plus log2 of the primitive count.
+constexpr uint32_t kMaxSahDepth = 24;
+// Cost of visiting a node relative to testing one primitive.
+constexpr float kTraversalCost = 1.0F;
+
+BvhBox EmptyBox() {
+  constexpr float kInf = std::numeric_limits<float>::infinity();
+  return {Eigen::Vector3f::Constant(kInf), Eigen::Vector3f::Constant(-kInf)};
+}
+
+void Grow(BvhBox& box, const BvhBox& other) {
+  box.min = box.min.cwiseMin(other.min);
+  box.max = box.max.cwiseMax(other.max);
+}
+
+float HalfArea(const BvhBox& box) {
+  const Eigen::Vector3f d = box.max - box.min;
+  if ((d.array() < 0.0F).any()) {
+    return 0.0F;
+  }
+  return (d.x() * d.y()) + (d.y() * d.z()) + (d.z() * d.x());
+}
+
+struct Bin {
+  BvhBox box = EmptyBox();
+  uint32_t count = 0;
+};
+
+struct Split {
+  int axis = -1;
+  uint32_t bin = 0;  // First bin of the right side
+  float cost = std::numeric_limits<float>::infinity();
+};
+
+// Working copy of a primitive, partitioned in place so each pass over a
+// node reads contiguous memory.
+struct Prim {
+  BvhBox box;
+  Eigen::Vector3f centroid;
+  uint32_t index;
+};
+
+uint32_t BinOf(float centroid, float lo, float scale) {
+  const auto bin = static_cast<uint32_t>((centroid - lo) * scale);
+  return std::min(bin, kBins - 1);
+}
+}  // namespace
+
+std::vector<uint32_t> Bvh::Build(std::span<const BvhBox> boxes) {
+  nodes_.clear();
+  const auto count = static_cast<uint32_t>(boxes.size());
+  std::vector<uint32_t> order(count);
+  if (count == 0) {
+    return order;
+  }
+
+  std::vector<Prim> prims(count);
+  BvhBox root_box = EmptyBox();
+  BvhBox root_centroids = EmptyBox();
+  for (uint32_t i = 0; i < count; ++i) {
+    const Eigen::Vector3f c = 0.5F * (boxes[i].min + boxes[i].max);
+    prims[i] = {boxes[i], c, i};
+    Grow(root_box, boxes[i]);
+    Grow(root_centroids, {c, c});
+  }
+  Node root;
+  root.min = root_box.min;
+  root.max = root_box.max;
+  root.count = count;
+  nodes_.push_back(root);
+
+  struct Task {
+    uint32_t node;
+    uint32_t depth;
+    BvhBox centroids;
+  };
+  std::vector<Task> tasks{{0U, 0U, root_centroids}};
+  while (!tasks.empty()) {
+    const Task task = tasks.back();
+    tasks.pop_back();
+    const Node node = nodes_[task.node];
+    if (node.count <= kMaxLeafSize) {
+      continue;
+    }
+    const auto first = prims.begin() + node.first;
+    const auto last = first + node.count;
+    const Eigen::Vector3f lo = task.centroids.min;
+    const Eigen::Vector3f extent = task.centroids.max - lo;
+
+    // One pass bins all three axes; axes without extent are skipped later.
+    Bin bins[3][kBins];
+    Eigen::Vector3f scale = Eigen::Vector3f::Zero();
+    for (int axis = 0; axis < 3; ++axis) {
+      if (extent[axis] > 0.0F) {
+        scale[axis] = static_cast<float>(kBins) / extent[axis];
+      }
+    }
+    if (task.depth < kMaxSahDepth) {
+      for (auto it = first; it != last; ++it) {
+        for (int axis = 0; axis < 3; ++axis) {
+          Bin& bin = bins[axis][BinOf(it->centroid[axis], lo[axis],
+                                      scale[axis])];
+          Grow(bin.box, it->box);
+          ++bin.count;
+        }
+      }
+    }
+
+    Split best;
+    for (int axis = 0; axis < 3 && task.depth < kMaxSahDepth; ++axis) {
+      if (!(extent[axis] > 0.0F)) {
+        continue;
+      }
+      // Right-side costs from a backward sweep, then one forward sweep.
+      float right_cost[kBins] = {};
+      BvhBox right = EmptyBox();
+      uint32_t right_count = 0;
+      for (uint32_t b = kBins - 1; b > 0; --b) {
+        Grow(right, bins[axis][b].box);
+        right_count += bins[axis][b].count;
+        right_cost[b] = static_cast<float>(right_count) * HalfArea(right);
+      }
+      BvhBox left = EmptyBox();
+      uint32_t left_count = 0;
+      for (uint32_t b = 1; b < kBins; ++b) {
+        Grow(left, bins[axis][b - 1].box);
+        left_count += bins[axis][b - 1].count;
+        const float cost =
+            (static_cast<float>(left_count) * HalfArea(left)) + right_cost[b];
+        if (left_count > 0 && left_count < node.count && cost < best.cost) {
+          best = {axis, b, cost};
+        }
+      }
+    }
+    const BvhBox node_box{node.min, node.max};
+    const float leaf_cost = static_cast<float>(node.count) * HalfArea(node_box);
+    const float split_cost = best.cost + (kTraversalCost * HalfArea(node_box));
+    if (task.depth < kMaxSahDepth && split_cost >= leaf_cost &&
+        node.count <= kMaxSahLeafSize) {
+      continue;
+    }
+
+    BvhBox boxes_of[2] = {EmptyBox(), EmptyBox()};
+    BvhBox centroids_of[2] = {EmptyBox(), EmptyBox()};
+    auto mid = first;
+    if (best.axis >= 0) {
+      const int axis = best.axis;
+      mid = std::partition(first, last, [&](const Prim& prim) {
+        return BinOf(prim.centroid[axis], lo[axis], scale[axis]) < best.bin;
+      });
+      for (uint32_t b = 0; b < kBins; ++b) {
+        Grow(boxes_of[b < best.bin ? 0 : 1], bins[axis][b].box);
+      }
+      for (auto it = first; it != last; ++it) {
+        Grow(centroids_of[it < mid ? 0 : 1], {it->centroid, it->centroid});
+      }
+    } else {
+      // No usable SAH split: halve along the widest centroid axis.
+      int axis = 0;
+      extent.maxCoeff(&axis);
+      mid = first + (node.count / 2);
+      std::nth_element(first, mid, last, [&](const Prim& a, const Prim& b) {
+        return a.centroid[axis] < b.centroid[axis];
+      });
+      for (auto it = first; it != last; ++it) {
+        const int side = it < mid ? 0 : 1;
+        Grow(boxes_of[side], it->box);
+        Grow(centroids_of[side], {it->centroid, it->centroid});
+      }
+    }
+
+    const auto left = static_cast<uint32_t>(nodes_.size());
+    const auto split = static_cast<uint32_t>(mid - prims.begin());
+    const uint32_t ranges[2][2] = {{node.first, split},
+                                   {split, node.first + node.count}};
+    for (int side = 0; side < 2; ++side) {
+      Node child;
+      child.min = boxes_of[side].min;
+      child.max = boxes_of[side].max;
+      child.first = ranges[side][0];
+      child.count = ranges[side][1] - ranges[side][0];
+      nodes_.push_back(child);
+      tasks.push_back({left + side, task.depth + 1, centroids_of[side]});
+    }
+    nodes_[task.node].first = left;
+    nodes_[task.node].count = 0;
+  }
+  nodes_.shrink_to_fit();
+  for (uint32_t i = 0; i < count; ++i) {
+    order[i] = prims[i].index;
+  }
+  return order;
+}
+
+uint64_t Bvh::Bytes() const { return nodes_.capacity() * sizeof(Node); }
+
+MeshBvh::MeshBvh(std::span<const Vertex> vertices,
+                 std::span<const uint32_t> indices) {
+  const auto position = [&](uint32_t index) {
+    const Vertex& v = vertices[index];
+    return Eigen::Vector3f(v.x, v.y, v.z);
+  };
+
+  // Triangles referencing missing vertices are left out.
+  std::vector<uint32_t> ids;
+  std::vector<BvhBox> boxes;
+  ids.reserve(indices.size() / 3);
+  boxes.reserve(indices.size() / 3);
+  for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+    if (indices[i] >= vertices.size() || indices[i + 1] >= vertices.size() ||
+        indices[i + 2] >= vertices.size()) {
+      continue;
+    }
+    const Eigen::Vector3f a = position(indices[i]);
+    const Eigen::Vector3f b = position(indices[i + 1]);
+    const Eigen::Vector3f c = position(indices[i + 2]);
+    ids.push_back(static_cast<uint32_t>(i / 3));
+    boxes.push_back({a.cwiseMin(b).cwiseMin(c), a.cwiseMax(b).cwiseMax(c)});
+  }
+
+  const std::vector<uint32_t> order = bvh_.Build(boxes);
+  triangles_.reserve(order.size());
+  for (const uint32_t leaf : order) {
+    const uint32_t id = ids[leaf];
+    const Eigen::Vector3f v0 = position(indices[(id * 3) + 0]);
+    triangles_.push_back({v0, position(indices[(id * 3) + 1]) - v0,
+                          position(indices[(id * 3) + 2]) - v0, id});
+  }
+}
+
+bool MeshBvh::Intersect(const Eigen::Vector3f& origin,
+                        const Eigen::Vector3f& dir, float max_t,
+                        Hit& hit) const {
+  bool found = false;
+  bvh_.Traverse(origin, dir, max_t, [&](uint32_t position) {
+    // Moller-Trumbore, accepting both windings.
+    const Triangle& tri = triangles_[position];
+    const Eigen::Vector3f p = dir.cross(tri.e2);
+    const float det = tri.e1.dot(p);
+    if (det == 0.0F) {
+      return;
+    }
+    const float inv_det = 1.0F / det;
+    const Eigen::Vector3f s = origin - tri.v0;
+    const float u = s.dot(p) * inv_det;
+    if (u < 0.0F || u > 1.0F) {
+      return;
+    }
+    const Eigen::Vector3f q = s.cross(tri.e1);
+    const float v = dir.dot(q) * inv_det;
+    if (v < 0.0F || u + v > 1.0F) {
+      return;
+    }
+    const float t = tri.e2.dot(q) * inv_det;
+    if (t < 0.0F || t > max_t) {
+      return;
+    }
+    max_t = t;
+    hit.t = t;
+    hit.triangle = tri.id;
+    found = true;
+  });
+  return found;
+}
+
+uint64_t MeshBvh::Bytes() const {
+  return bvh_.Bytes() + (triangles_.capacity() * sizeof(Triangle));
+}
+
+}  // namespace livision::internal
@@ -0,0 +1,278 @@
+#include "livision/internal/glyph_atlas.hpp"
+
+#include <bgfx/defines.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "livision/Log.hpp"
+#include "livision/imgui/imstb_truetype.h"
+#include "livision/internal/file_ops.hpp"
+
+namespace livision::internal {
+
+namespace {
+constexpr uint16_t kPageSize = 1024;
+constexpr std::size_t kMaxPages = 16;
+// Empty texels between glyphs so bilinear filtering never bleeds.
+constexpr uint16_t kGutter = 1;
+
+constexpr float kSdfPixelHeight = 32.0F;
+// Distance range in pixels on each side of the outline.
+constexpr int kSdfPadding = 4;
+constexpr unsigned char kSdfOnEdge = 128;
+constexpr float kBitmapPixelHeight = 48.0F;
+
+constexpr uint32_t kReplacementChar = 0xFFFD;
+
+struct Page {
+  bgfx::TextureHandle texture = BGFX_INVALID_HANDLE;
+  uint16_t shelf_x = 0;
+  uint16_t shelf_y = 0;
+  uint16_t shelf_height = 0;
+};
+}  // namespace
+
+uint32_t DecodeUtf8(std::string_view text, std::size_t& pos) {
+  const auto lead = static_cast<uint8_t>(text[pos]);
+  uint32_t codepoint = 0;
+  std::size_t length = 0;
+  if (lead < 0x80U) {
+    ++pos;
+    return lead;
+  }
+  if ((lead & 0xE0U) == 0xC0U) {
+    codepoint = lead & 0x1FU;
+    length = 2;
+  } else if ((lead & 0xF0U) == 0xE0U) {
+    codepoint = lead & 0x0FU;
+    length = 3;
+  } else if ((lead & 0xF8U) == 0xF0U) {
+    codepoint = lead & 0x07U;
+    length = 4;
+  } else {
+    ++pos;
+    return kReplacementChar;
+  }
+  if (pos + length > text.size()) {
+    ++pos;
+    return kReplacementChar;
+  }
+  for (std::size_t i = 1; i < length; ++i) {
+    const auto cont = static_cast<uint8_t>(text[pos + i]);
+    if ((cont & 0xC0U) != 0x80U) {
+      ++pos;
+      return kReplacementChar;
+    }
+    codepoint = (codepoint << 6U) | (cont & 0x3FU);
+  }
+  // Reject overlong forms, surrogates and out-of-range values.
+  static constexpr uint32_t kMinForLength[5] = {0, 0, 0x80, 0x800, 0x10000};
+  if (codepoint < kMinForLength[length] || codepoint > 0x10FFFFU ||
+      (codepoint >= 0xD800U && codepoint <= 0xDFFFU)) {
+    ++pos;
+    return kReplacementChar;
+  }
+  pos += length;
+  return codepoint;
+}
+
+struct GlyphAtlas::Impl {
+  std::string font_data;
+  stbtt_fontinfo font{};
+  bool sdf = false;
+  float pixel_height = kBitmapPixelHeight;
+  float scale = 1.0F;
+  std::unordered_map<uint32_t, Glyph> glyphs;
+  std::vector<Page> pages;
+  bool warned_full = false;
+
+  // Reserve a w x h rect; returns false when all pages are full.
+  bool Allocate(uint16_t w, uint16_t h, uint16_t& page, uint16_t& x,
+                uint16_t& y);
+  void Upload(uint16_t page, uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+              const unsigned char* pixels);
+};
+
+bool GlyphAtlas::Impl::Allocate(uint16_t w, uint16_t h, uint16_t& page,
+                                uint16_t& x, uint16_t& y) {
+  if (w + kGutter > kPageSize || h + kGutter > kPageSize) {
+    return false;
+  }
+  // Shelf packing: fill rows left to right, open a new row or page when the
+  // glyph does not fit.
+  if (!pages.empty()) {
+    Page& current = pages.back();
+    if (current.shelf_x + w + kGutter > kPageSize) {
+      current.shelf_y += current.shelf_height;
+      current.shelf_x = 0;
+      current.shelf_height = 0;
+    }
+    if (current.shelf_y + h + kGutter <= kPageSize) {
+      page = static_cast<uint16_t>(pages.size() - 1);
+      x = current.shelf_x + kGutter;
+      y = current.shelf_y + kGutter;
+      current.shelf_x += w + kGutter;
+      current.shelf_height =
+          std::max<uint16_t>(current.shelf_height, h + kGutter);
+      return true;
+    }
+  }
+  if (pages.size() >= kMaxPages) {
+    return false;
+  }
+
+  Page next;
+  const uint64_t flags = BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP;
+  next.texture = bgfx::createTexture2D(
+      kPageSize, kPageSize, false, 1,
+      sdf ? bgfx::TextureFormat::R8 : bgfx::TextureFormat::RGBA8, flags);
+  if (!bgfx::isValid(next.texture)) {
+    return false;
+  }
+  // Pages start cleared so sampling outside a glyph reads "outside".
+  const uint32_t texel_bytes = sdf ? 1 : 4;
+  const bgfx::Memory* clear =
+      bgfx::alloc(uint32_t{kPageSize} * kPageSize * texel_bytes);
+  std::fill(clear->data, clear->data + clear->size, uint8_t{0});
+  bgfx::updateTexture2D(next.texture, 0, 0, 0, 0, kPageSize, kPageSize,
+                        clear);
+  pages.push_back(next);
+  return Allocate(w, h, page, x, y);
+}
+
+void GlyphAtlas::Impl::Upload(uint16_t page, uint16_t x, uint16_t y,
+                              uint16_t w, uint16_t h,
+                              const unsigned char* pixels) {
+  const uint32_t texels = uint32_t{w} * h;
+  const bgfx::Memory* mem = nullptr;
+  if (sdf) {
+    mem = bgfx::copy(pixels, texels);
+  } else {
+    mem = bgfx::alloc(texels * 4);
+    for (uint32_t i = 0; i < texels; ++i) {
+      mem->data[(i * 4) + 0] = 255U;
+      mem->data[(i * 4) + 1] = 255U;
+      mem->data[(i * 4) + 2] = 255U;
+      mem->data[(i * 4) + 3] = pixels[i];
+    }
+  }
+  bgfx::updateTexture2D(pages[page].texture, 0, 0, x, y, w, h, mem);
+}
+
+GlyphAtlas::GlyphAtlas() : pimpl_(std::make_unique<Impl>()) {}
+
+GlyphAtlas::~GlyphAtlas() {
+  if (pimpl_) {
+    Reset();
+  }
+}
+
+GlyphAtlas::GlyphAtlas(GlyphAtlas&&) noexcept = default;
+GlyphAtlas& GlyphAtlas::operator=(GlyphAtlas&&) noexcept = default;
+
+bool GlyphAtlas::Load(const std::string& font_path, bool sdf) {
+  Reset();
+  if (!file_ops::ReadFile(font_path, pimpl_->font_data)) {
+    return false;
+  }
+  const auto* data =
+      reinterpret_cast<const unsigned char*>(pimpl_->font_data.data());
+  if (stbtt_InitFont(&pimpl_->font, data,
+                     stbtt_GetFontOffsetForIndex(data, 0)) == 0) {
+    return false;
+  }
+  pimpl_->sdf = sdf;
+  pimpl_->pixel_height = sdf ? kSdfPixelHeight : kBitmapPixelHeight;
+  pimpl_->scale =
+      stbtt_ScaleForPixelHeight(&pimpl_->font, pimpl_->pixel_height);
+  return true;
+}
+
+void GlyphAtlas::Reset() {
+  for (Page& page : pimpl_->pages) {
+    if (bgfx::isValid(page.texture)) {
+      bgfx::destroy(page.texture);
+    }
+  }
+  pimpl_->pages.clear();
+  pimpl_->glyphs.clear();
+  pimpl_->warned_full = false;
+}
+
+const GlyphAtlas::Glyph* GlyphAtlas::GetGlyph(uint32_t codepoint) {
+  if (const auto it = pimpl_->glyphs.find(codepoint);
+      it != pimpl_->glyphs.end()) {
+    return &it->second;
+  }
+
+  Impl& impl = *pimpl_;
+  Glyph glyph;
+  // Missing code points map to glyph 0, the font's "not defined" box.
+  glyph.index = stbtt_FindGlyphIndex(&impl.font, static_cast<int>(codepoint));
+  int advance = 0;
+  int left_bearing = 0;
+  stbtt_GetGlyphHMetrics(&impl.font, glyph.index, &advance, &left_bearing);
+  glyph.advance = static_cast<float>(advance) * impl.scale;
+
+  int w = 0;
+  int h = 0;
+  int xoff = 0;
+  int yoff = 0;
+  unsigned char* bitmap =
+      impl.sdf ? stbtt_GetGlyphSDF(&impl.font, impl.scale, glyph.index,
+                                   kSdfPadding, kSdfOnEdge,
+                                   static_cast<float>(kSdfOnEdge) / kSdfPadding,
+                                   &w, &h, &xoff, &yoff)
+               : stbtt_GetGlyphBitmap(&impl.font, impl.scale, impl.scale,
+                                      glyph.index, &w, &h, &xoff, &yoff);
+  uint16_t page = 0;
+  uint16_t x = 0;
+  uint16_t y = 0;
+  if (bitmap && w > 0 && h > 0) {
+    if (impl.Allocate(static_cast<uint16_t>(w), static_cast<uint16_t>(h),
+                      page, x, y)) {
+      impl.Upload(page, x, y, static_cast<uint16_t>(w),
+                  static_cast<uint16_t>(h), bitmap);
+      glyph.page = page;
+      glyph.visible = true;
+      glyph.x0 = static_cast<float>(xoff);
+      glyph.y0 = static_cast<float>(yoff);
+      glyph.x1 = static_cast<float>(xoff + w);
+      glyph.y1 = static_cast<float>(yoff + h);
+      constexpr float kInvSize = 1.0F / static_cast<float>(kPageSize);
+      glyph.s0 = static_cast<float>(x) * kInvSize;
+      glyph.t0 = static_cast<float>(y) * kInvSize;
+      glyph.s1 = static_cast<float>(x + w) * kInvSize;
+      glyph.t1 = static_cast<float>(y + h) * kInvSize;
+    } else if (!impl.warned_full) {
+      impl.warned_full = true;
+      LogMessage(LogLevel::Warn, "Glyph atlas is full; some text is hidden.");
+    }
+  }
+  if (bitmap) {
+    if (impl.sdf) {
+      stbtt_FreeSDF(bitmap, nullptr);
+    } else {
+      stbtt_FreeBitmap(bitmap, nullptr);
+    }
+  }
+  return &impl.glyphs.emplace(codepoint, glyph).first->second;
+}
+
+float GlyphAtlas::Kerning(const Glyph& left, const Glyph& right) const {
+  const int kern =
+      stbtt_GetGlyphKernAdvance(&pimpl_->font, left.index, right.index);
+  return static_cast<float>(kern) * pimpl_->scale;
+}
+
+float GlyphAtlas::PixelHeight() const { return pimpl_->pixel_height; }
+
+std::size_t GlyphAtlas::PageCount() const { return pimpl_->pages.size(); }
+
+bgfx::TextureHandle GlyphAtlas::PageTexture(std::size_t page) const {
+  return pimpl_->pages[page].texture;
+}
+
+}  // namespace livision::internal
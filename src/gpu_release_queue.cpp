@@ -0,0 +1,109 @@
+#include "livision/internal/gpu_release_queue.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace livision::internal {
+
+namespace {
+// A backlog is worked off within about this many frames, whatever the
+// per-frame budget.
+constexpr std::size_t kMaxBacklogFrames = 32;
+
+enum class HandleKind : uint8_t {
+  VertexBuffer,
+  IndexBuffer,
+  DynamicVertexBuffer,
+  DynamicIndexBuffer,
+};
+
+struct PendingHandle {
+  HandleKind kind;
+  uint16_t idx;
+};
+
+struct ReleaseQueue {
+  std::mutex mutex;
+  std::deque<PendingHandle> pending;
+};
+
+ReleaseQueue& Queue() {
+  static ReleaseQueue queue;
+  return queue;
+}
+
+void Push(HandleKind kind, uint16_t idx) {
+  if (idx == bgfx::kInvalidHandle) {
+    return;
+  }
+  ReleaseQueue& queue = Queue();
+  const std::lock_guard<std::mutex> lock(queue.mutex);
+  queue.pending.push_back({kind, idx});
+}
+
+void Destroy(const PendingHandle& handle) {
+  switch (handle.kind) {
+    case HandleKind::VertexBuffer:
+      bgfx::destroy(bgfx::VertexBufferHandle{handle.idx});
+      break;
+    case HandleKind::IndexBuffer:
+      bgfx::destroy(bgfx::IndexBufferHandle{handle.idx});
+      break;
+    case HandleKind::DynamicVertexBuffer:
+      bgfx::destroy(bgfx::DynamicVertexBufferHandle{handle.idx});
+      break;
+    case HandleKind::DynamicIndexBuffer:
+      bgfx::destroy(bgfx::DynamicIndexBufferHandle{handle.idx});
+      break;
+  }
+}
+}  // namespace
+
+void DeferDestroy(bgfx::VertexBufferHandle handle) {
+  Push(HandleKind::VertexBuffer, handle.idx);
+}
+
+void DeferDestroy(bgfx::IndexBufferHandle handle) {
+  Push(HandleKind::IndexBuffer, handle.idx);
+}
+
+void DeferDestroy(bgfx::DynamicVertexBufferHandle handle) {
+  Push(HandleKind::DynamicVertexBuffer, handle.idx);
+}
+
+void DeferDestroy(bgfx::DynamicIndexBufferHandle handle) {
+  Push(HandleKind::DynamicIndexBuffer, handle.idx);
+}
+
+std::size_t DrainDeferredDestroys(std::size_t max_count) {
+  std::vector<PendingHandle> batch;
+  {
+    ReleaseQueue& queue = Queue();
+    const std::lock_guard<std::mutex> lock(queue.mutex);
+    std::size_t count = queue.pending.size();
+    if (max_count > 0) {
+      count = std::min(
+          count, std::max(max_count, queue.pending.size() / kMaxBacklogFrames));
+    }
+    const auto end = queue.pending.begin() + static_cast<std::ptrdiff_t>(count);
+    batch.assign(queue.pending.begin(), end);
+    queue.pending.erase(queue.pending.begin(), end);
+  }
+  // Destroyed outside the lock so releasing threads never wait on bgfx.
+  for (const PendingHandle& handle : batch) {
+    Destroy(handle);
+  }
+  return batch.size();
+}
+
+std::size_t PendingDestroyCount() {
+  ReleaseQueue& queue = Queue();
+  const std::lock_guard<std::mutex> lock(queue.mutex);
+  return queue.pending.size();
+}
+
+}  // namespace livision::internal
@@ -0,0 +1,69 @@
+#include "livision/internal/mesh_barycentric.hpp"
+
+#include <limits>
+
+namespace livision::internal::mesh_barycentric {
+
+namespace {
+constexpr uint32_t kNoVertex = std::numeric_limits<uint32_t>::max();
+constexpr uint8_t kUnassigned = 0xFFU;
+constexpr uint8_t kPermutations[6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2},
+                                         {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+}  // namespace
+
+Channels AssignChannels(std::size_t vertex_count,
+                        std::vector<uint32_t>& indices) {
+  Channels result;
+  result.channels.assign(vertex_count, kUnassigned);
+  // variants[v * 3 + c]: vertex with the attributes of v and channel c.
+  std::vector<uint32_t> variants(vertex_count * 3, kNoVertex);
+
+  // Greedy in index order: each triangle takes the channel permutation that
+  // needs the fewest new copies, reusing copies made for earlier triangles.
+  for (std::size_t t = 0; t + 2 < indices.size(); t += 3) {
+    uint32_t* corners = &indices[t];
+    int best = 0;
+    int best_cost = 4;
+    for (int p = 0; p < 6 && best_cost > 0; ++p) {
+      int cost = 0;
+      for (int k = 0; k < 3; ++k) {
+        const std::size_t v = corners[k];
+        if (variants[(v * 3) + kPermutations[p][k]] == kNoVertex &&
+            result.channels[v] != kUnassigned) {
+          ++cost;
+        }
+      }
+      if (cost < best_cost) {
+        best = p;
+        best_cost = cost;
+      }
+    }
+
+    for (int k = 0; k < 3; ++k) {
+      const uint32_t v = corners[k];
+      const uint8_t channel = kPermutations[best][k];
+      uint32_t& variant = variants[(std::size_t{v} * 3) + channel];
+      if (variant == kNoVertex) {
+        if (result.channels[v] == kUnassigned) {
+          result.channels[v] = channel;
+          variant = v;
+        } else {
+          variant = static_cast<uint32_t>(result.channels.size());
+          result.channels.push_back(channel);
+          result.split_sources.push_back(v);
+        }
+      }
+      corners[k] = variant;
+    }
+  }
+
+  // Vertices no triangle uses are never drawn; any channel will do.
+  for (uint8_t& channel : result.channels) {
+    if (channel == kUnassigned) {
+      channel = 0;
+    }
+  }
+  return result;
+}
+
+}  // namespace livision::internal::mesh_barycentric
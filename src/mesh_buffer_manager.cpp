@@ -1,17 +1,30 @@
 #include "livision/internal/mesh_buffer_manager.hpp"
 
-#include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
+#include "livision/internal/mesh_buffer_access.hpp"
+
 namespace livision::internal {
 
 namespace {
+struct Slot {
+  MeshBuffer* mesh = nullptr;
+  uint32_t generation = 0;
+  std::string shared_key;  // Key in shared_cache, empty if not shared
+};
+
 struct ManagerState {
-  bool bgfx_alive = false;
+  // Read by threads releasing or building meshes.
+  std::atomic<bool> bgfx_alive = false;
+  std::atomic<bool> barycentric_wireframe = false;
+  // Meshes may be released on any thread holding the last reference.
+  std::mutex mutex;
   std::unordered_map<std::string, std::weak_ptr<MeshBuffer>> shared_cache;
-  std::vector<std::weak_ptr<MeshBuffer>> tracked;
+  std::vector<Slot> slots;
+  std::vector<uint32_t> free_slots;
 };
 
 ManagerState& State() {
@@ -19,23 +32,25 @@ ManagerState& State() {
   return state;
 }
 
-void PruneTracked(std::vector<std::weak_ptr<MeshBuffer>>& tracked) {
-  tracked.erase(std::remove_if(tracked.begin(), tracked.end(),
-                               [](const std::weak_ptr<MeshBuffer>& weak) {
-                                 return weak.expired();
-                               }),
-                tracked.end());
+// The byte counts are atomics the mesh publishes after each edit, so this
+// does not race with the thread updating the mesh.
+void Accumulate(MeshMemoryStats& stats, const MeshBuffer& mesh) {
+  ++stats.count;
+  stats.cpu_bytes += MeshBufferAccess::CpuBytes(mesh);
+  stats.gpu_bytes += MeshBufferAccess::GpuBytes(mesh);
 }
 }  // namespace
 
 std::shared_ptr<MeshBuffer> MeshBufferManager::AcquireShared(
     const std::string& key, const MeshFactory& factory) {
   auto& state = State();
-  auto it = state.shared_cache.find(key);
-  if (it != state.shared_cache.end()) {
-    if (auto existing = it->second.lock()) {
-      Register(existing);
-      return existing;
+  {
+    const std::lock_guard<std::mutex> lock(state.mutex);
+    const auto it = state.shared_cache.find(key);
+    if (it != state.shared_cache.end()) {
+      if (auto existing = it->second.lock()) {
+        return existing;
+      }
     }
   }
 
@@ -43,68 +58,111 @@ std::shared_ptr<MeshBuffer> MeshBufferManager::AcquireShared(
     return {};
   }
 
+  // The factory constructs a MeshBuffer, which registers itself, so it runs
+  // without the lock held.
   auto created = factory();
   if (!created) {
     return {};
   }
+  const MeshRegistryHandle handle = MeshBufferAccess::RegistryHandle(*created);
+  const std::lock_guard<std::mutex> lock(state.mutex);
   state.shared_cache[key] = created;
-  Register(created);
+  if (handle.slot < state.slots.size()) {
+    state.slots[handle.slot].shared_key = key;
+  }
   return created;
 }
 
 std::shared_ptr<MeshBuffer> MeshBufferManager::CreateTracked(
-    std::vector<Vertex> vertices, std::vector<uint32_t> indices, bool has_uv) {
-  auto mesh =
-      std::make_shared<MeshBuffer>(std::move(vertices), std::move(indices), has_uv);
-  Register(mesh);
-  return mesh;
+    std::vector<Vertex> vertices, std::vector<uint32_t> indices, bool has_uv,
+    MeshBufferOptions options) {
+  return std::make_shared<MeshBuffer>(std::move(vertices), std::move(indices),
+                                      has_uv, options);
 }
 
-void MeshBufferManager::Register(const std::shared_ptr<MeshBuffer>& mesh) {
-  if (!mesh) {
+MeshRegistryHandle MeshBufferManager::Register(MeshBuffer* mesh) {
+  auto& state = State();
+  const std::lock_guard<std::mutex> lock(state.mutex);
+  MeshRegistryHandle handle;
+  if (state.free_slots.empty()) {
+    handle.slot = static_cast<uint32_t>(state.slots.size());
+    state.slots.emplace_back();
+  } else {
+    handle.slot = state.free_slots.back();
+    state.free_slots.pop_back();
+  }
+  Slot& slot = state.slots[handle.slot];
+  slot.mesh = mesh;
+  handle.generation = slot.generation;
+  return handle;
+}
+
+void MeshBufferManager::Unregister(MeshRegistryHandle handle) {
+  auto& state = State();
+  const std::lock_guard<std::mutex> lock(state.mutex);
+  if (handle.slot >= state.slots.size()) {
     return;
   }
-  auto& tracked = State().tracked;
-  if ((tracked.size() % 64) == 0) {
-    PruneTracked(tracked);
+  Slot& slot = state.slots[handle.slot];
+  if (slot.mesh == nullptr || slot.generation != handle.generation) {
+    return;
   }
-  tracked.emplace_back(mesh);
+  if (!slot.shared_key.empty()) {
+    // Another mesh may already have taken the key over.
+    const auto it = state.shared_cache.find(slot.shared_key);
+    if (it != state.shared_cache.end() && it->second.expired()) {
+      state.shared_cache.erase(it);
+    }
+    slot.shared_key.clear();
+  }
+  slot.mesh = nullptr;
+  ++slot.generation;
+  state.free_slots.push_back(handle.slot);
 }
 
 void MeshBufferManager::DestroyAllBuffers() {
   auto& state = State();
-  std::vector<std::shared_ptr<MeshBuffer>> alive_meshes;
-  std::unordered_set<MeshBuffer*> seen;
-
-  alive_meshes.reserve(state.tracked.size() + state.shared_cache.size());
-  seen.reserve(state.tracked.size() + state.shared_cache.size());
-
-  for (const auto& weak : state.tracked) {
-    if (auto mesh = weak.lock()) {
-      if (seen.insert(mesh.get()).second) {
-        alive_meshes.emplace_back(std::move(mesh));
-      }
+  // Held throughout so no mesh can finish destruction meanwhile; Destroy
+  // does not touch the registry.
+  const std::lock_guard<std::mutex> lock(state.mutex);
+  for (Slot& slot : state.slots) {
+    if (slot.mesh != nullptr) {
+      slot.mesh->Destroy();
+      slot.shared_key.clear();
     }
   }
+  state.shared_cache.clear();
+}
 
-  for (const auto& [_, weak] : state.shared_cache) {
-    if (auto mesh = weak.lock()) {
-      if (seen.insert(mesh.get()).second) {
-        alive_meshes.emplace_back(std::move(mesh));
-      }
+MeshBufferStats MeshBufferManager::GetStats() {
+  auto& state = State();
+  const std::lock_guard<std::mutex> lock(state.mutex);
+  MeshBufferStats stats;
+  for (const Slot& slot : state.slots) {
+    if (slot.mesh == nullptr) {
+      continue;
+    }
+    if (slot.mesh->IsDynamic()) {
+      Accumulate(stats.dynamic, *slot.mesh);
+    } else if (!slot.shared_key.empty()) {
+      Accumulate(stats.shared, *slot.mesh);
+    } else {
+      Accumulate(stats.unique, *slot.mesh);
     }
   }
-
-  for (auto& mesh : alive_meshes) {
-    mesh->Destroy();
-  }
-
-  state.shared_cache.clear();
-  state.tracked.clear();
+  return stats;
 }
 
 void MeshBufferManager::SetBgfxAlive(bool alive) { State().bgfx_alive = alive; }
 
 bool MeshBufferManager::IsBgfxAlive() { return State().bgfx_alive; }
 
+void MeshBufferManager::SetBarycentricWireframe(bool enabled) {
+  State().barycentric_wireframe = enabled;
+}
+
+bool MeshBufferManager::UsesBarycentricWireframe() {
+  return State().barycentric_wireframe;
+}
+
 }  // namespace livision::internal
@@ -0,0 +1,142 @@
+#include "livision/internal/mesh_edges.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+namespace livision::internal::mesh_edges {
+
+namespace {
+// Below this many edges std::sort beats the radix passes' fixed costs.
+constexpr std::size_t kMinRadixKeys = std::size_t{1} << 14U;
+// Smallest chunk worth handing to another thread.
+constexpr std::size_t kMinParallelKeys = std::size_t{1} << 18U;
+
+constexpr int kDigitBits = 8;
+constexpr int kDigitCount = 64 / kDigitBits;
+constexpr std::size_t kBuckets = std::size_t{1} << kDigitBits;
+
+uint64_t EdgeKey(uint32_t a, uint32_t b) {
+  const uint32_t lo = std::min(a, b);
+  const uint32_t hi = std::max(a, b);
+  return (static_cast<uint64_t>(lo) << 32U) | hi;
+}
+
+// LSD radix sort of keys using scratch (same size) as the ping-pong buffer.
+// Digits that are equal across all keys, such as the high bytes of small
+// vertex indices, are skipped. The result always ends up in keys.
+void RadixSort(std::span<uint64_t> keys, std::span<uint64_t> scratch) {
+  if (keys.size() < kMinRadixKeys) {
+    std::sort(keys.begin(), keys.end());
+    return;
+  }
+  std::array<std::array<std::size_t, kBuckets>, kDigitCount> counts{};
+  for (const uint64_t key : keys) {
+    for (int d = 0; d < kDigitCount; ++d) {
+      ++counts[d][(key >> (d * kDigitBits)) & (kBuckets - 1)];
+    }
+  }
+
+  uint64_t* src = keys.data();
+  uint64_t* dst = scratch.data();
+  for (int d = 0; d < kDigitCount; ++d) {
+    auto& count = counts[d];
+    if (std::ranges::find(count, keys.size()) != count.end()) {
+      continue;
+    }
+    std::size_t offset = 0;
+    for (std::size_t& c : count) {
+      const std::size_t n = c;
+      c = offset;
+      offset += n;
+    }
+    const int shift = d * kDigitBits;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      const uint64_t key = src[i];
+      dst[count[(key >> shift) & (kBuckets - 1)]++] = key;
+    }
+    std::swap(src, dst);
+  }
+  if (src != keys.data()) {
+    std::copy(src, src + keys.size(), keys.data());
+  }
+}
+}  // namespace
+
+std::vector<uint32_t> ExtractEdges(std::span<const uint32_t> indices,
+                                   ThreadPool* pool) {
+  const std::size_t tri_count = indices.size() / 3;
+  const std::size_t key_count = tri_count * 3;
+  if (key_count == 0) {
+    return {};
+  }
+
+  std::size_t chunks = 1;
+  if (pool) {
+    chunks = std::clamp<std::size_t>(key_count / kMinParallelKeys, 1,
+                                     pool->ThreadCount() + 1);
+  }
+  // Chunk boundaries fall on whole triangles so each chunk writes its own
+  // slice of keys.
+  std::vector<std::size_t> bounds(chunks + 1);
+  for (std::size_t c = 0; c <= chunks; ++c) {
+    bounds[c] = (tri_count * c / chunks) * 3;
+  }
+
+  std::vector<uint64_t> keys(key_count);
+  std::vector<uint64_t> scratch(key_count);
+  auto sort_chunk = [&](std::size_t c) {
+    for (std::size_t i = bounds[c]; i < bounds[c + 1]; i += 3) {
+      keys[i] = EdgeKey(indices[i], indices[i + 1]);
+      keys[i + 1] = EdgeKey(indices[i + 1], indices[i + 2]);
+      keys[i + 2] = EdgeKey(indices[i + 2], indices[i]);
+    }
+    const std::size_t size = bounds[c + 1] - bounds[c];
+    RadixSort({keys.data() + bounds[c], size},
+              {scratch.data() + bounds[c], size});
+  };
+  if (chunks > 1) {
+    pool->ParallelFor(chunks, sort_chunk);
+  } else {
+    sort_chunk(0);
+  }
+
+  // Merge sorted chunks pairwise, ping-ponging between the two buffers.
+  uint64_t* src = keys.data();
+  uint64_t* dst = scratch.data();
+  for (std::size_t width = 1; width < chunks; width *= 2) {
+    const std::size_t pairs = (chunks + (2 * width) - 1) / (2 * width);
+    auto merge_pair = [&, width](std::size_t p) {
+      const std::size_t begin = bounds[p * 2 * width];
+      const std::size_t mid = bounds[std::min(((p * 2) + 1) * width, chunks)];
+      const std::size_t end = bounds[std::min((p + 1) * 2 * width, chunks)];
+      std::merge(src + begin, src + mid, src + mid, src + end, dst + begin);
+    };
+    if (pairs > 1) {
+      pool->ParallelFor(pairs, merge_pair);
+    } else {
+      merge_pair(0);
+    }
+    std::swap(src, dst);
+  }
+
+  std::vector<uint32_t> edges;
+  edges.reserve(key_count);
+  uint64_t previous = 0;
+  for (std::size_t i = 0; i < key_count; ++i) {
+    const uint64_t key = src[i];
+    if (i > 0 && key == previous) {
+      continue;
+    }
+    previous = key;
+    const auto lo = static_cast<uint32_t>(key >> 32U);
+    const auto hi = static_cast<uint32_t>(key);
+    if (lo != hi) {
+      edges.push_back(lo);
+      edges.push_back(hi);
+    }
+  }
+  return edges;
+}
+
+}  // namespace livision::internal::mesh_edges
@@ -0,0 +1,81 @@
+#include "livision/internal/mesh_normals.hpp"
+
+#include <Eigen/Geometry>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+
+namespace livision::internal::mesh_normals {
+
+namespace {
+struct PositionHash {
+  std::size_t operator()(const Eigen::Vector3f& p) const {
+    std::size_t seed = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+      // +0.0F folds -0 into 0, which compare equal.
+      const std::size_t h = std::hash<float>{}(p[axis] + 0.0F);
+      seed ^= h + 0x9e3779b9U + (seed << 6U) + (seed >> 2U);
+    }
+    return seed;
+  }
+};
+
+uint32_t PackUnorm8(const Eigen::Vector3f& n) {
+  uint32_t packed = 0xFF000000U;
+  for (int axis = 0; axis < 3; ++axis) {
+    const auto byte =
+        static_cast<uint32_t>(std::lround(((n[axis] * 0.5F) + 0.5F) * 255.0F));
+    packed |= byte << (8U * static_cast<uint32_t>(axis));
+  }
+  return packed;
+}
+}  // namespace
+
+std::vector<uint32_t> SmoothNormals(std::span<const Vertex> vertices,
+                                    std::span<const uint32_t> indices) {
+  // Group vertices by position first, then accumulate per group.
+  std::unordered_map<Eigen::Vector3f, uint32_t, PositionHash> groups;
+  groups.reserve(vertices.size());
+  std::vector<uint32_t> group_of(vertices.size());
+  for (std::size_t i = 0; i < vertices.size(); ++i) {
+    const Eigen::Vector3f p(vertices[i].x, vertices[i].y, vertices[i].z);
+    group_of[i] =
+        groups.try_emplace(p, static_cast<uint32_t>(groups.size()))
+            .first->second;
+  }
+
+  std::vector<Eigen::Vector3f> sums(groups.size(), Eigen::Vector3f::Zero());
+  for (std::size_t t = 0; t + 2 < indices.size(); t += 3) {
+    const uint32_t i0 = indices[t];
+    const uint32_t i1 = indices[t + 1];
+    const uint32_t i2 = indices[t + 2];
+    if (i0 >= vertices.size() || i1 >= vertices.size() ||
+        i2 >= vertices.size()) {
+      continue;
+    }
+    const Eigen::Vector3f p0(vertices[i0].x, vertices[i0].y, vertices[i0].z);
+    const Eigen::Vector3f p1(vertices[i1].x, vertices[i1].y, vertices[i1].z);
+    const Eigen::Vector3f p2(vertices[i2].x, vertices[i2].y, vertices[i2].z);
+    // The cross product length is twice the area, so larger faces weigh more.
+    const Eigen::Vector3f face = (p1 - p0).cross(p2 - p0);
+    sums[group_of[i0]] += face;
+    sums[group_of[i1]] += face;
+    sums[group_of[i2]] += face;
+  }
+
+  std::vector<uint32_t> packed_groups(sums.size());
+  for (std::size_t g = 0; g < sums.size(); ++g) {
+    const float length = sums[g].norm();
+    packed_groups[g] = PackUnorm8(
+        length > 0.0F ? Eigen::Vector3f(sums[g] / length)
+                      : Eigen::Vector3f::UnitZ());
+  }
+  std::vector<uint32_t> normals(vertices.size());
+  for (std::size_t i = 0; i < vertices.size(); ++i) {
+    normals[i] = packed_groups[group_of[i]];
+  }
+  return normals;
+}
+
+}  // namespace livision::internal::mesh_normals
@@ -0,0 +1,260 @@
+#include "livision/internal/mesh_optimizer.hpp"
+
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace livision::internal::mesh_optimizer {
+
+namespace {
+// Clusters shorter than this are merged into the previous one so the overdraw
+// sort cannot shatter the cache-friendly order into single triangles.
+constexpr size_t kMinClusterTriangles = 8;
+
+bool IndicesInRange(const std::vector<uint32_t>& indices, size_t vertex_count) {
+  return std::ranges::all_of(
+      indices, [vertex_count](uint32_t idx) { return idx < vertex_count; });
+}
+
+Eigen::Vector3f Position(const Vertex& v) { return {v.x, v.y, v.z}; }
+}  // namespace
+
+void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertex_count) {
+  const size_t tri_count = indices.size() / 3;
+  if (tri_count == 0 || vertex_count == 0 ||
+      !IndicesInRange(indices, vertex_count)) {
+    return;
+  }
+
+  // Vertex -> triangle adjacency in CSR form.
+  std::vector<uint32_t> live(vertex_count, 0);
+  for (size_t i = 0; i < tri_count * 3; ++i) {
+    ++live[indices[i]];
+  }
+  std::vector<uint32_t> offsets(vertex_count + 1, 0);
+  for (size_t v = 0; v < vertex_count; ++v) {
+    offsets[v + 1] = offsets[v] + live[v];
+  }
+  std::vector<uint32_t> adjacency(tri_count * 3);
+  std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+  for (size_t t = 0; t < tri_count; ++t) {
+    for (size_t k = 0; k < 3; ++k) {
+      adjacency[fill[indices[(t * 3) + k]]++] = static_cast<uint32_t>(t);
+    }
+  }
+
+  std::vector<uint32_t> cache_time(vertex_count, 0);
+  std::vector<bool> emitted(tri_count, false);
+  std::vector<uint32_t> dead_end;
+  dead_end.reserve(tri_count * 3);
+  std::vector<uint32_t> candidates;
+  std::vector<uint32_t> result;
+  result.reserve(tri_count * 3);
+  uint32_t time = kCacheSize + 1;
+  size_t cursor = 0;
+
+  auto skip_dead_end = [&]() -> int64_t {
+    while (!dead_end.empty()) {
+      const uint32_t v = dead_end.back();
+      dead_end.pop_back();
+      if (live[v] > 0) {
+        return v;
+      }
+    }
+    for (; cursor < vertex_count; ++cursor) {
+      if (live[cursor] > 0) {
+        return static_cast<int64_t>(cursor);
+      }
+    }
+    return -1;
+  };
+
+  int64_t fanning = skip_dead_end();
+  while (fanning >= 0) {
+    const auto f = static_cast<size_t>(fanning);
+    candidates.clear();
+    for (uint32_t a = offsets[f]; a < offsets[f + 1]; ++a) {
+      const uint32_t t = adjacency[a];
+      if (emitted[t]) {
+        continue;
+      }
+      for (size_t k = 0; k < 3; ++k) {
+        const uint32_t v = indices[(t * 3) + k];
+        result.push_back(v);
+        dead_end.push_back(v);
+        candidates.push_back(v);
+        --live[v];
+        if (time - cache_time[v] > kCacheSize) {
+          cache_time[v] = time++;
+        }
+      }
+      emitted[t] = true;
+    }
+
+    // Prefer the candidate that stays in cache longest while its remaining
+    // triangles are emitted.
+    int64_t best = -1;
+    int64_t best_priority = -1;
+    for (const uint32_t v : candidates) {
+      if (live[v] == 0) {
+        continue;
+      }
+      int64_t priority = 0;
+      if (time - cache_time[v] + (2 * live[v]) <= kCacheSize) {
+        priority = time - cache_time[v];
+      }
+      if (priority > best_priority) {
+        best_priority = priority;
+        best = v;
+      }
+    }
+    fanning = (best >= 0) ? best : skip_dead_end();
+  }
+
+  indices.swap(result);
+}
+
+void OptimizeOverdraw(std::vector<uint32_t>& indices,
+                      const std::vector<Vertex>& vertices) {
+  const size_t tri_count = indices.size() / 3;
+  if (tri_count < 2 || !IndicesInRange(indices, vertices.size())) {
+    return;
+  }
+
+  // A triangle that misses the cache on every vertex starts a new locality
+  // cluster.
+  std::vector<size_t> cluster_starts{0};
+  std::vector<uint32_t> cache_time(vertices.size(), 0);
+  uint32_t time = kCacheSize + 1;
+  for (size_t t = 0; t < tri_count; ++t) {
+    int misses = 0;
+    for (size_t k = 0; k < 3; ++k) {
+      const uint32_t v = indices[(t * 3) + k];
+      if (time - cache_time[v] > kCacheSize) {
+        cache_time[v] = time++;
+        ++misses;
+      }
+    }
+    if (misses == 3 && t - cluster_starts.back() >= kMinClusterTriangles) {
+      cluster_starts.push_back(t);
+    }
+  }
+  if (cluster_starts.size() < 2) {
+    return;
+  }
+  cluster_starts.push_back(tri_count);
+
+  const size_t cluster_count = cluster_starts.size() - 1;
+  std::vector<Eigen::Vector3f> centroids(cluster_count,
+                                         Eigen::Vector3f::Zero());
+  std::vector<Eigen::Vector3f> normals(cluster_count, Eigen::Vector3f::Zero());
+  std::vector<float> areas(cluster_count, 0.0F);
+  Eigen::Vector3f mesh_centroid = Eigen::Vector3f::Zero();
+  float mesh_area = 0.0F;
+
+  for (size_t c = 0; c < cluster_count; ++c) {
+    for (size_t t = cluster_starts[c]; t < cluster_starts[c + 1]; ++t) {
+      const Eigen::Vector3f p0 = Position(vertices[indices[t * 3]]);
+      const Eigen::Vector3f p1 = Position(vertices[indices[(t * 3) + 1]]);
+      const Eigen::Vector3f p2 = Position(vertices[indices[(t * 3) + 2]]);
+      const Eigen::Vector3f n = (p1 - p0).cross(p2 - p0);
+      const float area = n.norm();
+      const Eigen::Vector3f center = (p0 + p1 + p2) / 3.0F;
+      centroids[c] += center * area;
+      normals[c] += n;
+      areas[c] += area;
+    }
+    mesh_centroid += centroids[c];
+    mesh_area += areas[c];
+  }
+  if (mesh_area <= 0.0F) {
+    return;
+  }
+  mesh_centroid /= mesh_area;
+
+  // Clusters facing away from the mesh center are likely occluders; draw them
+  // first so the depth test rejects more of the rest.
+  std::vector<float> keys(cluster_count, 0.0F);
+  for (size_t c = 0; c < cluster_count; ++c) {
+    if (areas[c] <= 0.0F) {
+      continue;
+    }
+    const Eigen::Vector3f centroid = centroids[c] / areas[c];
+    const float normal_len = normals[c].norm();
+    if (normal_len > 0.0F) {
+      keys[c] = (centroid - mesh_centroid).dot(normals[c] / normal_len);
+    }
+  }
+
+  std::vector<size_t> order(cluster_count);
+  std::iota(order.begin(), order.end(), 0);
+  std::ranges::stable_sort(
+      order, [&keys](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+  std::vector<uint32_t> result;
+  result.reserve(tri_count * 3);
+  for (const size_t c : order) {
+    result.insert(result.end(), indices.begin() + (cluster_starts[c] * 3),
+                  indices.begin() + (cluster_starts[c + 1] * 3));
+  }
+  indices.swap(result);
+}
+
+void OptimizeVertexFetch(std::vector<Vertex>& vertices,
+                         std::vector<uint32_t>& indices) {
+  if (!IndicesInRange(indices, vertices.size())) {
+    return;
+  }
+
+  constexpr uint32_t kUnmapped = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> remap(vertices.size(), kUnmapped);
+  std::vector<Vertex> result;
+  result.reserve(vertices.size());
+  for (uint32_t& idx : indices) {
+    if (remap[idx] == kUnmapped) {
+      remap[idx] = static_cast<uint32_t>(result.size());
+      result.push_back(vertices[idx]);
+    }
+    idx = remap[idx];
+  }
+  vertices.swap(result);
+}
+
+void OptimizeMesh(std::vector<Vertex>& vertices,
+                  std::vector<uint32_t>& indices) {
+  if (indices.size() < 3 || !IndicesInRange(indices, vertices.size())) {
+    return;
+  }
+
+  std::vector<uint32_t> reordered = indices;
+  OptimizeVertexCache(reordered, vertices.size());
+  OptimizeOverdraw(reordered, vertices);
+  if (AverageCacheMissRatio(reordered, vertices.size()) <
+      AverageCacheMissRatio(indices, vertices.size())) {
+    indices.swap(reordered);
+  }
+  OptimizeVertexFetch(vertices, indices);
+}
+
+float AverageCacheMissRatio(const std::vector<uint32_t>& indices,
+                            size_t vertex_count) {
+  const size_t tri_count = indices.size() / 3;
+  if (tri_count == 0 || !IndicesInRange(indices, vertex_count)) {
+    return 0.0F;
+  }
+
+  std::vector<uint32_t> cache_time(vertex_count, 0);
+  uint32_t time = kCacheSize + 1;
+  size_t misses = 0;
+  for (size_t i = 0; i < tri_count * 3; ++i) {
+    const uint32_t v = indices[i];
+    if (time - cache_time[v] > kCacheSize) {
+      cache_time[v] = time++;
+      ++misses;
+    }
+  }
+  return static_cast<float>(misses) / static_cast<float>(tri_count);
+}
+
+}  // namespace livision::internal::mesh_optimizer
@@ -0,0 +1,266 @@
+#include "livision/internal/mesh_simplifier.hpp"
+
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <unordered_map>
+
+namespace livision::internal::mesh_simplifier {
+
+namespace {
+// Symmetric plane quadric: p^T A p + 2 b^T p + c.
+struct Quadric {
+  double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+  double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+  double c = 0.0;
+
+  static Quadric FromPlane(const Eigen::Vector3d& n, double d, double w) {
+    Quadric q;
+    q.a00 = w * n.x() * n.x();
+    q.a01 = w * n.x() * n.y();
+    q.a02 = w * n.x() * n.z();
+    q.a11 = w * n.y() * n.y();
+    q.a12 = w * n.y() * n.z();
+    q.a22 = w * n.z() * n.z();
+    q.b0 = w * d * n.x();
+    q.b1 = w * d * n.y();
+    q.b2 = w * d * n.z();
+    q.c = w * d * d;
+    return q;
+  }
+
+  Quadric& operator+=(const Quadric& o) {
+    a00 += o.a00;
+    a01 += o.a01;
+    a02 += o.a02;
+    a11 += o.a11;
+    a12 += o.a12;
+    a22 += o.a22;
+    b0 += o.b0;
+    b1 += o.b1;
+    b2 += o.b2;
+    c += o.c;
+    return *this;
+  }
+
+  double Error(const Eigen::Vector3d& p) const {
+    const double x = p.x();
+    const double y = p.y();
+    const double z = p.z();
+    const double e = (a00 * x * x) + (a11 * y * y) + (a22 * z * z) +
+                     (2.0 * ((a01 * x * y) + (a02 * x * z) + (a12 * y * z))) +
+                     (2.0 * ((b0 * x) + (b1 * y) + (b2 * z))) + c;
+    return std::max(e, 0.0);
+  }
+};
+
+struct Collapse {
+  uint32_t from;
+  uint32_t to;
+  double cost;
+};
+
+Eigen::Vector3d Position(const Vertex& v) {
+  return {static_cast<double>(v.x), static_cast<double>(v.y),
+          static_cast<double>(v.z)};
+}
+
+uint64_t EdgeKey(uint32_t a, uint32_t b) {
+  const uint32_t lo = std::min(a, b);
+  const uint32_t hi = std::max(a, b);
+  return (static_cast<uint64_t>(lo) << 32U) | hi;
+}
+
+// Vertices on edges used by anything other than exactly two triangles.
+std::vector<bool> FindLockedVertices(const std::vector<uint32_t>& indices,
+                                     std::size_t vertex_count) {
+  std::unordered_map<uint64_t, uint32_t> edge_use;
+  edge_use.reserve(indices.size());
+  for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+    for (std::size_t k = 0; k < 3; ++k) {
+      ++edge_use[EdgeKey(indices[i + k], indices[i + ((k + 1) % 3)])];
+    }
+  }
+  std::vector<bool> locked(vertex_count, false);
+  for (const auto& [key, count] : edge_use) {
+    if (count != 2) {
+      locked[static_cast<uint32_t>(key >> 32U)] = true;
+      locked[static_cast<uint32_t>(key & 0xFFFFFFFFU)] = true;
+    }
+  }
+  return locked;
+}
+
+// True when moving `from` onto `to` would flip or collapse a triangle that
+// survives the collapse.
+bool FlipsTriangle(const std::vector<Vertex>& vertices,
+                   const std::vector<uint32_t>& indices,
+                   const std::vector<uint32_t>& offsets,
+                   const std::vector<uint32_t>& adjacency, uint32_t from,
+                   uint32_t to) {
+  const Eigen::Vector3d target = Position(vertices[to]);
+  for (uint32_t a = offsets[from]; a < offsets[from + 1]; ++a) {
+    const uint32_t t = adjacency[a];
+    const uint32_t i0 = indices[t * 3];
+    const uint32_t i1 = indices[(t * 3) + 1];
+    const uint32_t i2 = indices[(t * 3) + 2];
+    if (i0 == to || i1 == to || i2 == to) {
+      continue;
+    }
+    Eigen::Vector3d p[3] = {Position(vertices[i0]), Position(vertices[i1]),
+                            Position(vertices[i2])};
+    const Eigen::Vector3d before = (p[1] - p[0]).cross(p[2] - p[0]);
+    p[(i0 == from) ? 0 : (i1 == from) ? 1 : 2] = target;
+    const Eigen::Vector3d after = (p[1] - p[0]).cross(p[2] - p[0]);
+    if (before.dot(after) <= 0.0) {
+      return true;
+    }
+  }
+  return false;
+}
+}  // namespace
+
+std::vector<uint32_t> SimplifyMesh(const std::vector<Vertex>& vertices,
+                                   const std::vector<uint32_t>& indices,
+                                   std::size_t target_index_count) {
+  const std::size_t vertex_count = vertices.size();
+  std::vector<uint32_t> result(indices.begin(),
+                               indices.begin() + (indices.size() / 3 * 3));
+  if (result.size() <= target_index_count ||
+      !std::ranges::all_of(result, [vertex_count](uint32_t idx) {
+        return idx < vertex_count;
+      })) {
+    return result;
+  }
+
+  const std::vector<bool> locked = FindLockedVertices(result, vertex_count);
+
+  // Area-weighted quadrics of the incident triangle planes.
+  std::vector<Quadric> quadrics(vertex_count);
+  for (std::size_t i = 0; i < result.size(); i += 3) {
+    const Eigen::Vector3d p0 = Position(vertices[result[i]]);
+    const Eigen::Vector3d p1 = Position(vertices[result[i + 1]]);
+    const Eigen::Vector3d p2 = Position(vertices[result[i + 2]]);
+    Eigen::Vector3d n = (p1 - p0).cross(p2 - p0);
+    const double area2 = n.norm();
+    if (area2 <= 0.0) {
+      continue;
+    }
+    n /= area2;
+    const Quadric q = Quadric::FromPlane(n, -n.dot(p0), area2 * 0.5);
+    for (std::size_t k = 0; k < 3; ++k) {
+      quadrics[result[i + k]] += q;
+    }
+  }
+
+  std::vector<Collapse> candidates;
+  std::vector<uint32_t> remap(vertex_count);
+  std::vector<bool> touched(vertex_count);
+  std::vector<uint32_t> offsets(vertex_count + 1);
+  std::vector<uint32_t> adjacency;
+
+  while (result.size() > target_index_count) {
+    const std::size_t tri_count = result.size() / 3;
+
+    // Vertex -> triangle adjacency for the flip test.
+    std::ranges::fill(offsets, 0U);
+    for (const uint32_t idx : result) {
+      ++offsets[idx + 1];
+    }
+    for (std::size_t v = 0; v < vertex_count; ++v) {
+      offsets[v + 1] += offsets[v];
+    }
+    adjacency.resize(result.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (std::size_t t = 0; t < tri_count; ++t) {
+      for (std::size_t k = 0; k < 3; ++k) {
+        adjacency[fill[result[(t * 3) + k]]++] = static_cast<uint32_t>(t);
+      }
+    }
+
+    candidates.clear();
+    for (std::size_t i = 0; i < result.size(); i += 3) {
+      for (std::size_t k = 0; k < 3; ++k) {
+        const uint32_t a = result[i + k];
+        const uint32_t b = result[i + ((k + 1) % 3)];
+        if (a > b) {
+          continue;
+        }
+        const Quadric& qa = quadrics[a];
+        const Quadric& qb = quadrics[b];
+        Collapse best{a, b, -1.0};
+        if (!locked[a]) {
+          Quadric q = qa;
+          q += qb;
+          best.cost = q.Error(Position(vertices[b]));
+        }
+        if (!locked[b]) {
+          Quadric q = qa;
+          q += qb;
+          const double cost = q.Error(Position(vertices[a]));
+          if (best.cost < 0.0 || cost < best.cost) {
+            best = Collapse{b, a, cost};
+          }
+        }
+        if (best.cost >= 0.0) {
+          candidates.push_back(best);
+        }
+      }
+    }
+    if (candidates.empty()) {
+      break;
+    }
+    std::ranges::sort(candidates, [](const Collapse& l, const Collapse& r) {
+      return l.cost < r.cost;
+    });
+
+    // Each collapse removes about two triangles.
+    const std::size_t max_collapses =
+        std::max<std::size_t>(1, (result.size() - target_index_count) / 6);
+    for (uint32_t v = 0; v < vertex_count; ++v) {
+      remap[v] = v;
+    }
+    std::fill(touched.begin(), touched.end(), false);
+    std::size_t collapses = 0;
+    for (const Collapse& c : candidates) {
+      if (collapses >= max_collapses) {
+        break;
+      }
+      if (touched[c.from] || touched[c.to] ||
+          FlipsTriangle(vertices, result, offsets, adjacency, c.from, c.to)) {
+        continue;
+      }
+      remap[c.from] = c.to;
+      quadrics[c.to] += quadrics[c.from];
+      // Lock the whole one-ring so no other collapse in this pass moves a
+      // vertex of a triangle that was just changed.
+      for (uint32_t a = offsets[c.from]; a < offsets[c.from + 1]; ++a) {
+        const uint32_t t = adjacency[a];
+        for (std::size_t k = 0; k < 3; ++k) {
+          touched[result[(t * 3) + k]] = true;
+        }
+      }
+      ++collapses;
+    }
+    if (collapses == 0) {
+      break;
+    }
+
+    std::size_t write = 0;
+    for (std::size_t i = 0; i < result.size(); i += 3) {
+      const uint32_t i0 = remap[result[i]];
+      const uint32_t i1 = remap[result[i + 1]];
+      const uint32_t i2 = remap[result[i + 2]];
+      if (i0 == i1 || i1 == i2 || i2 == i0) {
+        continue;
+      }
+      result[write++] = i0;
+      result[write++] = i1;
+      result[write++] = i2;
+    }
+    result.resize(write);
+  }
+
+  return result;
+}
+
+}  // namespace livision::internal::mesh_simplifier
@@ -2,17 +2,29 @@
 
 #include <vector>
 
+#include "livision/internal/mesh_buffer_access.hpp"
 #include "livision/internal/mesh_buffer_manager.hpp"
 
 namespace livision {
 
 void Mesh::SetMeshData(const std::vector<Vertex>& vertices,
-                       const std::vector<uint32_t>& indices, bool has_uv) {
-  mesh_buf_ = internal::MeshBufferManager::CreateTracked(vertices, indices, has_uv);
+                       const std::vector<uint32_t>& indices, bool has_uv,
+                       MeshBufferOptions options) {
+  // Dynamic meshes rebuilt every frame keep their GPU buffers and only grow
+  // them when the new data does not fit.
+  if (options.dynamic && mesh_buf_ && mesh_buf_->IsDynamic() &&
+      internal::MeshBufferAccess::HasUV(*mesh_buf_) == has_uv) {
+    mesh_buf_->Resize(static_cast<uint32_t>(vertices.size()),
+                      static_cast<uint32_t>(indices.size()));
+    mesh_buf_->UpdateVertices(0, vertices);
+    mesh_buf_->UpdateIndices(0, indices);
+    return;
+  }
+  mesh_buf_ = internal::MeshBufferManager::CreateTracked(vertices, indices,
+                                                         has_uv, options);
 }
 
 void Mesh::SetMeshBuffer(std::shared_ptr<MeshBuffer> mesh_buffer) {
-  internal::MeshBufferManager::Register(mesh_buffer);
   mesh_buf_ = std::move(mesh_buffer);
 }
 
@@ -77,10 +77,59 @@ std::string BuildMeshKey(const std::string& tag,
   return tag + ":" + std::to_string(seed);
 }
 
+MeshBufferOptions MeshOptionsFrom(const Model::LoadOptions& options) {
+  return MeshBufferOptions{.cpu_retention = options.cpu_retention,
+                           .quantize_positions = options.quantize_positions,
+                           .generate_lods = options.generate_lods,
+                           .normals = options.smooth_normals
+                                          ? MeshNormals::Smooth
+                                          : MeshNormals::Flat,
+                           .keep_wireframe = options.keep_wireframe};
+}
+
+// Buffers released after upload cannot serve callers that expect CPU data,
+// and quantized or LOD buffers carry different GPU data, so keep them apart
+// in the shared cache.
+std::string MeshKeyTag(const std::string& tag,
+                       const Model::LoadOptions& options) {
+  std::string key = tag;
+  if (options.cpu_retention == CpuRetention::Release) {
+    key += options.keep_wireframe ? ":release_wire" : ":release";
+  }
+  if (options.quantize_positions) {
+    key += ":quantized";
+  }
+  if (options.generate_lods) {
+    key += ":lod";
+  }
+  if (options.smooth_normals) {
+    key += ":smooth";
+  }
+  return key;
+}
+
+internal::sdf_loader::MeshLoadOptions FileOptionsFrom(
+    const Model::LoadOptions& options) {
+  return internal::sdf_loader::MeshLoadOptions{.optimize =
+                                                   options.optimize_meshes};
+}
+
+// Optimized and file-order loads of the same path are different data.
+std::string FileCacheKey(const std::string& path,
+                         const internal::sdf_loader::MeshLoadOptions& options) {
+  std::string key = NormalizeCacheKey(path);
+  if (options.optimize) {
+    key += ":optimized";
+  }
+  return key;
+}
+
 std::shared_ptr<const internal::sdf_loader::SdfNode> AcquireSdfScene(
-    const std::string& path, bool force_reload, std::string* error) {
+    const std::string& path, bool force_reload,
+    const internal::sdf_loader::MeshLoadOptions& load_options,
+    std::string* error) {
   auto& cache = SdfSceneCache();
-  const std::string key = NormalizeCacheKey(path);
+  const std::string key = FileCacheKey(path, load_options);
 
   if (!force_reload) {
     auto it = cache.find(key);
@@ -92,7 +141,8 @@ std::shared_ptr<const internal::sdf_loader::SdfNode> AcquireSdfScene(
   }
 
   auto scene = std::make_shared<internal::sdf_loader::SdfNode>();
-  if (!internal::sdf_loader::LoadSdfScene(path, *scene, error)) {
+  if (!internal::sdf_loader::LoadSdfScene(path, *scene, load_options,
+                                          error)) {
     return {};
   }
   cache[key].data = scene;
@@ -100,9 +150,11 @@ std::shared_ptr<const internal::sdf_loader::SdfNode> AcquireSdfScene(
 }
 
 std::shared_ptr<const std::vector<internal::sdf_loader::MeshPart>>
-AcquireMeshParts(const std::string& path, bool force_reload, std::string* error) {
+AcquireMeshParts(const std::string& path, bool force_reload,
+                 const internal::sdf_loader::MeshLoadOptions& load_options,
+                 std::string* error) {
   auto& cache = MeshPartsCache();
-  const std::string key = NormalizeCacheKey(path);
+  const std::string key = FileCacheKey(path, load_options);
 
   if (!force_reload) {
     auto it = cache.find(key);
@@ -114,7 +166,8 @@ AcquireMeshParts(const std::string& path, bool force_reload, std::string* error)
   }
 
   auto parts = std::make_shared<std::vector<internal::sdf_loader::MeshPart>>();
-  if (!internal::sdf_loader::LoadMeshFileParts(path, *parts, error)) {
+  if (!internal::sdf_loader::LoadMeshFileParts(path, *parts, load_options,
+                                               error)) {
     return {};
   }
   cache[key].data = parts;
@@ -179,42 +232,51 @@ Model* Model::SetFromFile(const std::string& path, LoadOptions options) {
 
   std::string error;
   if (HasExtension(path, "sdf")) {
-    auto scene = AcquireSdfScene(path, options.force_reload, &error);
+    auto scene = AcquireSdfScene(path, options.force_reload,
+                                 FileOptionsFrom(options), &error);
     if (!scene) {
       LogMessage(LogLevel::Error, "Failed to load SDF: ", path,
                  error.empty() ? "" : "\n", error);
       return this;
     }
     if (scene->tag == "sdf" && scene->children.size() == 1U) {
-      BuildFromNode(scene->children.front(), false);
+      BuildFromNode(scene->children.front(), false, options);
     } else {
-      BuildFromNode(*scene, false);
+      BuildFromNode(*scene, false, options);
     }
     return this;
   }
 
-  auto mesh_parts = AcquireMeshParts(path, options.force_reload, &error);
+  auto mesh_parts = AcquireMeshParts(path, options.force_reload,
+                                     FileOptionsFrom(options), &error);
   if (!mesh_parts) {
     LogMessage(LogLevel::Error, "Failed to load mesh file: ", path,
                error.empty() ? "" : "\n", error);
     return this;
   }
 
+  const MeshBufferOptions mesh_options = MeshOptionsFrom(options);
   std::size_t mesh_index = 0;
   for (const auto& part : *mesh_parts) {
     auto mesh = std::make_shared<Mesh>();
     mesh->SetName("mesh#" + std::to_string(mesh_index++));
     const std::string mesh_key =
-        BuildMeshKey("model:file_mesh", part.vertices, part.indices, part.has_uv);
+        BuildMeshKey(MeshKeyTag("model:file_mesh", options), part.vertices,
+                     part.indices, part.has_uv);
     auto mesh_buf = internal::MeshBufferManager::AcquireShared(
-        mesh_key, [&part]() {
-          return std::make_shared<MeshBuffer>(part.vertices, part.indices,
-                                              part.has_uv);
+        mesh_key, [&part, &mesh_options]() {
+          auto buffer = std::make_shared<MeshBuffer>(
+              part.vertices, part.indices, part.has_uv, mesh_options);
+          if (!part.wire_indices.empty()) {
+            buffer->SetWireIndices(part.wire_indices);
+          }
+          return buffer;
         });
     if (mesh_buf) {
       mesh->SetMeshBuffer(std::move(mesh_buf));
     } else {
-      mesh->SetMeshData(part.vertices, part.indices, part.has_uv);
+      mesh->SetMeshData(part.vertices, part.indices, part.has_uv,
+                        mesh_options);
     }
     // User-specified model color should override assimp material color
     // (e.g. rainbow_z in examples). Material color is used only when the model
@@ -240,7 +302,8 @@ void Model::AddOwned(std::shared_ptr<ObjectBase> child) {
 }
 
 void Model::BuildFromNode(const internal::sdf_loader::SdfNode& node,
-                          bool apply_self_transform) {
+                          bool apply_self_transform,
+                          const LoadOptions& options) {
   SetName(node.effective_name);
 
   if (apply_self_transform) {
@@ -252,17 +315,24 @@ void Model::BuildFromNode(const internal::sdf_loader::SdfNode& node,
   if (node.HasMesh()) {
     auto mesh = std::make_shared<Mesh>();
     mesh->SetName("mesh#0");
+    const MeshBufferOptions mesh_options = MeshOptionsFrom(options);
     const std::string mesh_key =
-        BuildMeshKey("model:sdf_node", node.vertices, node.indices, node.has_uv);
+        BuildMeshKey(MeshKeyTag("model:sdf_node", options), node.vertices,
+                     node.indices, node.has_uv);
     auto mesh_buf = internal::MeshBufferManager::AcquireShared(
-        mesh_key, [&node]() {
-          return std::make_shared<MeshBuffer>(node.vertices, node.indices,
-                                              node.has_uv);
+        mesh_key, [&node, &mesh_options]() {
+          auto buffer = std::make_shared<MeshBuffer>(
+              node.vertices, node.indices, node.has_uv, mesh_options);
+          if (!node.wire_indices.empty()) {
+            buffer->SetWireIndices(node.wire_indices);
+          }
+          return buffer;
         });
     if (mesh_buf) {
       mesh->SetMeshBuffer(std::move(mesh_buf));
     } else {
-      mesh->SetMeshData(node.vertices, node.indices, node.has_uv);
+      mesh->SetMeshData(node.vertices, node.indices, node.has_uv,
+                        mesh_options);
     }
     mesh->SetColor(node.color);
     if (!node.texture.empty()) {
@@ -282,7 +352,7 @@ void Model::BuildFromNode(const internal::sdf_loader::SdfNode& node,
 
   for (const auto& child : node.children) {
     auto child_model = std::make_shared<Model>();
-    child_model->BuildFromNode(child, true);
+    child_model->BuildFromNode(child, true, options);
     AddOwned(child_model);
   }
 }
@@ -9,11 +9,12 @@ Text::Text(Params params)
       font_(std::move(params.font)),
       facing_mode_(params.facing_mode),
       depth_mode_(params.depth_mode),
-      align_(params.align) {}
+      align_(params.align),
+      priority_(params.priority) {}
 
 void Text::OnDraw(Renderer& renderer) {
   renderer.SubmitText(text_, global_mtx_, params_.color, font_, height_,
-                      facing_mode_, depth_mode_, align_);
+                      facing_mode_, depth_mode_, align_, priority_);
 }
 
 Text* Text::SetText(const std::string& text) {
@@ -46,4 +47,9 @@ Text* Text::SetAlign(TextAlign align) {
   return this;
 }
 
+Text* Text::SetPriority(int priority) {
+  priority_ = priority;
+  return this;
+}
+
 }  // namespace livision
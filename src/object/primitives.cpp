@@ -256,7 +256,10 @@ Sphere::Sphere(Params params) : ObjectBase(std::move(params)) {
           indices.swap(new_indices);
         }
 
-        return std::make_shared<MeshBuffer>(vertices, indices);
+        // An icosphere is meant to look round.
+        return std::make_shared<MeshBuffer>(
+            vertices, indices, false,
+            MeshBufferOptions{.normals = MeshNormals::Smooth});
       });
 }
 
@@ -1,15 +1,21 @@
 #include "livision/internal/sdf_loader.hpp"
 
 #include <Eigen/Geometry>
+#include <algorithm>
 #include <cctype>
+#include <cstdint>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <sstream>
 #include <string_view>
+#include <type_traits>
 #include <unordered_map>
 
+#include "livision/internal/mesh_edges.hpp"
+#include "livision/internal/mesh_optimizer.hpp"
+
 #ifdef LIVISION_ENABLE_SDF
 #include <assimp/config.h>
 #include <assimp/material.h>
@@ -110,6 +116,40 @@ std::vector<fs::path> CollectResourceRoots(const fs::path& sdf_dir) {
 }
 
 #ifdef LIVISION_ENABLE_SDF
+// Per-user directory for downloaded and optimized meshes:
+// $XDG_CACHE_HOME/livision/mesh_cache, falling back to ~/.cache and then
+// %LOCALAPPDATA%. A shared location such as the temp directory would let
+// other users plant files that get loaded as geometry. Empty when no
+// private location is available; callers then skip caching.
+fs::path MeshCacheDir() {
+  fs::path root;
+  if (const char* xdg = std::getenv("XDG_CACHE_HOME");
+      xdg && fs::path(xdg).is_absolute()) {
+    root = xdg;
+  } else if (const char* home = std::getenv("HOME"); home && *home) {
+    root = fs::path(home) / ".cache";
+  } else if (const char* local = std::getenv("LOCALAPPDATA");
+             local && *local) {
+    root = local;
+  } else {
+    return {};
+  }
+  const fs::path app_dir = root / "livision";
+  const fs::path cache_dir = app_dir / "mesh_cache";
+  std::error_code ec;
+  fs::create_directories(cache_dir, ec);
+  if (ec) {
+    return {};
+  }
+  for (const fs::path& dir : {app_dir, cache_dir}) {
+    fs::permissions(dir, fs::perms::owner_all, fs::perm_options::replace, ec);
+    if (ec) {
+      return {};
+    }
+  }
+  return cache_dir;
+}
+
 size_t CurlWriteToFile(void* contents, size_t size, size_t nmemb, void* userp) {
   std::ofstream* stream = static_cast<std::ofstream*>(userp);
   if (!stream || !stream->good()) {
@@ -123,13 +163,11 @@ size_t CurlWriteToFile(void* contents, size_t size, size_t nmemb, void* userp) {
 
 std::string DownloadMeshToCache(const std::string& uri,
                                 std::string* error_message) {
-  fs::path cache_dir = fs::temp_directory_path() / "livision_mesh_cache";
+  const fs::path cache_dir = MeshCacheDir();
   std::error_code ec;
-  fs::create_directories(cache_dir, ec);
-  if (ec) {
+  if (cache_dir.empty()) {
     if (error_message) {
-      *error_message =
-          "Failed to create mesh cache directory: " + cache_dir.string();
+      *error_message = "No per-user mesh cache directory for download: " + uri;
     }
     return {};
   }
@@ -516,6 +554,8 @@ bool HasExplicitSdfMaterialColor(const sdf::Material* material) {
 struct AssimpMeshData {
   std::vector<Vertex> vertices;
   std::vector<uint32_t> indices;
+  // Filled by the MeshLoadOptions overload of LoadAssimpMeshes.
+  std::vector<uint32_t> wire_indices;
   bool has_uv = false;
   std::string texture_uri;
   bool has_color = false;
@@ -642,8 +682,259 @@ bool LoadAssimpMeshes(const std::string& mesh_source,
   return !meshes.empty();
 }
 
+// On-disk cache for optimized meshes, stored next to downloaded meshes in
+// MeshCacheDir. Bump kOptimizedCacheVersion when the layout or the optimizer
+// output changes.
+constexpr uint32_t kOptimizedCacheMagic = 0x434D564CU;  // "LVMC"
+constexpr uint32_t kOptimizedCacheVersion = 2;
+// Optimized entries beyond this total are pruned, least recently used first.
+constexpr std::uintmax_t kOptimizedCacheMaxBytes = std::uintmax_t{1} << 30U;
+constexpr const char* kOptimizedCacheExtension = ".lvmesh";
+static_assert(std::is_trivially_copyable_v<Vertex>);
+
+fs::path OptimizedCachePath(const std::string& mesh_source) {
+  std::error_code ec;
+  const auto file_size = fs::file_size(mesh_source, ec);
+  if (ec) {
+    return {};
+  }
+  const auto mtime = fs::last_write_time(mesh_source, ec);
+  if (ec) {
+    return {};
+  }
+  fs::path source = fs::weakly_canonical(fs::path(mesh_source), ec);
+  if (ec) {
+    source = mesh_source;
+  }
+  const fs::path cache_dir = MeshCacheDir();
+  if (cache_dir.empty()) {
+    return {};
+  }
+
+  std::ostringstream key;
+  key << source.string() << '|' << file_size << '|'
+      << mtime.time_since_epoch().count() << '|' << kOptimizedCacheVersion;
+  const size_t key_hash = std::hash<std::string>{}(key.str());
+  return cache_dir / (std::to_string(key_hash) + kOptimizedCacheExtension);
+}
+
+// Drop the least recently used optimized entries until the total fits
+// kOptimizedCacheMaxBytes. Hits refresh the modification time, and a
+// changed source gets a new key, so this is what removes outdated entries.
+void PruneOptimizedCache(const fs::path& cache_dir) {
+  struct Entry {
+    fs::path path;
+    fs::file_time_type time;
+    std::uintmax_t size;
+  };
+  std::vector<Entry> entries;
+  std::uintmax_t total = 0;
+  std::error_code ec;
+  for (const auto& item : fs::directory_iterator(cache_dir, ec)) {
+    if (item.path().extension() != kOptimizedCacheExtension ||
+        !item.is_regular_file(ec)) {
+      continue;
+    }
+    const std::uintmax_t size = item.file_size(ec);
+    const fs::file_time_type time = item.last_write_time(ec);
+    if (ec) {
+      continue;
+    }
+    entries.push_back({item.path(), time, size});
+    total += size;
+  }
+  if (total <= kOptimizedCacheMaxBytes) {
+    return;
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) { return a.time < b.time; });
+  for (const Entry& entry : entries) {
+    if (total <= kOptimizedCacheMaxBytes) {
+      break;
+    }
+    if (fs::remove(entry.path, ec)) {
+      total -= entry.size;
+    }
+  }
+}
+
+template <typename T>
+void WritePod(std::ostream& out, const T& value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool ReadPod(std::istream& in, T& value) {
+  in.read(reinterpret_cast<char*>(&value), sizeof(T));
+  return in.good();
+}
+
+template <typename Range>
+void WriteArray(std::ostream& out, const Range& data) {
+  const auto count = static_cast<uint64_t>(data.size());
+  WritePod(out, count);
+  out.write(reinterpret_cast<const char*>(data.data()),
+            static_cast<std::streamsize>(count * sizeof(data[0])));
+}
+
+// Bytes between the read position and end, or -1 on a stream error.
+std::streamoff BytesLeft(std::istream& in, std::streamoff end) {
+  const std::streamoff pos = in.tellg();
+  return pos < 0 || pos > end ? -1 : end - pos;
+}
+
+// Counts larger than what is left of the file are rejected, so a corrupt
+// or foreign cache never turns into a huge allocation.
+template <typename Range>
+bool ReadArray(std::istream& in, std::streamoff end, Range& data) {
+  uint64_t count = 0;
+  if (!ReadPod(in, count)) {
+    return false;
+  }
+  const std::streamoff left = BytesLeft(in, end);
+  if (left < 0 || count > static_cast<uint64_t>(left) / sizeof(data[0])) {
+    return false;
+  }
+  data.resize(static_cast<size_t>(count));
+  in.read(reinterpret_cast<char*>(data.data()),
+          static_cast<std::streamsize>(count * sizeof(data[0])));
+  return in.good();
+}
+
+// Every index must refer to a vertex and complete its primitive.
+bool IndicesValid(const std::vector<uint32_t>& indices, std::size_t vertices,
+                  std::size_t per_primitive) {
+  return indices.size() % per_primitive == 0 &&
+         std::ranges::all_of(indices,
+                             [&](uint32_t index) { return index < vertices; });
+}
+
+bool ReadOptimizedCache(const fs::path& path,
+                        std::vector<AssimpMeshData>& meshes) {
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in) {
+    return false;
+  }
+  const std::streamoff end = in.tellg();
+  in.seekg(0);
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  uint32_t mesh_count = 0;
+  if (!ReadPod(in, magic) || magic != kOptimizedCacheMagic ||
+      !ReadPod(in, version) || version != kOptimizedCacheVersion ||
+      !ReadPod(in, mesh_count)) {
+    return false;
+  }
+  // Flags, color and four array counts.
+  constexpr std::size_t kMinMeshBytes =
+      sizeof(uint8_t) + sizeof(Color::base) + (4 * sizeof(uint64_t));
+  const std::streamoff left = BytesLeft(in, end);
+  if (left < 0 || mesh_count > static_cast<uint64_t>(left) / kMinMeshBytes) {
+    return false;
+  }
+
+  std::vector<AssimpMeshData> loaded(mesh_count);
+  for (auto& mesh : loaded) {
+    uint8_t flags = 0;
+    if (!ReadPod(in, flags) || !ReadPod(in, mesh.color.base) ||
+        !ReadArray(in, end, mesh.texture_uri) ||
+        !ReadArray(in, end, mesh.vertices) ||
+        !ReadArray(in, end, mesh.indices) ||
+        !ReadArray(in, end, mesh.wire_indices) ||
+        !IndicesValid(mesh.indices, mesh.vertices.size(), 3) ||
+        !IndicesValid(mesh.wire_indices, mesh.vertices.size(), 2)) {
+      return false;
+    }
+    mesh.has_uv = (flags & 1U) != 0U;
+    mesh.has_color = (flags & 2U) != 0U;
+  }
+  meshes = std::move(loaded);
+  return true;
+}
+
+void WriteOptimizedCache(const fs::path& path,
+                         const std::vector<AssimpMeshData>& meshes) {
+  std::error_code ec;
+  fs::create_directories(path.parent_path(), ec);
+  const fs::path tmp_path = path.string() + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      return;
+    }
+    WritePod(out, kOptimizedCacheMagic);
+    WritePod(out, kOptimizedCacheVersion);
+    WritePod(out, static_cast<uint32_t>(meshes.size()));
+    for (const auto& mesh : meshes) {
+      const uint8_t flags =
+          (mesh.has_uv ? 1U : 0U) | (mesh.has_color ? 2U : 0U);
+      WritePod(out, flags);
+      WritePod(out, mesh.color.base);
+      WriteArray(out, mesh.texture_uri);
+      WriteArray(out, mesh.vertices);
+      WriteArray(out, mesh.indices);
+      WriteArray(out, mesh.wire_indices);
+    }
+    if (!out.good()) {
+      out.close();
+      fs::remove(tmp_path, ec);
+      return;
+    }
+  }
+  // Publish atomically so a concurrent reader never sees a partial file.
+  fs::rename(tmp_path, path, ec);
+  if (ec) {
+    fs::remove(tmp_path, ec);
+    return;
+  }
+  PruneOptimizedCache(path.parent_path());
+}
+
+// LoadAssimpMeshes with wireframe edges and the optional optimization pass.
+// Optimized results are served from (and written to) the on-disk cache; a
+// cache failure only costs the optimization time.
+bool LoadAssimpMeshes(const std::string& mesh_source,
+                      std::vector<AssimpMeshData>& meshes,
+                      const MeshLoadOptions& options,
+                      std::string* error_message) {
+  if (!options.optimize) {
+    if (!LoadAssimpMeshes(mesh_source, meshes, error_message)) {
+      return false;
+    }
+    // Extracted on the loading thread so the first wireframe draw does not
+    // stall the render thread.
+    for (auto& mesh : meshes) {
+      mesh.wire_indices = mesh_edges::ExtractEdges(mesh.indices);
+    }
+    return true;
+  }
+
+  const fs::path cache_path = OptimizedCachePath(mesh_source);
+  if (!cache_path.empty() && ReadOptimizedCache(cache_path, meshes) &&
+      !meshes.empty()) {
+    // Mark the entry as recently used for PruneOptimizedCache.
+    std::error_code ec;
+    fs::last_write_time(cache_path, fs::file_time_type::clock::now(), ec);
+    return true;
+  }
+
+  if (!LoadAssimpMeshes(mesh_source, meshes, error_message)) {
+    return false;
+  }
+  // Edges are stored in the cache with the optimized mesh.
+  for (auto& mesh : meshes) {
+    mesh_optimizer::OptimizeMesh(mesh.vertices, mesh.indices);
+    mesh.wire_indices = mesh_edges::ExtractEdges(mesh.indices);
+  }
+  if (!cache_path.empty()) {
+    WriteOptimizedCache(cache_path, meshes);
+  }
+  return true;
+}
+
 bool BuildVisualNode(const sdf::Visual& visual, const fs::path& sdf_dir,
-                     SdfNode& node, std::string* error_message,
+                     const MeshLoadOptions& options, SdfNode& node,
+                     std::string* error_message,
                      bool& any_mesh_loaded,
                      std::unordered_map<std::string, std::size_t>& counters) {
   SetNodeIdentity(node, "visual", visual.Name(), &counters);
@@ -761,7 +1052,7 @@ bool BuildVisualNode(const sdf::Visual& visual, const fs::path& sdf_dir,
 
   std::string assimp_error;
   std::vector<AssimpMeshData> assimp_meshes;
-  if (!LoadAssimpMeshes(resolved, assimp_meshes, &assimp_error)) {
+  if (!LoadAssimpMeshes(resolved, assimp_meshes, options, &assimp_error)) {
     if (error_message) {
       *error_message = assimp_error;
     }
@@ -774,6 +1065,7 @@ bool BuildVisualNode(const sdf::Visual& visual, const fs::path& sdf_dir,
     SetNodeIdentity(mesh_node, "mesh", "", &mesh_counters);
     mesh_node.vertices = std::move(mesh_data.vertices);
     mesh_node.indices = std::move(mesh_data.indices);
+    mesh_node.wire_indices = std::move(mesh_data.wire_indices);
     mesh_node.has_uv = mesh_data.has_uv;
     mesh_node.texture = mesh_data.texture_uri;
     if (prefer_sdf_material_color) {
@@ -791,7 +1083,8 @@ bool BuildVisualNode(const sdf::Visual& visual, const fs::path& sdf_dir,
 }
 
 bool BuildLinkNode(const sdf::Link& link, const fs::path& sdf_dir,
-                   SdfNode& node, std::string* error_message,
+                   const MeshLoadOptions& options, SdfNode& node,
+                   std::string* error_message,
                    bool& any_mesh_loaded,
                    std::unordered_map<std::string, std::size_t>& counters) {
   SetNodeIdentity(node, "link", link.Name(), &counters);
@@ -805,8 +1098,8 @@ bool BuildLinkNode(const sdf::Link& link, const fs::path& sdf_dir,
       continue;
     }
     SdfNode visual_node;
-    if (BuildVisualNode(*visual, sdf_dir, visual_node, error_message,
-                        any_mesh_loaded, child_counters)) {
+    if (BuildVisualNode(*visual, sdf_dir, options, visual_node,
+                        error_message, any_mesh_loaded, child_counters)) {
       node.children.push_back(std::move(visual_node));
     }
   }
@@ -815,7 +1108,8 @@ bool BuildLinkNode(const sdf::Link& link, const fs::path& sdf_dir,
 }
 
 bool BuildModelNode(const sdf::Model& model, const fs::path& sdf_dir,
-                    SdfNode& node, std::string* error_message,
+                    const MeshLoadOptions& options, SdfNode& node,
+                    std::string* error_message,
                     bool& any_mesh_loaded,
                     std::unordered_map<std::string, std::size_t>& counters) {
   SetNodeIdentity(node, "model", model.Name(), &counters);
@@ -829,7 +1123,7 @@ bool BuildModelNode(const sdf::Model& model, const fs::path& sdf_dir,
       continue;
     }
     SdfNode link_node;
-    if (BuildLinkNode(*link, sdf_dir, link_node, error_message,
+    if (BuildLinkNode(*link, sdf_dir, options, link_node, error_message,
                       any_mesh_loaded, child_counters)) {
       node.children.push_back(std::move(link_node));
     }
@@ -841,7 +1135,7 @@ bool BuildModelNode(const sdf::Model& model, const fs::path& sdf_dir,
       continue;
     }
     SdfNode nested_node;
-    if (BuildModelNode(*nested, sdf_dir, nested_node, error_message,
+    if (BuildModelNode(*nested, sdf_dir, options, nested_node, error_message,
                        any_mesh_loaded, child_counters)) {
       node.children.push_back(std::move(nested_node));
     }
@@ -1091,6 +1385,7 @@ bool LoadMeshFile(const std::string& mesh_path, std::vector<Vertex>& vertices,
 
 bool LoadMeshFileParts(const std::string& mesh_path,
                        std::vector<MeshPart>& parts,
+                       const MeshLoadOptions& options,
                        std::string* error_message) {
 #ifndef LIVISION_ENABLE_SDF
   if (error_message) {
@@ -1100,11 +1395,12 @@ bool LoadMeshFileParts(const std::string& mesh_path,
   }
   (void)mesh_path;
   (void)parts;
+  (void)options;
   return false;
 #else
   std::vector<AssimpMeshData> assimp_meshes;
   std::string assimp_error;
-  if (!LoadAssimpMeshes(mesh_path, assimp_meshes, &assimp_error)) {
+  if (!LoadAssimpMeshes(mesh_path, assimp_meshes, options, &assimp_error)) {
     if (error_message) {
       *error_message = assimp_error;
     }
@@ -1117,6 +1413,7 @@ bool LoadMeshFileParts(const std::string& mesh_path,
     MeshPart part;
     part.vertices = std::move(src.vertices);
     part.indices = std::move(src.indices);
+    part.wire_indices = std::move(src.wire_indices);
     part.has_uv = src.has_uv;
     part.texture_uri = std::move(src.texture_uri);
     part.has_color = src.has_color;
@@ -1130,6 +1427,7 @@ bool LoadMeshFileParts(const std::string& mesh_path,
 }
 
 bool LoadSdfScene(const std::string& sdf_path, SdfNode& root,
+                  const MeshLoadOptions& options,
                   std::string* error_message) {
 #ifndef LIVISION_ENABLE_SDF
   if (error_message) {
@@ -1138,6 +1436,7 @@ bool LoadSdfScene(const std::string& sdf_path, SdfNode& root,
   }
   (void)sdf_path;
   (void)root;
+  (void)options;
   return false;
 #else
   const fs::path sdf_file(sdf_path);
@@ -1180,7 +1479,7 @@ bool LoadSdfScene(const std::string& sdf_path, SdfNode& root,
     world_node.scale = Eigen::Vector3d::Ones();
     std::unordered_map<std::string, std::size_t> child_counters;
     SdfNode model_node;
-    if (BuildModelNode(*model, sdf_dir, model_node, error_message,
+    if (BuildModelNode(*model, sdf_dir, options, model_node, error_message,
                        any_mesh_loaded, child_counters)) {
       world_node.children.push_back(std::move(model_node));
     }
@@ -1205,8 +1504,8 @@ bool LoadSdfScene(const std::string& sdf_path, SdfNode& root,
       }
       any_model_found = true;
       SdfNode model_node;
-      if (BuildModelNode(*model, sdf_dir, model_node, error_message,
-                         any_mesh_loaded, child_counters)) {
+      if (BuildModelNode(*model, sdf_dir, options, model_node,
+                         error_message, any_mesh_loaded, child_counters)) {
         world_node.children.push_back(std::move(model_node));
       }
     }
@@ -0,0 +1,119 @@
+#include "livision/internal/shader_variants.hpp"
+
+#include <cstddef>
+#include <unordered_set>
+#include <utility>
+
+#include "livision/Log.hpp"
+
+namespace livision::internal {
+
+namespace {
+// Lower-case define names in bit order, as appended to binary names.
+constexpr const char* kFeatureNames[kShaderFeatureCount] = {
+    "rainbow", "lit_flat", "per_vertex"};
+
+struct FamilyInfo {
+  const char* vs;
+  uint32_t vs_features;  // Features the vertex shader is compiled with
+  const char* fs;
+  uint32_t fs_features;
+};
+
+// Indexed by ShaderFamily; must match the variants in compile_shaders.sh.
+constexpr FamilyInfo kFamilies[] = {
+    {"v_simple", 0, "f_simple", kShaderRainbow | kShaderLitFlat},
+    {"v_textured", 0, "f_textured", kShaderRainbow},
+    {"v_points", 0, "f_points", kShaderRainbow},
+    {"v_lit", kShaderPerVertex, "f_lit", kShaderRainbow | kShaderPerVertex},
+};
+
+const FamilyInfo& Info(ShaderFamily family) {
+  return kFamilies[static_cast<std::size_t>(family)];
+}
+}  // namespace
+
+std::string ShaderVariantName(std::string_view base, uint32_t features) {
+  std::string name(base);
+  for (uint32_t bit = 0; bit < kShaderFeatureCount; ++bit) {
+    if ((features & (1U << bit)) != 0) {
+      name += '_';
+      name += kFeatureNames[bit];
+    }
+  }
+  return name;
+}
+
+ShaderVariantCache::~ShaderVariantCache() { Clear(); }
+
+void ShaderVariantCache::SetLoader(Loader loader) {
+  loader_ = std::move(loader);
+}
+
+uint32_t ShaderVariantCache::Supported(ShaderFamily family) {
+  const FamilyInfo& info = Info(family);
+  return info.vs_features | info.fs_features;
+}
+
+bgfx::ProgramHandle ShaderVariantCache::Get(ShaderFamily family,
+                                            uint32_t features) {
+  features &= Supported(family);
+  const uint32_t key = (static_cast<uint32_t>(family) << 16U) | features;
+  if (const auto it = programs_.find(key); it != programs_.end()) {
+    return it->second;
+  }
+  bgfx::ProgramHandle program = Load(family, features);
+  if (!bgfx::isValid(program) && features != 0) {
+    LogMessage(LogLevel::Warn,
+               "Shader variant not found, using the base variant: ",
+               ShaderVariantName(Info(family).fs, features));
+    program = Get(family, 0);
+  }
+  programs_.emplace(key, program);
+  return program;
+}
+
+bgfx::ShaderHandle ShaderVariantCache::Shader(const std::string& name) {
+  if (const auto it = shaders_.find(name); it != shaders_.end()) {
+    return it->second;
+  }
+  bgfx::ShaderHandle shader = BGFX_INVALID_HANDLE;
+  if (loader_) {
+    shader = loader_(name);
+  }
+  shaders_.emplace(name, shader);
+  return shader;
+}
+
+bgfx::ProgramHandle ShaderVariantCache::Load(ShaderFamily family,
+                                             uint32_t features) {
+  const FamilyInfo& info = Info(family);
+  // Variants differing only in fragment features share the vertex shader.
+  const bgfx::ShaderHandle vsh =
+      Shader(ShaderVariantName(info.vs, features & info.vs_features));
+  const bgfx::ShaderHandle fsh =
+      Shader(ShaderVariantName(info.fs, features & info.fs_features));
+  if (!bgfx::isValid(vsh) || !bgfx::isValid(fsh)) {
+    return BGFX_INVALID_HANDLE;
+  }
+  return bgfx::createProgram(vsh, fsh);
+}
+
+void ShaderVariantCache::Clear() {
+  // Fallback entries alias the base program; destroy each handle once.
+  std::unordered_set<uint16_t> destroyed;
+  for (const auto& [_, program] : programs_) {
+    if (bgfx::isValid(program) && destroyed.insert(program.idx).second) {
+      bgfx::destroy(program);
+    }
+  }
+  programs_.clear();
+  for (const auto& [_, shader] : shaders_) {
+    if (bgfx::isValid(shader)) {
+      bgfx::destroy(shader);
+    }
+  }
+  shaders_.clear();
+}
+
+}  // namespace livision::internal
@@ -0,0 +1,342 @@
+#include "livision/internal/texture_loader.hpp"
+
+#include <bgfx/defines.h>
+#include <bimg/decode.h>
+#include <bx/allocator.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+
+#include "livision/Log.hpp"
+#include "livision/internal/file_ops.hpp"
+#include "livision/internal/thread_pool.hpp"
+
+namespace livision::internal {
+
+namespace {
+constexpr std::size_t kMaxDecodeThreads = 4;
+
+using FormatCaps = std::array<uint16_t, bgfx::TextureFormat::Count>;
+
+bx::AllocatorI* ImageAllocator() {
+  static bx::DefaultAllocator allocator;
+  return &allocator;
+}
+
+uint64_t TextureFlags(bool srgb) {
+  uint64_t flags = BGFX_TEXTURE_NONE | BGFX_SAMPLER_MIN_ANISOTROPIC |
+                   BGFX_SAMPLER_MAG_ANISOTROPIC;
+  if (srgb) {
+    flags |= BGFX_TEXTURE_SRGB;
+  }
+  return flags;
+}
+
+bool IsSupported(const FormatCaps& caps, const bimg::ImageContainer& image,
+                 bool srgb) {
+  const auto format = static_cast<std::size_t>(image.m_format);
+  if (format >= caps.size() || image.m_cubeMap) {
+    return false;
+  }
+  const uint16_t needed =
+      srgb ? BGFX_CAPS_FORMAT_TEXTURE_2D_SRGB : BGFX_CAPS_FORMAT_TEXTURE_2D;
+  return (caps[format] & needed) != 0U;
+}
+
+float SrgbToLinear(uint8_t value) {
+  const float c = static_cast<float>(value) / 255.0F;
+  return c <= 0.04045F ? c / 12.92F : std::pow((c + 0.055F) / 1.055F, 2.4F);
+}
+
+uint8_t LinearToSrgb(float value) {
+  const float c = value <= 0.0031308F
+                      ? value * 12.92F
+                      : (1.055F * std::pow(value, 1.0F / 2.4F)) - 0.055F;
+  return static_cast<uint8_t>(std::clamp(c, 0.0F, 1.0F) * 255.0F + 0.5F);
+}
+
+// 2x2 box filter of an RGBA8 level. Odd edges reuse the last row/column.
+// sRGB color channels are averaged in linear space.
+void DownsampleRgba8(const uint8_t* src, uint32_t src_w, uint32_t src_h,
+                     uint8_t* dst, uint32_t dst_w, uint32_t dst_h, bool srgb,
+                     const std::array<float, 256>& to_linear) {
+  for (uint32_t y = 0; y < dst_h; ++y) {
+    const uint32_t y0 = std::min(y * 2, src_h - 1);
+    const uint32_t y1 = std::min((y * 2) + 1, src_h - 1);
+    for (uint32_t x = 0; x < dst_w; ++x) {
+      const uint32_t x0 = std::min(x * 2, src_w - 1);
+      const uint32_t x1 = std::min((x * 2) + 1, src_w - 1);
+      const uint8_t* texels[4] = {
+          src + (((y0 * src_w) + x0) * 4), src + (((y0 * src_w) + x1) * 4),
+          src + (((y1 * src_w) + x0) * 4), src + (((y1 * src_w) + x1) * 4)};
+      uint8_t* out = dst + (((y * dst_w) + x) * 4);
+      for (uint32_t c = 0; c < 4; ++c) {
+        if (srgb && c < 3) {
+          float sum = 0.0F;
+          for (const uint8_t* t : texels) {
+            sum += to_linear[t[c]];
+          }
+          out[c] = LinearToSrgb(sum * 0.25F);
+        } else {
+          uint32_t sum = 2;
+          for (const uint8_t* t : texels) {
+            sum += t[c];
+          }
+          out[c] = static_cast<uint8_t>(sum / 4);
+        }
+      }
+    }
+  }
+}
+
+// Adds a full mip chain to single-level RGBA8 images so minified textures
+// sample a small level instead of the full-size one. Other images are
+// returned unchanged.
+bimg::ImageContainer* WithMipChain(bimg::ImageContainer* image, bool srgb) {
+  const uint32_t width = image->m_width;
+  const uint32_t height = image->m_height;
+  if (image->m_format != bimg::TextureFormat::RGBA8 || image->m_numMips > 1 ||
+      image->m_numLayers != 1 || image->m_cubeMap || image->m_depth > 1 ||
+      (width <= 1 && height <= 1)) {
+    return image;
+  }
+
+  bimg::ImageContainer* mipped = bimg::imageAlloc(
+      ImageAllocator(), bimg::TextureFormat::RGBA8,
+      static_cast<uint16_t>(width), static_cast<uint16_t>(height), 1, 1, false,
+      true);
+  if (!mipped) {
+    return image;
+  }
+
+  // Levels are stored back to back; bail out if bimg laid them out otherwise.
+  uint64_t expected_size = 0;
+  for (uint32_t level = 0; level < mipped->m_numMips; ++level) {
+    expected_size += static_cast<uint64_t>(std::max(1U, width >> level)) *
+                     std::max(1U, height >> level) * 4;
+  }
+  if (expected_size != mipped->m_size) {
+    bimg::imageFree(mipped);
+    return image;
+  }
+
+  static const std::array<float, 256> to_linear = [] {
+    std::array<float, 256> table{};
+    for (uint32_t i = 0; i < table.size(); ++i) {
+      table[i] = SrgbToLinear(static_cast<uint8_t>(i));
+    }
+    return table;
+  }();
+
+  auto* level_data = static_cast<uint8_t*>(mipped->m_data);
+  std::memcpy(level_data, image->m_data,
+              static_cast<std::size_t>(width) * height * 4);
+  bimg::imageFree(image);
+  uint32_t level_w = width;
+  uint32_t level_h = height;
+  for (uint32_t level = 1; level < mipped->m_numMips; ++level) {
+    const uint32_t next_w = std::max(1U, level_w / 2);
+    const uint32_t next_h = std::max(1U, level_h / 2);
+    uint8_t* next_data =
+        level_data + (static_cast<std::size_t>(level_w) * level_h * 4);
+    DownsampleRgba8(level_data, level_w, level_h, next_data, next_w, next_h,
+                    srgb, to_linear);
+    level_data = next_data;
+    level_w = next_w;
+    level_h = next_h;
+  }
+  return mipped;
+}
+
+bimg::ImageContainer* ParseFile(const std::string& path) {
+  std::string texture_file;
+  if (!file_ops::ReadFile(path, texture_file)) {
+    return nullptr;
+  }
+  return bimg::imageParse(ImageAllocator(),
+                          reinterpret_cast<const void*>(texture_file.data()),
+                          static_cast<uint32_t>(texture_file.size()));
+}
+
+// Pre-compressed sibling (e.g. tex.ktx next to tex.png, as written by
+// scripts/compress_textures.sh) whose format the GPU samples directly.
+bimg::ImageContainer* LoadCompressedSibling(const std::string& path,
+                                            bool srgb,
+                                            const FormatCaps& caps) {
+  const std::filesystem::path source(path);
+  const std::string ext = source.extension().string();
+  if (ext == ".ktx" || ext == ".dds") {
+    return nullptr;
+  }
+  for (const char* sibling_ext : {".ktx", ".dds"}) {
+    std::filesystem::path sibling = source;
+    sibling.replace_extension(sibling_ext);
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(sibling, ec)) {
+      continue;
+    }
+    bimg::ImageContainer* image = ParseFile(sibling.string());
+    if (image && IsSupported(caps, *image, srgb)) {
+      return image;
+    }
+    if (image) {
+      bimg::imageFree(image);
+    }
+  }
+  return nullptr;
+}
+
+// Worker side: read, parse and, for formats the GPU cannot sample, convert
+// to RGBA8. Returns nullptr and fills error on failure.
+bimg::ImageContainer* DecodeImage(const std::string& path, bool srgb,
+                                  const FormatCaps& caps, std::string& error) {
+  // Compressed containers already carry their mips; upload them as is.
+  if (bimg::ImageContainer* compressed =
+          LoadCompressedSibling(path, srgb, caps)) {
+    return compressed;
+  }
+
+  std::string texture_file;
+  if (!file_ops::ReadFile(path, texture_file)) {
+    error = "Failed to read texture: ";
+    return nullptr;
+  }
+
+  bimg::ImageContainer* image = bimg::imageParse(
+      ImageAllocator(), reinterpret_cast<const void*>(texture_file.data()),
+      static_cast<uint32_t>(texture_file.size()));
+  if (!image) {
+    error = "Failed to decode texture: ";
+    return nullptr;
+  }
+  if (IsSupported(caps, *image, srgb)) {
+    return WithMipChain(image, srgb);
+  }
+
+  // Fallback: convert unsupported source format (e.g. RGB8 PNG, or BC7 on a
+  // GPU without BC support) to RGBA8.
+  bimg::ImageContainer* converted = bimg::imageConvert(
+      ImageAllocator(), bimg::TextureFormat::RGBA8, *image, true);
+  bimg::imageFree(image);
+  if (!converted) {
+    error = "Failed to create texture: ";
+    return nullptr;
+  }
+  return WithMipChain(converted, srgb);
+}
+
+struct DecodedTexture {
+  std::string path;
+  bool srgb = false;
+  bimg::ImageContainer* image = nullptr;
+  std::string error;
+};
+}  // namespace
+
+struct TextureLoader::Impl {
+  FormatCaps format_caps{};
+  std::unique_ptr<ThreadPool> pool;
+  std::mutex mutex;
+  std::deque<DecodedTexture> ready;
+
+  void DropReady() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& decoded : ready) {
+      if (decoded.image) {
+        bimg::imageFree(decoded.image);
+      }
+    }
+    ready.clear();
+  }
+};
+
+TextureLoader::TextureLoader() : pimpl_(std::make_unique<Impl>()) {}
+
+TextureLoader::~TextureLoader() { Shutdown(); }
+
+void TextureLoader::Init() {
+  const bgfx::Caps* caps = bgfx::getCaps();
+  for (std::size_t i = 0; i < pimpl_->format_caps.size(); ++i) {
+    pimpl_->format_caps[i] = caps->formats[i];
+  }
+  if (!pimpl_->pool) {
+    pimpl_->pool = std::make_unique<ThreadPool>(
+        ThreadPool::DefaultThreadCount(kMaxDecodeThreads));
+  }
+}
+
+void TextureLoader::Shutdown() {
+  // Joins running decodes, so nothing touches `ready` afterwards.
+  pimpl_->pool.reset();
+  pimpl_->DropReady();
+}
+
+void TextureLoader::Request(const std::string& path, bool srgb) {
+  if (!pimpl_->pool) {
+    return;
+  }
+  Impl* impl = pimpl_.get();
+  pimpl_->pool->Submit([impl, path, srgb]() {
+    DecodedTexture decoded;
+    decoded.path = path;
+    decoded.srgb = srgb;
+    decoded.image = DecodeImage(path, srgb, impl->format_caps, decoded.error);
+    std::lock_guard<std::mutex> lock(impl->mutex);
+    impl->ready.push_back(std::move(decoded));
+  });
+}
+
+void TextureLoader::UploadReady(uint32_t max_uploads,
+                                const ReadyCallback& on_ready) {
+  for (uint32_t uploaded = 0; uploaded < max_uploads; ++uploaded) {
+    DecodedTexture decoded;
+    {
+      std::lock_guard<std::mutex> lock(pimpl_->mutex);
+      if (pimpl_->ready.empty()) {
+        return;
+      }
+      decoded = std::move(pimpl_->ready.front());
+      pimpl_->ready.pop_front();
+    }
+
+    if (!decoded.image) {
+      LogMessage(LogLevel::Error, decoded.error, decoded.path);
+      on_ready(decoded.path, BGFX_INVALID_HANDLE, 0);
+      continue;
+    }
+
+    const bimg::ImageContainer& img = *decoded.image;
+    const auto format = static_cast<bgfx::TextureFormat::Enum>(img.m_format);
+    const uint64_t flags = TextureFlags(decoded.srgb);
+    const uint32_t bytes = img.m_size;
+    bgfx::TextureHandle handle = BGFX_INVALID_HANDLE;
+    if (bgfx::isTextureValid(0, img.m_cubeMap,
+                             static_cast<uint16_t>(img.m_numLayers), format,
+                             flags)) {
+      // bgfx frees the decoded image once the upload has consumed it.
+      const bgfx::Memory* mem = bgfx::makeRef(
+          img.m_data, img.m_size,
+          [](void* /*ptr*/, void* user_data) {
+            bimg::imageFree(static_cast<bimg::ImageContainer*>(user_data));
+          },
+          decoded.image);
+      handle = bgfx::createTexture2D(
+          static_cast<uint16_t>(img.m_width),
+          static_cast<uint16_t>(img.m_height), img.m_numMips > 1,
+          static_cast<uint16_t>(img.m_numLayers), format, flags, mem);
+    } else {
+      bimg::imageFree(decoded.image);
+    }
+    if (!bgfx::isValid(handle)) {
+      LogMessage(LogLevel::Error, "Failed to create texture: ", decoded.path);
+    }
+    on_ready(decoded.path, handle, bgfx::isValid(handle) ? bytes : 0);
+  }
+}
+
+}  // namespace livision::internal
@@ -0,0 +1,133 @@
+#include "livision/internal/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace livision::internal {
+
+namespace {
+struct ParallelForState {
+  struct alignas(64) Slice {
+    std::atomic<std::size_t> next{0};
+    std::size_t end = 0;
+  };
+
+  ParallelForState(std::size_t count, std::size_t participants,
+                   const std::function<void(std::size_t)>& fn)
+      : slices(std::make_unique<Slice[]>(participants)),
+        slice_count(participants),
+        remaining(count),
+        fn(fn) {
+    for (std::size_t p = 0; p < participants; ++p) {
+      slices[p].next = count * p / participants;
+      slices[p].end = count * (p + 1) / participants;
+    }
+  }
+
+  // Drain the participant's own slice, then steal from the others. fn stays
+  // valid while any item is unclaimed, because the caller is still waiting.
+  void Run(std::size_t participant) {
+    for (std::size_t k = 0; k < slice_count; ++k) {
+      Slice& slice = slices[(participant + k) % slice_count];
+      while (true) {
+        const std::size_t i = slice.next.fetch_add(1);
+        if (i >= slice.end) {
+          break;
+        }
+        fn(i);
+        if (remaining.fetch_sub(1) == 1) {
+          std::lock_guard<std::mutex> lock(mutex);
+          done.notify_all();
+        }
+      }
+    }
+  }
+
+  std::unique_ptr<Slice[]> slices;
+  std::size_t slice_count;
+  std::atomic<std::size_t> remaining;
+  std::atomic<std::size_t> next_participant{1};
+  const std::function<void(std::size_t)>& fn;
+  std::mutex mutex;
+  std::condition_variable done;
+};
+}  // namespace
+
+ThreadPool::ThreadPool(std::size_t thread_count) {
+  thread_count = std::max<std::size_t>(thread_count, 1);
+  workers_.reserve(thread_count);
+  for (std::size_t i = 0; i < thread_count; ++i) {
+    workers_.emplace_back([this]() { WorkerLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    tasks_.clear();
+  }
+  cv_.notify_all();
+  for (auto& worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+void ThreadPool::Submit(Task task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) {
+      return;
+    }
+    tasks_.push_back(std::move(task));
+  }
+  cv_.notify_one();
+}
+
+void ThreadPool::ParallelFor(std::size_t count,
+                             const std::function<void(std::size_t)>& fn) {
+  const std::size_t participants = std::min(count, workers_.size() + 1);
+  if (participants <= 1) {
+    for (std::size_t i = 0; i < count; ++i) {
+      fn(i);
+    }
+    return;
+  }
+
+  // Helpers may start after the loop has finished (all workers busy), so
+  // they share ownership of the state instead of borrowing the stack.
+  auto state = std::make_shared<ParallelForState>(count, participants, fn);
+  for (std::size_t p = 1; p < participants; ++p) {
+    Submit([state]() { state->Run(state->next_participant.fetch_add(1)); });
+  }
+  state->Run(0);
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->done.wait(lock, [&state]() { return state->remaining == 0; });
+}
+
+std::size_t ThreadPool::DefaultThreadCount(std::size_t max_threads) {
+  const std::size_t hw = std::thread::hardware_concurrency();
+  const std::size_t available = (hw > 1) ? hw - 1 : 1;
+  return std::clamp<std::size_t>(available, 1, max_threads);
+}
+
+void ThreadPool::WorkerLoop() {
+  while (true) {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+      if (stopping_) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+}  // namespace livision::internal
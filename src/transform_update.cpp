@@ -0,0 +1,32 @@
+#include "livision/internal/transform_update.hpp"
+
+#include <atomic>
+
+namespace livision::internal {
+
+namespace {
+// Below this many siblings the fork costs more than the update itself.
+constexpr std::size_t kMinParallelObjects = 16;
+
+std::atomic<ThreadPool*> g_transform_pool{nullptr};
+}  // namespace
+
+void SetTransformPool(ThreadPool* pool) { g_transform_pool = pool; }
+
+ThreadPool* GetTransformPool() { return g_transform_pool; }
+
+void UpdateMatrices(const std::vector<std::shared_ptr<ObjectBase>>& objects,
+                    const Eigen::Affine3d& parent_mtx) {
+  ThreadPool* pool = g_transform_pool;
+  if (!pool || objects.size() < kMinParallelObjects) {
+    for (const auto& object : objects) {
+      object->UpdateMatrix(parent_mtx);
+    }
+    return;
+  }
+  pool->ParallelFor(objects.size(), [&objects, &parent_mtx](std::size_t i) {
+    objects[i]->UpdateMatrix(parent_mtx);
+  });
+}
+
+}  // namespace livision::internal